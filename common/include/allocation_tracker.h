@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace alloc {
+
+    struct Stats {
+        size_t count{};
+        size_t bytes{};
+        size_t frees{};
+
+        Stats operator-(const Stats& rhs) const {
+            return { count - rhs.count, bytes - rhs.bytes, frees - rhs.frees };
+        }
+
+        Stats& operator+=(const Stats& rhs) {
+            count += rhs.count;
+            bytes += rhs.bytes;
+            frees += rhs.frees;
+            return *this;
+        }
+    };
+
+    // true when global operator new/delete have been replaced (TRACK_ALLOCATIONS build)
+    [[nodiscard]] bool available();
+
+    // counting is opt-in, when disabled the replaced operators only pay for a relaxed load
+    void enable();
+
+    void disable();
+
+    [[nodiscard]] bool enabled();
+
+    // allocations made by the calling thread since tracking was first enabled or the last reset()
+    [[nodiscard]] Stats threadStats();
+
+    // allocations made by all threads since tracking was first enabled or the last reset()
+    [[nodiscard]] Stats globalStats();
+
+    // zeroes the global counters and the counters of every thread, a thread's own are zeroed the
+    // next time it allocates, frees or reads them
+    void reset();
+
+    // accumulated totals of every named Scope that has completed
+    [[nodiscard]] std::map<std::string, Stats> phases();
+
+    void clearPhases();
+
+    // name is not copied, so opening a scope allocates nothing, it has to outlive the scope (a
+    // string literal in practice)
+    class Scope {
+    public:
+        explicit Scope(const char* name, bool record = true);
+
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+
+        Scope& operator=(const Scope&) = delete;
+
+        // allocations made by this thread since the scope was opened
+        [[nodiscard]] Stats stats() const;
+
+        [[nodiscard]] std::string_view name() const {
+            return m_name;
+        }
+
+    private:
+        const char* m_name;
+        Stats m_start;
+        size_t m_generation;
+        bool m_record;
+    };
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "snap.h"
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// typed snapshot visitor writing tagged little endian records:
+//
+//  value:    [Kind::Value][uint16 name length][name][Type][uint8 components][data]
+//  sequence: [Kind::Sequence][uint16 name length][name][Type][uint8 components][uint64 count][data]
+//  object:   [Kind::BeginObject][uint16 name length][name] ... [Kind::EndObject]
+//
+// strings are stored as [uint64 length][chars]. Contiguous sequences are copied with one memcpy per
+// run, chunked ones with one per chunk.
+namespace binary {
+
+    enum class Kind : uint8_t { Value = 0, Sequence, BeginObject, EndObject };
+
+    enum class Type : uint8_t { Bool = 0, Int32, UInt32, Int64, UInt64, Float, Double, String };
+
+    // arithmetic values are widened to the type they are tagged with
+    template<typename T>
+    using Storage =
+            std::conditional_t<std::is_same_v<T, bool>, bool,
+            std::conditional_t<std::is_floating_point_v<T>, std::conditional_t<sizeof(T) == 4, float, double>,
+            std::conditional_t<std::is_signed_v<T>, std::conditional_t<sizeof(T) <= 4, int32_t, int64_t>,
+            std::conditional_t<sizeof(T) <= 4, uint32_t, uint64_t>>>>;
+
+    template<typename T>
+    constexpr Type typeOf() {
+        if constexpr (!std::is_arithmetic_v<T>) return Type::String;
+        else if constexpr (std::is_same_v<Storage<T>, bool>) return Type::Bool;
+        else if constexpr (std::is_same_v<Storage<T>, float>) return Type::Float;
+        else if constexpr (std::is_same_v<Storage<T>, double>) return Type::Double;
+        else if constexpr (std::is_same_v<Storage<T>, int32_t>) return Type::Int32;
+        else if constexpr (std::is_same_v<Storage<T>, int64_t>) return Type::Int64;
+        else if constexpr (std::is_same_v<Storage<T>, uint32_t>) return Type::UInt32;
+        else return Type::UInt64;
+    }
+
+    template<typename T>
+    struct Element {
+        using type = T;
+        static constexpr uint8_t components = 1;
+    };
+
+    template<glm::length_t L, typename T, glm::qualifier Q>
+    struct Element<glm::vec<L, T, Q>> {
+        using type = T;
+        static constexpr uint8_t components = L;
+    };
+
+    class Writer {
+    public:
+        explicit Writer(std::vector<char>& out)
+        : m_out(out)
+        {}
+
+        template<snap::Value T>
+        void value(std::string_view name, const T& value) {
+            header(Kind::Value, name);
+            type<T>();
+            write(value);
+        }
+
+        template<typename T>
+        void sequence(std::string_view name, snap::Sequence<T> values) {
+            header(Kind::Sequence, name);
+            type<T>();
+            append(static_cast<uint64_t>(values.size()));
+            using E = typename Element<T>::type;
+            if constexpr (std::is_arithmetic_v<E> && std::is_same_v<Storage<E>, E> && sizeof(T) == sizeof(E) * Element<T>::components) {
+                if(values.contiguous()) {
+                    values.forEachSpan([&](std::span<const T> run){
+                        const auto offset = m_out.size();
+                        m_out.resize(offset + run.size_bytes());
+                        std::memcpy(m_out.data() + offset, run.data(), run.size_bytes());
+                    });
+                    return;
+                }
+            }
+            for(auto i = 0u; i < values.size(); i++){
+                write(values[i]);
+            }
+        }
+
+        template<typename T>
+        void object(std::string_view name, const T& object) {
+            header(Kind::BeginObject, name);
+            snap::describe(*this, object);
+            append(Kind::EndObject);
+        }
+
+    private:
+        void header(Kind kind, std::string_view name) {
+            append(kind);
+            append(static_cast<uint16_t>(name.size()));
+            m_out.insert(m_out.end(), name.begin(), name.end());
+        }
+
+        template<typename T>
+        void type() {
+            using E = typename Element<T>::type;
+            append(typeOf<E>());
+            append(Element<T>::components);
+        }
+
+        template<typename T>
+        void write(const T& value) {
+            if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+                append(static_cast<uint64_t>(value.size()));
+                m_out.insert(m_out.end(), value.begin(), value.end());
+            } else if constexpr (snap::Vector<T>) {
+                for(auto i = 0; i < T::length(); i++){
+                    append(static_cast<Storage<typename Element<T>::type>>(value[i]));
+                }
+            } else {
+                append(static_cast<Storage<T>>(value));
+            }
+        }
+
+        template<typename T>
+        void append(const T& value) {
+            const auto offset = m_out.size();
+            m_out.resize(offset + sizeof(T));
+            std::memcpy(m_out.data() + offset, &value, sizeof(T));
+        }
+
+        std::vector<char>& m_out;
+    };
+
+    template<typename T>
+    auto serialize(const T& object) -> std::vector<char> {
+        std::vector<char> out;
+        Writer writer{out};
+        writer.object("", object);
+        return out;
+    }
+}
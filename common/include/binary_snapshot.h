@@ -0,0 +1,235 @@
+#pragma once
+
+#include "particle.h"
+#include "model.h"
+#include <fmt/format.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// Versioned binary snapshot of SeparateFieldMemoryLayout particles:
+//
+//  [Header][FieldEntry * numFields][padding][column 0][padding][column 1]...
+//
+// every column is the raw contents of one SeparateFieldMemoryLayout span aligned to Header::alignment,
+// so loading is a memory mapping of the file with the layout's spans pointing straight into it.
+namespace snapshot {
+
+    constexpr std::array<char, 8> Magic{'P', 'P', 'S', 'N', 'A', 'P', '\0', '\0'};
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ColumnAlignment = 64;
+
+    struct Header {
+        std::array<char, 8> magic{Magic};
+        uint32_t version{Version};
+        uint32_t dimension{};
+        uint64_t size{};
+        uint64_t capacity{};
+        uint32_t numFields{};
+        uint32_t alignment{ColumnAlignment};
+        uint64_t fieldTableOffset{sizeof(Header)};
+        float lower[3]{};
+        float upper[3]{};
+        uint64_t reserved{};
+    };
+    static_assert(sizeof(Header) == 80);
+
+    struct FieldEntry {
+        char name[16]{};
+        uint32_t field{};
+        uint32_t elementSize{};
+        uint64_t offset{};
+        uint64_t bytes{};
+    };
+    static_assert(sizeof(FieldEntry) == 40);
+
+    constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // read only or private (copy on write) mapping of a whole file, changes are never written back
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]]
+        std::span<char> data() const {
+            return { m_data, m_size };
+        }
+
+    private:
+        char* m_data{};
+        size_t m_size{};
+#ifdef _WIN32
+        void* m_file{};
+        void* m_mapping{};
+#endif
+    };
+
+    template<glm::length_t L>
+    struct Loaded {
+        std::shared_ptr<SeparateFieldParticles<L>> particles;
+        Bounds<L> bounds;
+        Header header;
+    };
+
+    namespace detail {
+        template<typename T>
+        FieldEntry entry(const char* name, Field field, std::span<T> column, size_t count) {
+            FieldEntry e{};
+            std::strncpy(e.name, name, sizeof(e.name) - 1);
+            e.field = static_cast<uint32_t>(field);
+            e.elementSize = sizeof(T);
+            e.bytes = count * sizeof(T);
+            return e;
+        }
+
+        template<typename T>
+        std::span<T> column(std::span<char> file, const FieldEntry& entry, uint64_t capacity) {
+            if(entry.elementSize != sizeof(T)) {
+                throw std::runtime_error{ fmt::format("snapshot field {} has element size {}, expected {}", entry.name, entry.elementSize, sizeof(T)) };
+            }
+            if(entry.bytes != capacity * sizeof(T) || entry.offset % alignof(T) != 0 || entry.offset + entry.bytes > file.size()) {
+                throw std::runtime_error{ fmt::format("snapshot field {} is out of bounds", entry.name) };
+            }
+            return { as<T>(file.data() + entry.offset), capacity };
+        }
+    }
+
+    // capacity >= particles.size() reserves zeroed space for particles added after loading
+    template<glm::length_t L>
+    void write(const std::string& path, const SeparateFieldParticles<L>& particles, const Bounds<L>& bounds, size_t capacity = 0) {
+        const auto& data = particles.layout.data;
+        const auto size = particles.size();
+        capacity = std::max(capacity, size);
+
+        std::array<FieldEntry, 6> fields{
+            detail::entry("position", Field::Position, data.position, capacity),
+            detail::entry("prePosition", Field::PreviousPosition, data.prePosition, capacity),
+            detail::entry("velocity", Field::Velocity, data.velocity, capacity),
+            detail::entry("inverseMass", Field::Mass, data.inverseMass, capacity),
+            detail::entry("restitution", Field::Restitution, data.restitution, capacity),
+            detail::entry("radius", Field::Radius, data.radius, capacity)
+        };
+
+        Header header{};
+        header.dimension = L;
+        header.size = size;
+        header.capacity = capacity;
+        header.numFields = fields.size();
+        for(auto i = 0; i < L && i < 3; i++){
+            header.lower[i] = bounds.lower[i];
+            header.upper[i] = bounds.upper[i];
+        }
+
+        auto offset = header.fieldTableOffset + sizeof(FieldEntry) * fields.size();
+        for(auto& field : fields){
+            field.offset = alignUp(offset, header.alignment);
+            offset = field.offset + field.bytes;
+        }
+
+        std::ofstream fout{path, std::ios::binary | std::ios::trunc};
+        if(!fout.good()) {
+            throw std::runtime_error{ fmt::format("unable to open {} for writing", path) };
+        }
+        fout.write(as<char>(&header), sizeof(header));
+        fout.write(as<char>(fields.data()), sizeof(FieldEntry) * fields.size());
+
+        static constexpr std::array<char, ColumnAlignment> zeros{};
+        auto writeColumn = [&](const FieldEntry& field, const auto& column){
+            const auto pos = static_cast<uint64_t>(fout.tellp());
+            fout.write(zeros.data(), static_cast<std::streamsize>(field.offset - pos));
+
+            const auto used = size * field.elementSize;
+            fout.write(as<const char>(column.data()), static_cast<std::streamsize>(used));
+            for(auto remaining = field.bytes - used; remaining > 0;){
+                const auto n = std::min<uint64_t>(remaining, zeros.size());
+                fout.write(zeros.data(), static_cast<std::streamsize>(n));
+                remaining -= n;
+            }
+        };
+        writeColumn(fields[0], data.position);
+        writeColumn(fields[1], data.prePosition);
+        writeColumn(fields[2], data.velocity);
+        writeColumn(fields[3], data.inverseMass);
+        writeColumn(fields[4], data.restitution);
+        writeColumn(fields[5], data.radius);
+
+        if(!fout.good()) {
+            throw std::runtime_error{ fmt::format("error writing snapshot {}", path) };
+        }
+    }
+
+    // maps the file copy on write and constructs particles over the mapping without copying,
+    // the mapping lives as long as the returned particles
+    template<glm::length_t L>
+    Loaded<L> load(const std::string& path) {
+        using Vec = typename SeparateFieldParticles<L>::VecType;
+
+        auto file = std::make_shared<MappedFile>(path);
+        auto bytes = file->data();
+
+        if(bytes.size() < sizeof(Header)) {
+            throw std::runtime_error{ fmt::format("{} is not a particle snapshot", path) };
+        }
+        Header header{};
+        std::memcpy(&header, bytes.data(), sizeof(Header));
+        if(header.magic != Magic) {
+            throw std::runtime_error{ fmt::format("{} is not a particle snapshot", path) };
+        }
+        if(header.version == 0 || header.version > Version) {
+            throw std::runtime_error{ fmt::format("snapshot version {} is not supported, expected 1 to {}", header.version, Version) };
+        }
+        if(header.dimension != L) {
+            throw std::runtime_error{ fmt::format("snapshot has dimension {}, expected {}", header.dimension, L) };
+        }
+        if(header.size > header.capacity || header.fieldTableOffset + header.numFields * sizeof(FieldEntry) > bytes.size()) {
+            throw std::runtime_error{ fmt::format("snapshot {} is corrupt", path) };
+        }
+
+        typename SeparateFieldMemoryLayout<Vec>::Members members{};
+        uint32_t found = 0;
+        for(auto i = 0u; i < header.numFields; i++){
+            FieldEntry entry{};
+            std::memcpy(&entry, bytes.data() + header.fieldTableOffset + i * sizeof(FieldEntry), sizeof(FieldEntry));
+            switch(static_cast<Field>(entry.field)){
+                case Field::Position: members.position = detail::column<Vec>(bytes, entry, header.capacity); break;
+                case Field::PreviousPosition: members.prePosition = detail::column<Vec>(bytes, entry, header.capacity); break;
+                case Field::Velocity: members.velocity = detail::column<Vec>(bytes, entry, header.capacity); break;
+                case Field::Mass: members.inverseMass = detail::column<float>(bytes, entry, header.capacity); break;
+                case Field::Restitution: members.restitution = detail::column<float>(bytes, entry, header.capacity); break;
+                case Field::Radius: members.radius = detail::column<float>(bytes, entry, header.capacity); break;
+                default: continue;  // fields added by later versions
+            }
+            found |= 1u << entry.field;
+        }
+        if(found != 0b111111u) {
+            throw std::runtime_error{ fmt::format("snapshot {} is missing particle fields", path) };
+        }
+
+        auto particles = new SeparateFieldParticles<L>{
+            { members.position, members.prePosition, members.velocity, members.inverseMass, members.restitution, members.radius }
+        };
+        particles->resize(header.size);
+
+        Loaded<L> loaded{};
+        loaded.particles = std::shared_ptr<SeparateFieldParticles<L>>(particles, [file](auto* ptr){ delete ptr; });
+        for(auto i = 0; i < L && i < 3; i++){
+            loaded.bounds.lower[i] = header.lower[i];
+            loaded.bounds.upper[i] = header.upper[i];
+        }
+        loaded.header = header;
+        return loaded;
+    }
+}
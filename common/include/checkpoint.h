@@ -0,0 +1,312 @@
+#pragma once
+
+#include "particle.h"
+#include <fmt/format.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary checkpoint of solver and emitter state for restarting long runs.
+//
+//  [magic][version]([section name][payload])...
+//
+// every object writes a named section followed by its raw state, values are written exactly as
+// they are held in memory so a restored run continues bitwise identical to the original.
+// Checkpoints are tied to the build that wrote them (same layout, compiler and platform).
+namespace checkpoint {
+
+    constexpr std::array<char, 8> Magic{'P', 'P', 'C', 'K', 'P', 'T', '\0', '\0'};
+    constexpr uint32_t Version = 6;
+    constexpr size_t SectionNameSize = 16;
+
+    // state is serialised into memory so the simulation only pays for a copy, the file is
+    // written by close() or in the background by closeAsync(). Both hand the buffer back so
+    // periodic checkpoints can reuse it instead of faulting in fresh pages every time.
+    class Writer {
+    public:
+        explicit Writer(std::string path, std::vector<char> buffer = {})
+        : m_path(std::move(path))
+        , m_buffer(std::move(buffer))
+        {
+            m_buffer.clear();
+            write(Magic);
+            write(Version);
+        }
+
+        ~Writer() = default;
+
+        Writer(const Writer&) = delete;
+
+        Writer& operator=(const Writer&) = delete;
+
+        void section(std::string_view name) {
+            std::array<char, SectionNameSize> tag{};
+            std::memcpy(tag.data(), name.data(), std::min(name.size(), tag.size()));
+            write(tag);
+        }
+
+        template<typename T>
+        void write(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            append(as<const char>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        void write(std::span<const T> values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            write(static_cast<uint64_t>(values.size()));
+            append(as<const char>(values.data()), values.size_bytes());
+        }
+
+        template<typename T>
+        void write(const std::vector<T>& values) {
+            write(std::span<const T>{ values });
+        }
+
+        void write(const std::string& value) {
+            write(std::span<const char>{ value });
+        }
+
+        [[nodiscard]]
+        size_t size() const {
+            return m_buffer.size();
+        }
+
+        std::vector<char> close() {
+            flush(m_path, m_buffer);
+            return std::move(m_buffer);
+        }
+
+        // hands the serialised state to a background thread, errors are rethrown by the future
+        [[nodiscard]]
+        std::future<std::vector<char>> closeAsync() {
+            return std::async(std::launch::async, [path = m_path, buffer = std::move(m_buffer)]() mutable {
+                flush(path, buffer);
+                return std::move(buffer);
+            });
+        }
+
+    private:
+        void append(const char* data, size_t size) {
+            m_buffer.insert(m_buffer.end(), data, data + size);
+        }
+
+        static void flush(const std::string& path, const std::vector<char>& buffer) {
+            std::ofstream fout{path, std::ios::binary | std::ios::trunc};
+            fout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            fout.close();
+            if(fout.fail()) {
+                throw std::runtime_error{ fmt::format("error writing checkpoint {}", path) };
+            }
+        }
+
+        std::string m_path;
+        std::vector<char> m_buffer;
+    };
+
+    class Reader {
+    public:
+        explicit Reader(const std::string& path)
+        : m_path(path)
+        , m_stream(path, std::ios::binary)
+        {
+            if(!m_stream.good()) {
+                throw std::runtime_error{ fmt::format("unable to open {}", path) };
+            }
+            m_stream.seekg(0, std::ios::end);
+            m_size = m_stream.tellg();
+            m_stream.seekg(0, std::ios::beg);
+            if(read<std::array<char, 8>>() != Magic) {
+                throw std::runtime_error{ fmt::format("{} is not a checkpoint", path) };
+            }
+            if(auto version = read<uint32_t>(); version != Version) {
+                throw std::runtime_error{ fmt::format("checkpoint version {} is not supported, expected {}", version, Version) };
+            }
+        }
+
+        ~Reader() = default;
+
+        Reader(const Reader&) = delete;
+
+        Reader& operator=(const Reader&) = delete;
+
+        // sections are read back in the order they were written
+        void section(std::string_view name) {
+            auto tag = read<std::array<char, SectionNameSize>>();
+            std::string_view found{ tag.data(), strnlen(tag.data(), tag.size()) };
+            if(found != name.substr(0, SectionNameSize)) {
+                throw std::runtime_error{ fmt::format("checkpoint {} has section '{}' where '{}' was expected", m_path, found, name) };
+            }
+        }
+
+        template<typename T>
+        T read() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value{};
+            read(as<char>(&value), sizeof(T));
+            return value;
+        }
+
+        template<typename T>
+        void read(T& value) {
+            value = read<T>();
+        }
+
+        // the stored span must have exactly the size of values
+        template<typename T>
+        void read(std::span<T> values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if(auto size = read<uint64_t>(); size != values.size()) {
+                throw std::runtime_error{ fmt::format("checkpoint {} stores {} values where {} were expected", m_path, size, values.size()) };
+            }
+            read(as<char>(values.data()), values.size_bytes());
+        }
+
+        template<typename T>
+        void read(std::vector<T>& values) {
+            values.resize(length(sizeof(T)));
+            read(as<char>(values.data()), values.size() * sizeof(T));
+        }
+
+        void read(std::string& value) {
+            value.resize(length(sizeof(char)));
+            read(value.data(), value.size());
+        }
+
+    private:
+        // a stored length checked against the rest of the file, so a corrupt one fails before it is allocated
+        size_t length(size_t elementSize) {
+            const auto count = read<uint64_t>();
+            const auto remaining = static_cast<uint64_t>(m_size - m_stream.tellg());
+            if(count > remaining / elementSize) {
+                throw std::runtime_error{ fmt::format("checkpoint {} is truncated", m_path) };
+            }
+            return static_cast<size_t>(count);
+        }
+
+        void read(char* data, size_t size) {
+            m_stream.read(data, static_cast<std::streamsize>(size));
+            if(!m_stream.good()) {
+                throw std::runtime_error{ fmt::format("checkpoint {} is truncated", m_path) };
+            }
+        }
+
+        std::string m_path;
+        std::ifstream m_stream;
+        std::streampos m_size{};
+    };
+
+    // live particles are stored field by field, restoring requires enough capacity
+    template<glm::length_t L, template<typename> typename Layout>
+    void write(Writer& writer, const Particles<L, Layout>& particles) {
+        const auto size = particles.size();
+        writer.section("particles");
+        writer.write(static_cast<uint64_t>(size));
+        if constexpr (std::is_same_v<Layout<glm::vec<L, float>>, SeparateFieldMemoryLayout<glm::vec<L, float>>>) {
+            const auto& data = particles.layout.data;
+            writer.write(std::span<const glm::vec<L, float>>{ data.position.first(size) });
+            writer.write(std::span<const glm::vec<L, float>>{ data.prePosition.first(size) });
+            writer.write(std::span<const glm::vec<L, float>>{ data.velocity.first(size) });
+            writer.write(std::span<const float>{ data.inverseMass.first(size) });
+            writer.write(std::span<const float>{ data.restitution.first(size) });
+            writer.write(std::span<const float>{ data.radius.first(size) });
+        } else if constexpr (std::is_same_v<Layout<glm::vec<L, float>>, PagedMemoryLayout<glm::vec<L, float>>>) {
+            // field by field like the separate field layout, one span per chunk
+            const auto chunks = particles.layout.block(0, size);
+            auto field = [&](auto column){
+                for(const auto& chunk : chunks){
+                    const auto& values = chunk.*column;
+                    writer.write(std::span<const typename std::decay_t<decltype(values)>::value_type>{ values });
+                }
+            };
+            field(&Particles<L, Layout>::Members::position);
+            field(&Particles<L, Layout>::Members::prePosition);
+            field(&Particles<L, Layout>::Members::velocity);
+            field(&Particles<L, Layout>::Members::inverseMass);
+            field(&Particles<L, Layout>::Members::restitution);
+            field(&Particles<L, Layout>::Members::radius);
+        } else {
+            writer.write(std::span<const typename Particles<L, Layout>::Members>{ particles.layout.data, size });
+        }
+    }
+
+    template<glm::length_t L, template<typename> typename Layout>
+    void read(Reader& reader, Particles<L, Layout>& particles) {
+        reader.section("particles");
+        const auto size = reader.read<uint64_t>();
+        particles.resize(size);
+        if constexpr (std::is_same_v<Layout<glm::vec<L, float>>, SeparateFieldMemoryLayout<glm::vec<L, float>>>) {
+            auto& data = particles.layout.data;
+            reader.read(data.position.first(size));
+            reader.read(data.prePosition.first(size));
+            reader.read(data.velocity.first(size));
+            reader.read(data.inverseMass.first(size));
+            reader.read(data.restitution.first(size));
+            reader.read(data.radius.first(size));
+        } else if constexpr (std::is_same_v<Layout<glm::vec<L, float>>, PagedMemoryLayout<glm::vec<L, float>>>) {
+            const auto chunks = particles.layout.block(0, size);
+            auto field = [&](auto column){
+                for(const auto& chunk : chunks){
+                    reader.read(chunk.*column);
+                }
+            };
+            field(&Particles<L, Layout>::Members::position);
+            field(&Particles<L, Layout>::Members::prePosition);
+            field(&Particles<L, Layout>::Members::velocity);
+            field(&Particles<L, Layout>::Members::inverseMass);
+            field(&Particles<L, Layout>::Members::restitution);
+            field(&Particles<L, Layout>::Members::radius);
+        } else {
+            reader.read(std::span<typename Particles<L, Layout>::Members>{ particles.layout.data, size });
+        }
+    }
+
+    template<typename Solver, typename Emitters>
+    void save(Writer& writer, const Solver& solver, const Emitters& emitters) {
+        solver.save(writer);
+        writer.section("emitters");
+        writer.write(static_cast<uint64_t>(emitters.size()));
+        for(const auto& emitter : emitters){
+            emitter->save(writer);
+        }
+    }
+
+    // checkpoint of a whole scene, restore into a scene built with the same configuration
+    template<typename Solver, typename Emitters>
+    void save(const std::string& path, const Solver& solver, const Emitters& emitters) {
+        Writer writer{path};
+        save(writer, solver, emitters);
+        writer.close();
+    }
+
+    // copies the scene state and returns, the file is written in the background
+    template<typename Solver, typename Emitters>
+    [[nodiscard]]
+    std::future<std::vector<char>> saveAsync(const std::string& path, const Solver& solver, const Emitters& emitters, std::vector<char> buffer = {}) {
+        Writer writer{path, std::move(buffer)};
+        save(writer, solver, emitters);
+        return writer.closeAsync();
+    }
+
+    template<typename Solver, typename Emitters>
+    void restore(const std::string& path, Solver& solver, Emitters& emitters) {
+        Reader reader{path};
+        solver.restore(reader);
+        reader.section("emitters");
+        if(auto count = reader.read<uint64_t>(); count != emitters.size()) {
+            throw std::runtime_error{ fmt::format("checkpoint {} has {} emitters, the scene has {}", path, count, emitters.size()) };
+        }
+        for(auto& emitter : emitters){
+            emitter->restore(reader);
+        }
+    }
+}
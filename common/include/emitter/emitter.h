@@ -1,5 +1,6 @@
 #pragma once
 
+#include "checkpoint.h"
 #include <glm/glm.hpp>
 
 template<glm::length_t L, typename Consumer>
@@ -38,6 +39,19 @@ public:
         m_currentTime = 0;
     }
 
+    // emitter clock and whatever derived emitters need to emit the same particles after restore
+    virtual void save(checkpoint::Writer& writer) const {
+        writer.section("emitter");
+        writer.write(m_enabled);
+        writer.write(m_currentTime);
+    }
+
+    virtual void restore(checkpoint::Reader& reader) {
+        reader.section("emitter");
+        reader.read(m_enabled);
+        reader.read(m_currentTime);
+    }
+
 protected:
     Consumer m_consumer;
     bool m_enabled{true};
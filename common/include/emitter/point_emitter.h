@@ -1,7 +1,10 @@
 #pragma once
 
 #include "emitter.h"
-#include <random>
+#include "parallel.h"
+#include "philox.h"
+#include "types.h"
+#include <vector>
 
 template<glm::length_t L, typename Consumer>
 class PointEmitter : public Emitter<L, Consumer> {
@@ -22,7 +25,7 @@ public:
             , m_spreadAngleRad{ glm::radians(spreadAngleDeg) }
             , maxNumberOfParticlePerSecond{ maxNumOfNewParticlePerSecond }
             , maxNumberOfParticles{ maxNumOfParticles }
-            , m_rng{ seed }
+            , m_random{ seed }
     {}
 
 
@@ -43,20 +46,34 @@ public:
 
         if(maxNumberOfNewParticles > 0) {
             emit(maxNumberOfNewParticles, deltaTime);
-            m_numberOfEmittedParticles += maxNumberOfNewParticles;
         }
 
     }
 
+    // the direction of a particle only depends on the seed and how many particles were emitted
+    // before it, so it does not matter how emission is split across frames or threads
     void emit(size_t maxNewNumberOfParticles, float deltaTime) {
         auto t = this->m_consumer.offset(deltaTime);
+        const auto first = to<uint64_t>(m_numberOfEmittedParticles);
+        m_directions.resize(maxNewNumberOfParticles);
+        parallel::forEach(maxNewNumberOfParticles, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; ++i){
+                m_directions[i] = direction(first + i);
+            }
+        });
         for(size_t i = 0; i < maxNewNumberOfParticles; ++i){
-            auto angle = (random() - 0.5) * m_spreadAngleRad;
-            glm::mat2 rotate{ glm::cos(angle), glm::sin(angle), -glm::sin(angle), glm::cos(angle) };
-            auto direction = rotate * m_direction;
-            auto position = m_origin + direction * (i * t);
+            const auto& direction = m_directions[i];
+            auto position = m_origin + direction * (to<float>(i) * t);
             this->m_consumer.use(position, m_speed * direction);
         }
+        m_numberOfEmittedParticles += to<int>(maxNewNumberOfParticles);
+    }
+
+    [[nodiscard]]
+    glm::vec<L, float> direction(uint64_t particleIndex) const {
+        auto angle = (m_random.uniform(particleIndex) - 0.5f) * m_spreadAngleRad;
+        glm::mat2 rotate{ glm::cos(angle), glm::sin(angle), -glm::sin(angle), glm::cos(angle) };
+        return rotate * m_direction;
     }
 
     void clear() final  {
@@ -66,10 +83,26 @@ public:
         m_firstFrameTimeInSeconds = 0;
     }
 
-private:
-    float random() {
-        static std::uniform_real_distribution<> dist(0.0, 1.0);
-        return dist(m_rng);
+    void save(checkpoint::Writer& writer) const override {
+        Emitter<L, Consumer>::save(writer);
+        writer.section("point_emitter");
+        writer.write(m_random.seed());
+        writer.write(m_firstFrameTimeInSeconds);
+        writer.write(m_numberOfEmittedParticles);
+        writer.write(maxNumberOfParticlePerSecond);
+        writer.write(maxNumberOfParticles);
+    }
+
+    void restore(checkpoint::Reader& reader) override {
+        Emitter<L, Consumer>::restore(reader);
+        reader.section("point_emitter");
+        uint32_t seed{};
+        reader.read(seed);
+        m_random = philox::Stream{ seed };
+        reader.read(m_firstFrameTimeInSeconds);
+        reader.read(m_numberOfEmittedParticles);
+        reader.read(maxNumberOfParticlePerSecond);
+        reader.read(maxNumberOfParticles);
     }
 
 public:
@@ -77,7 +110,7 @@ public:
     int maxNumberOfParticles;
 
 private:
-    std::default_random_engine m_rng;
+    philox::Stream m_random;
     float m_firstFrameTimeInSeconds{};
     int m_numberOfEmittedParticles{};
 
@@ -85,5 +118,6 @@ private:
     glm::vec<L, float> m_direction;
     float m_speed;
     float m_spreadAngleRad;
+    std::vector<glm::vec<L, float>> m_directions;
 
 };
\ No newline at end of file
@@ -2,14 +2,38 @@
 
 #include "emitter.h"
 #include "point_generators.h"
+#include "parallel.h"
+#include <array>
+#include <algorithm>
+#include <barrier>
+#include <exception>
+#include <numeric>
+#include <span>
+#include <tuple>
 
 template<glm::length_t L, typename Consumer>
 class VolumeEmitter : public Emitter<L, Consumer> {
 public:
+    using Sdf = std::function<float(const glm::vec<L, float>&)>;
+
+    // signed distances of a run of points, one call per run instead of one per point
+    using BatchSdf = std::function<void(std::span<const glm::vec<L, float>>, std::span<float>)>;
+
+    static constexpr size_t SdfBatchSize = 256;
+
     VolumeEmitter() = default;
 
     VolumeEmitter(
-            std::function<float(const glm::vec<L, float>&)> sdf,
+            Sdf sdf,
+            std::unique_ptr<PointGenerator<L>> pointGenerator,
+            Bounds<L> bounds,
+            float spacing)
+            : VolumeEmitter(batch(std::move(sdf)), std::move(pointGenerator), bounds, spacing)
+    {
+    }
+
+    VolumeEmitter(
+            BatchSdf sdf,
             std::unique_ptr<PointGenerator<L>> pointGenerator,
             Bounds<L> bounds,
             float spacing)
@@ -22,17 +46,63 @@ public:
 
     ~VolumeEmitter() override = default;
 
+    // every worker filters its share of the generated points through the SDF in place, once all
+    // shares are counted the particles are claimed in one go and every worker inserts its
+    // survivors at its offset. Particles end up in generator order whatever the number of workers.
+    //
+    // Room for every generated point is reserved up front, claiming in the barrier's completion
+    // then neither allocates nor throws. An exception from the SDF is carried out of its worker,
+    // nothing is emitted and it is rethrown here.
     void onUpdate(float currentTime, float deltaTime) override {
-        auto consumer = this->m_consumer;
+        auto& consumer = this->m_consumer;
         if(!consumer){
             return;
         }
 
-        auto sdf = m_sdf;
         auto points = m_pointGenerator->generate(m_bounds, m_spacing);
-        for(const auto& point : points){
-            if(sdf(point) < 0){
-                consumer.use(point);
+        consumer.reserve(points.size());
+
+        const auto numWorkers = parallel::workers(points.size());
+        std::vector<size_t> offsets(numWorkers + 1);
+        std::vector<std::exception_ptr> errors(numWorkers);
+        size_t first = 0;
+        size_t claimed = 0;
+        std::barrier counted{ numWorkers, [&]() noexcept {
+            std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), size_t{0});
+            const auto failed = std::ranges::any_of(errors, [](const auto& error){ return static_cast<bool>(error); });
+            std::tie(first, claimed) = consumer.claim(failed ? 0 : offsets.back());
+        }};
+
+        parallel::run(numWorkers, [&](uint32_t worker){
+            const auto [begin, end] = parallel::range(points.size(), worker, numWorkers);
+            auto share = std::span{ points }.subspan(begin, end - begin);
+
+            size_t kept = 0;
+            try {
+                std::array<float, SdfBatchSize> distance{};
+                for(size_t batch = 0; batch < share.size(); batch += SdfBatchSize){
+                    const auto n = std::min(SdfBatchSize, share.size() - batch);
+                    m_sdf(share.subspan(batch, n), std::span{ distance }.first(n));
+                    for(size_t i = 0; i < n; i++){
+                        share[kept] = share[batch + i];
+                        kept += distance[i] < 0;
+                    }
+                }
+            } catch(...) {
+                errors[worker] = std::current_exception();
+                kept = 0;
+            }
+            offsets[worker] = kept;
+            counted.arrive_and_wait();
+
+            const auto offset = std::min(offsets[worker], claimed);
+            const auto count = std::min(offsets[worker + 1], claimed) - offset;
+            consumer.assign(first + offset, share.first(count));
+        });
+
+        for(const auto& error : errors){
+            if(error){
+                std::rethrow_exception(error);
             }
         }
         this->disable();
@@ -43,10 +113,18 @@ public:
     }
 
 private:
+    static BatchSdf batch(Sdf sdf) {
+        return [sdf = std::move(sdf)](std::span<const glm::vec<L, float>> points, std::span<float> distance){
+            for(size_t i = 0; i < points.size(); i++){
+                distance[i] = sdf(points[i]);
+            }
+        };
+    }
+
 private:
-    std::function<float(const glm::vec2&)> m_sdf;
+    BatchSdf m_sdf;
     std::unique_ptr<PointGenerator2D> m_pointGenerator{};
     Bounds2D m_bounds{};
     float m_spacing{0};
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stats {
+
+    // log-linear (HDR style) histogram of nanosecond durations, each power of two is split into
+    // 2^SubBucketBits linear buckets giving ~3% relative precision. Writers pick a shard based on
+    // their thread so concurrent updates from the thread pool do not contend on the same cache lines.
+    class Histogram {
+    public:
+        static constexpr uint32_t SubBucketBits = 5;
+        static constexpr uint32_t SubBucketCount = 1u << SubBucketBits;
+        static constexpr uint32_t MaxBits = 40;    // ~18 minutes in nanoseconds
+        static constexpr uint32_t NumBuckets = (MaxBits - SubBucketBits + 1) * SubBucketCount;
+        static constexpr uint32_t NumShards = 8;
+
+        struct Summary {
+            uint64_t count{};
+            double mean{};
+            double p50{};
+            double p95{};
+            double p99{};
+            double max{};
+        };
+
+        Histogram() = default;
+
+        Histogram(const Histogram&) = delete;
+
+        Histogram& operator=(const Histogram&) = delete;
+
+        void record(uint64_t nanoseconds) {
+            auto& shard = m_shards[shardId()];
+            shard.counts[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+            shard.count.fetch_add(1, std::memory_order_relaxed);
+            shard.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+            auto max = shard.max.load(std::memory_order_relaxed);
+            while(nanoseconds > max && !shard.max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed));
+        }
+
+        template<typename Duration>
+        void record(Duration duration) {
+            record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+        }
+
+        [[nodiscard]]
+        uint64_t count() const {
+            uint64_t total = 0;
+            for(const auto& shard : m_shards) total += shard.count.load(std::memory_order_relaxed);
+            return total;
+        }
+
+        // returned in nanoseconds, q in [0, 1]
+        [[nodiscard]]
+        double percentile(double q) const {
+            std::vector<uint64_t> counts(NumBuckets);
+            const auto total = merge(counts);
+            return percentile(counts, total, q);
+        }
+
+        // values in milliseconds
+        [[nodiscard]]
+        Summary summary() const {
+            std::vector<uint64_t> counts(NumBuckets);
+            const auto total = merge(counts);
+            uint64_t sum = 0, max = 0;
+            for(const auto& shard : m_shards){
+                sum += shard.sum.load(std::memory_order_relaxed);
+                max = std::max(max, shard.max.load(std::memory_order_relaxed));
+            }
+            constexpr auto toMs = 1e-6;
+            Summary result{};
+            result.count = total;
+            result.mean = total == 0 ? 0 : toMs * static_cast<double>(sum) / static_cast<double>(total);
+            result.p50 = toMs * percentile(counts, total, 0.50);
+            result.p95 = toMs * percentile(counts, total, 0.95);
+            result.p99 = toMs * percentile(counts, total, 0.99);
+            result.max = toMs * static_cast<double>(max);
+            return result;
+        }
+
+        void clear() {
+            for(auto& shard : m_shards){
+                for(auto& c : shard.counts) c.store(0, std::memory_order_relaxed);
+                shard.count.store(0, std::memory_order_relaxed);
+                shard.sum.store(0, std::memory_order_relaxed);
+                shard.max.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        static constexpr uint32_t bucketIndex(uint64_t value) {
+            const auto msb = static_cast<uint32_t>(std::bit_width(value)) - 1;
+            if(value < SubBucketCount) return static_cast<uint32_t>(value);
+            if(msb >= MaxBits) return NumBuckets - 1;
+            const auto shift = msb - SubBucketBits;
+            return (shift + 1) * SubBucketCount + static_cast<uint32_t>((value >> shift) - SubBucketCount);
+        }
+
+        static constexpr uint64_t bucketLowerBound(uint32_t index) {
+            if(index < 2 * SubBucketCount) return index;
+            const auto shift = index / SubBucketCount - 1;
+            const auto sub = index % SubBucketCount;
+            return static_cast<uint64_t>(SubBucketCount + sub) << shift;
+        }
+
+        static constexpr uint64_t bucketWidth(uint32_t index) {
+            return index < 2 * SubBucketCount ? 1 : uint64_t{1} << (index / SubBucketCount - 1);
+        }
+
+    private:
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, NumBuckets> counts{};
+            std::atomic<uint64_t> count{};
+            std::atomic<uint64_t> sum{};
+            std::atomic<uint64_t> max{};
+        };
+
+        static uint32_t shardId() {
+            static std::atomic<uint32_t> nextId{0};
+            thread_local const uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed) % NumShards;
+            return id;
+        }
+
+        uint64_t merge(std::vector<uint64_t>& counts) const {
+            uint64_t total = 0;
+            for(const auto& shard : m_shards){
+                for(auto i = 0u; i < NumBuckets; i++){
+                    const auto c = shard.counts[i].load(std::memory_order_relaxed);
+                    counts[i] += c;
+                    total += c;
+                }
+            }
+            return total;
+        }
+
+        static double percentile(const std::vector<uint64_t>& counts, uint64_t total, double q) {
+            if(total == 0) return 0;
+            const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(total) + 0.5));
+            uint64_t seen = 0;
+            for(auto i = 0u; i < NumBuckets; i++){
+                seen += counts[i];
+                if(seen >= rank){
+                    return static_cast<double>(bucketLowerBound(i)) + 0.5 * static_cast<double>(bucketWidth(i) - 1);
+                }
+            }
+            return static_cast<double>(bucketLowerBound(NumBuckets - 1));
+        }
+
+        std::array<Shard, NumShards> m_shards{};
+    };
+
+    // step time histogram plus one histogram per named phase. Register phases up front (or cache the
+    // returned reference), registration takes a lock but recording into a phase does not.
+    class FrameStats {
+    public:
+        FrameStats() = default;
+
+        FrameStats(const FrameStats&) = delete;
+
+        FrameStats& operator=(const FrameStats&) = delete;
+
+        Histogram& step() {
+            return m_step;
+        }
+
+        const Histogram& step() const {
+            return m_step;
+        }
+
+        Histogram& phase(std::string_view name) {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            auto itr = m_phases.find(name);
+            if(itr == m_phases.end()){
+                itr = m_phases.try_emplace(std::string{name}).first;
+            }
+            return itr->second;
+        }
+
+        template<typename Visitor>
+        void forEachPhase(Visitor&& visitor) const {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for(const auto& [name, histogram] : m_phases){
+                visitor(name, histogram);
+            }
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_step.clear();
+            for(auto& [_, histogram] : m_phases) histogram.clear();
+        }
+
+        [[nodiscard]]
+        std::string json() const {
+            std::string result = fmt::format("{{\"step\":{},\"phases\":{{", json(m_step.summary()));
+            bool first = true;
+            forEachPhase([&](const auto& name, const auto& histogram){
+                result += fmt::format("{}\"{}\":{}", first ? "" : ",", name, json(histogram.summary()));
+                first = false;
+            });
+            result += "}}";
+            return result;
+        }
+
+        bool dump(const std::string& path) const {
+            std::ofstream fout{path};
+            if(!fout.good()) return false;
+            fout << json();
+            return true;
+        }
+
+    private:
+        static std::string json(const Histogram::Summary& summary) {
+            return fmt::format(R"({{"count":{},"mean_ms":{:.4f},"p50_ms":{:.4f},"p95_ms":{:.4f},"p99_ms":{:.4f},"max_ms":{:.4f}}})",
+                               summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+        }
+
+        Histogram m_step;
+        std::map<std::string, Histogram, std::less<>> m_phases;
+        mutable std::mutex m_mutex;
+    };
+
+    // records the lifetime of the scope into histogram, does nothing if histogram is null
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Histogram* histogram)
+        : m_histogram(histogram)
+        , m_start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{})
+        {}
+
+        explicit ScopedTimer(Histogram& histogram)
+        : ScopedTimer(&histogram)
+        {}
+
+        ~ScopedTimer() {
+            if(m_histogram){
+                m_histogram->record(std::chrono::steady_clock::now() - m_start);
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram* m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
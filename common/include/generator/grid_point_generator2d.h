@@ -6,4 +6,10 @@ class GridPointGenerator2D final : public PointGenerator2D {
 public:
 
     void forEachPoint(const Bounds2D &bounds, float spacing, Callback callback) const final;
-};
\ No newline at end of file
+
+protected:
+    [[nodiscard]]
+    Rows rows(const Bounds2D& bounds, float spacing) const final;
+
+    void row(const Bounds2D& bounds, float spacing, size_t row, std::span<glm::vec2> points) const final;
+};
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "model2d.h"
+#include "parallel.h"
 #include <vector>
 #include <functional>
+#include <span>
+#include <stdexcept>
 #include <glm/glm.hpp>
 
 template<glm::length_t L>
@@ -14,19 +17,88 @@ public:
 
     virtual ~PointGenerator() = default;
 
+    // storage for exactly count points, called once before any point is written
+    using Allocate = std::function<std::span<glm::vec2>(size_t count)>;
+
     [[nodiscard]]
     std::vector<glm::vec2> generate(const Bounds<L>& bounds, float spacing) const {
         std::vector<glm::vec2> points;
+        generate(bounds, spacing, [&points](size_t count){
+            points.resize(count);
+            return std::span{ points };
+        });
+        return points;
+    }
 
-        forEachPoint(bounds, spacing, [&points](const glm::vec2& point){
-            points.push_back(point);
-            return true;
+    // writes the points forEachPoint visits, in the same order, into points which must hold
+    // exactly count() of them. Rows are generated in parallel
+    void generate(const Bounds<L>& bounds, float spacing, std::span<glm::vec2> points) const {
+        generate(bounds, spacing, [points](size_t count){
+            if(points.size() != count) {
+                throw std::runtime_error{ "point buffer does not match the number of generated points" };
+            }
+            return points;
+        });
+    }
+
+    // works out how many points there are, asks allocate for room for them and writes them the way
+    // the span overload does. Generators that have to sample the whole domain to know the count
+    // (Poisson disk) only sample once here, count() followed by generate(span) samples twice
+    virtual void generate(const Bounds<L>& bounds, float spacing, const Allocate& allocate) const {
+        const auto offsets = rows(bounds, spacing).offsets;
+        const auto points = allocate(offsets.back());
+        forEachRow(offsets, points, [&](size_t j, std::span<glm::vec2> row){
+            this->row(bounds, spacing, j, row);
         });
+    }
 
-        return points;
+    [[nodiscard]]
+    virtual size_t count(const Bounds<L>& bounds, float spacing) const {
+        return rows(bounds, spacing).offsets.back();
     }
 
     virtual void forEachPoint(const Bounds<L>& bounds, float spacing, Callback callback) const = 0;
+
+protected:
+    // offsets holds the index of the first point of every row followed by the total number of points
+    struct Rows {
+        std::vector<size_t> offsets;
+    };
+
+    // generators without independent rows use the default, a single row produced by forEachPoint
+    [[nodiscard]]
+    virtual Rows rows(const Bounds<L>& bounds, float spacing) const {
+        size_t numPoints = 0;
+        forEachPoint(bounds, spacing, [&numPoints](const glm::vec2&){
+            numPoints++;
+            return true;
+        });
+        return { { 0, numPoints } };
+    }
+
+    virtual void row(const Bounds<L>& bounds, float spacing, size_t row, std::span<glm::vec2> points) const {
+        auto next = points.begin();
+        forEachPoint(bounds, spacing, [&next](const glm::vec2& point){
+            *next++ = point;
+            return true;
+        });
+    }
+
+    // calls fn(row, points of the row) for every row of offsets, rows are split over the workers
+    template<typename Fn>
+    static void forEachRow(const std::vector<size_t>& offsets, std::span<glm::vec2> points, Fn&& fn) {
+        const auto numRows = offsets.size() - 1;
+        if(points.empty()) {
+            return;
+        }
+        const auto numWorkers = std::min<size_t>(parallel::workers(points.size()), numRows);
+        parallel::run(static_cast<uint32_t>(numWorkers), [&](uint32_t worker){
+            const auto [first, last] = parallel::range(numRows, worker, numWorkers);
+            for(auto j = first; j < last; j++){
+                fn(j, points.subspan(offsets[j], offsets[j + 1] - offsets[j]));
+            }
+        });
+    }
 };
 
-using PointGenerator2D = PointGenerator<2>;
\ No newline at end of file
+using PointGenerator2D = PointGenerator<2>;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "point_generator2d.h"
+#include <cstdint>
+#include <vector>
+
+// Blue noise points no closer than spacing to each other (Bridson, "Fast Poisson disk sampling in
+// arbitrary dimensions"). A background grid with cells of spacing / sqrt(2) holds at most one point
+// per cell so every candidate is tested against a fixed number of neighbours.
+//
+// Active points are taken in the order they were added and retired after trying all their
+// candidates at once, instead of Bridson's random pick that retries a point until attempts
+// candidates in a row fail. Each point costs exactly attempts candidates.
+//
+// When tiled, the domain is cut into square tiles that are filled in four passes. Tiles of the same
+// pass are a whole tile apart and never read each other's cells, so they run in parallel. Each tile
+// draws from its own generator seeded with (seed, tile), the points are identical for any number of
+// threads and are reported tile by tile.
+class PoissonDiskPointGenerator2D final : public PointGenerator2D {
+public:
+    explicit PoissonDiskPointGenerator2D(uint32_t seed = 0, int attempts = 16, bool tiled = true);
+
+    using PointGenerator2D::generate;
+
+    // samples the domain once and copies the tiles into the allocated points in parallel
+    void generate(const Bounds2D& bounds, float spacing, const Allocate& allocate) const final;
+
+    // a full sampling pass, prefer the generate() overloads which size their output themselves
+    [[nodiscard]]
+    size_t count(const Bounds2D& bounds, float spacing) const final;
+
+    void forEachPoint(const Bounds2D &bounds, float spacing, Callback callback) const final;
+
+private:
+    using Tiles = std::vector<std::vector<glm::vec2>>;
+
+    [[nodiscard]]
+    Tiles sample(const Bounds2D& bounds, float spacing) const;
+
+    uint32_t m_seed;
+    int m_attempts;
+    bool m_tiled;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+// 2 MB page backing for large, randomly accessed buffers (particle columns, hash grid arrays) to cut
+// TLB misses. Opt-in at runtime, when enabled allocations of at least PageSize bytes first try
+// explicit huge pages (MAP_HUGETLB), then fall back to transparent huge pages (madvise) on a 2 MB
+// aligned mapping. Smaller allocations, disabled allocations and platforms without huge page
+// support go through operator new. Buffers keep the backing they were allocated with, toggle
+// before creating them.
+namespace hugepages {
+
+    constexpr size_t PageSize = size_t{2} << 20;
+
+    struct Stats {
+        size_t explicitBytes{};     // MAP_HUGETLB mappings
+        size_t transparentBytes{};  // 2 MB aligned mappings advised with MADV_HUGEPAGE
+    };
+
+    void enable();
+
+    void disable();
+
+    [[nodiscard]] bool enabled();
+
+    [[nodiscard]] void* allocate(size_t bytes);
+
+    void deallocate(void* ptr, size_t bytes);
+
+    // bytes currently held in huge page backed mappings
+    [[nodiscard]] Stats stats();
+
+    // std allocator for containers that should be huge page backed when enabled
+    template<typename T>
+    struct Allocator {
+        using value_type = T;
+
+        Allocator() = default;
+
+        template<typename U>
+        Allocator(const Allocator<U>&) {}
+
+        [[nodiscard]]
+        T* allocate(size_t n) {
+            return static_cast<T*>(hugepages::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) {
+            hugepages::deallocate(ptr, n * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const Allocator<U>&) const {
+            return true;
+        }
+    };
+}
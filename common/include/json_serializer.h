@@ -0,0 +1,83 @@
+#pragma once
+
+#include "snap.h"
+#include <daw/json/daw_json_link.h>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+    // typed snapshot visitor writing compact JSON, leaves are encoded by daw_json_link straight
+    // into the output buffer
+    class Writer {
+    public:
+        explicit Writer(std::string& out)
+        : m_out(out)
+        {}
+
+        template<snap::Value T>
+        void value(std::string_view name, const T& value) {
+            key(name);
+            write(value);
+        }
+
+        template<typename T>
+        void sequence(std::string_view name, snap::Sequence<T> values) {
+            key(name);
+            m_out.push_back('[');
+            for(auto i = 0u; i < values.size(); i++){
+                if(i != 0) m_out.push_back(',');
+                write(values[i]);
+            }
+            m_out.push_back(']');
+        }
+
+        template<typename T>
+        void object(std::string_view name, const T& object) {
+            key(name);
+            root(object);
+        }
+
+        template<typename T>
+        void root(const T& object) {
+            m_out.push_back('{');
+            m_first = true;
+            snap::describe(*this, object);
+            m_out.push_back('}');
+            m_first = false;
+        }
+
+    private:
+        void key(std::string_view name) {
+            if(!m_first) m_out.push_back(',');
+            m_first = false;
+            daw::json::to_json(name, std::back_inserter(m_out));
+            m_out.push_back(':');
+        }
+
+        template<typename T>
+        void write(const T& value) {
+            if constexpr (snap::Vector<T>) {
+                m_out.push_back('[');
+                for(auto i = 0; i < T::length(); i++){
+                    if(i != 0) m_out.push_back(',');
+                    daw::json::to_json(value[i], std::back_inserter(m_out));
+                }
+                m_out.push_back(']');
+            } else {
+                daw::json::to_json(value, std::back_inserter(m_out));
+            }
+        }
+
+        std::string& m_out;
+        bool m_first{true};
+    };
+
+    template<typename T>
+    auto serialize(const T& object) -> std::string {
+        std::string out;
+        Writer{out}.root(object);
+        return out;
+    }
+}
@@ -27,6 +27,12 @@ struct Bounds {
 };
 
 
+template<typename Visitor, glm::length_t L>
+void snapshotFields(Visitor& visitor, const Bounds<L>& bounds) {
+    visitor.value("lower", bounds.lower);
+    visitor.value("upper", bounds.upper);
+}
+
 template<glm::length_t L>
 auto random(Bounds<L>& bounds, uint32_t seed = std::random_device{}()){
     std::array<std::uniform_real_distribution<float>, L> dist;
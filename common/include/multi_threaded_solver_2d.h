@@ -1,6 +1,7 @@
 #pragma once
 
 #include "solver2d.h"
+#include "c_debug.h"
 #include "thread_pool/thread_pool.hpp"
 #include <vector>
 #include <istream>
@@ -34,11 +35,22 @@ public:
     
     void workerThreadResolveCollision(int id);
 
+    // moves the previous positions when the sub step changes, see VarletIntegrationSolver
+    void rescaleVelocity(float dt);
+
+    void save(checkpoint::Writer& writer) const override;
+
+    void restore(checkpoint::Reader& reader) override;
+
+protected:
+    Motion motion() override;
+
 private:
     UnBoundedSpacialHashGrid2D m_grid;
     int m_iterations{1};
     float m_damp{1.0};
     float m_radius;
+    float m_subStepDt{0};
     tp::ThreadPool m_threadPool;
     std::vector<glm::vec2> m_threadLocalParticles;
     std::vector<CollisionResolver<Layout>> m_resolvers;
@@ -99,6 +111,9 @@ public:
 
     void resolve() {
         const auto numParticles = m_solver->particles().size();
+        m_collisionCounter.reset();
+        // ghosts of the last sub step are kept for debug colouring, clearing keeps the capacity
+        threadGroup[0][m_id].clear();
 
 //    spdlog::info("worker({}) working on bounds({}, {})", m_id, m_bounds.lower, m_bounds.upper);
         auto vPositions = m_solver->particles().position();
@@ -139,21 +154,21 @@ public:
                     collisions++;
                 }
             }
-//            m_solver->collisionStats.average[m_solver->collisionStats.next++] = collisions;
-//            m_solver->collisionStats.max = glm::max(m_solver->collisionStats.max, collisions);
-//            m_solver->collisionStats.min = glm::min(m_solver->collisionStats.min, collisions);
-//
-//            m_solver->collisionStats.next %= m_solver->collisionStats.average.size();
-//            m_solver->collisionStats.total += collisions;
+            m_collisionCounter.add(collisions);
         }
     }
 
+    CollisionCounter& collisionCounter() {
+        return m_collisionCounter;
+    }
+
 private:
     uint32_t m_id;
     Bounds2D m_bounds;
     float m_gridSpacing;
     uint32_t m_numWorkers;
     MultiThreadedSolver<Layout>* m_solver;
+    CollisionCounter m_collisionCounter{};
     static thread_local std::vector<glm::vec2> local_positions;
     static thread_local std::vector<glm::vec2> local_ids;
     static thread_local size_t local_numParticles;
@@ -182,12 +197,62 @@ MultiThreadedSolver<Layout>::MultiThreadedSolver(std::shared_ptr<Particle2D<Layo
 
 template<template<typename> typename Layout>
 void MultiThreadedSolver<Layout>::solve(float dt) {
-    const auto sdt = dt/to<float>(m_iterations);
-    for(auto i = 0; i < m_iterations; i++){
+    const auto subSteps = this->subSteps(dt, m_iterations, m_radius * 2);
+    const auto sdt = dt/to<float>(subSteps);
+    rescaleVelocity(sdt);
+    for(auto i = 0u; i < subSteps; i++){
         subStep(sdt);
     }
 }
 
+template<template<typename> typename Layout>
+Motion MultiThreadedSolver<Layout>::motion() {
+    const auto velocity = this->particles().velocity();
+    const auto g = glm::dot(this->m_gravity, this->m_gravity);
+    return reduceMotion(this->particles().size()
+                        , [&](size_t i){ return glm::dot(velocity[i], velocity[i]); }
+                        , [&](size_t){ return g; }
+                        , [this](size_t count, auto&& fn){ m_threadPool.dispatch(to<uint32_t>(count), fn); });
+}
+
+template<template<typename> typename Layout>
+void MultiThreadedSolver<Layout>::rescaleVelocity(float dt) {
+    if(m_subStepDt != 0 && m_subStepDt != dt) {
+        const auto ratio = dt / m_subStepDt;
+        auto position = this->particles().position();
+        auto prevPosition = this->particles().previousPosition();
+        m_threadPool.dispatch(this->particles().size(), [&](const auto start, const auto end){
+            for(auto i = start; i < end; i++){
+                prevPosition[i] = position[i] - (position[i] - prevPosition[i]) * ratio;
+            }
+        });
+    }
+    m_subStepDt = dt;
+}
+
+template<template<typename> typename Layout>
+void MultiThreadedSolver<Layout>::save(checkpoint::Writer& writer) const {
+    Solver2D<Layout>::save(writer);
+    writer.section("multithreaded");
+    writer.write(m_iterations);
+    writer.write(m_damp);
+    writer.write(m_radius);
+    writer.write(m_subStepDt);
+}
+
+template<template<typename> typename Layout>
+void MultiThreadedSolver<Layout>::restore(checkpoint::Reader& reader) {
+    Solver2D<Layout>::restore(reader);
+    reader.section("multithreaded");
+    reader.read(m_iterations);
+    reader.read(m_damp);
+    // the collision resolvers partition the world by radius when the solver is constructed
+    if(reader.read<float>() != m_radius) {
+        throw std::runtime_error{ "checkpoint was saved with a different particle radius" };
+    }
+    reader.read(m_subStepDt);
+}
+
 template<template<typename> typename Layout>
 void MultiThreadedSolver<Layout>::subStep(float dt) {
     resolveCollision(dt);
@@ -227,6 +292,11 @@ void MultiThreadedSolver<Layout>::resolveCollision(float dt) {
     }
     m_threadPool.waitForCompletion();
 
+    CollisionCounter counter{};
+    for(auto& resolver : m_resolvers){
+        counter.merge(resolver.collisionCounter());
+    }
+    this->collisionStats.merge(counter);
 
     m_threadPool.dispatch(this->particles().size(), [this](const auto start, const auto end) {
         for (auto i = start; i < end; i++) {
@@ -302,6 +372,7 @@ void MultiThreadedSolver<Layout>::workerThreadResolveCollision(int id) {
 //    spdlog::info("worker({}) working on bounds({}, {})", id, bounds.lower, bounds.upper);
     auto vPositions = this->particles().position();
 
+    CollisionCounter counter{};
     for(int i = 0; i < numParticles; i++){
 
         auto& position = vPositions[i];
@@ -318,11 +389,7 @@ void MultiThreadedSolver<Layout>::workerThreadResolveCollision(int id) {
             if(i == j) continue;
             collisions += resolveCollision(i, j);
         }
-            this->collisionStats.average[this->collisionStats.next++] = collisions;
-            this->collisionStats.max = glm::max(this->collisionStats.max, collisions);
-            this->collisionStats.min = glm::min(this->collisionStats.min, collisions);
-
-            this->collisionStats.next %= this->collisionStats.average.size();
-            this->collisionStats.total += collisions;
+        counter.add(collisions);
     }
+    this->collisionStats.merge(counter);
 }
\ No newline at end of file
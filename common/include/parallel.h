@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// fork/join helpers for one off bulk work (scene setup, loading) that does not warrant keeping a
+// thread pool alive. Per frame work should go through the solver's tp::ThreadPool instead.
+namespace parallel {
+
+    // below this many elements per worker the threads cost more than they save
+    constexpr size_t MinWorkPerThread = 4096;
+
+    namespace detail {
+        inline std::atomic<uint32_t> concurrencyOverride{0};
+    }
+
+    [[nodiscard]]
+    inline uint32_t concurrency() {
+        if(const auto forced = detail::concurrencyOverride.load(std::memory_order_relaxed)) {
+            return forced;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // pretends the machine has numThreads hardware threads while alive, lets tests split work over
+    // several workers on any machine
+    class ScopedConcurrency {
+    public:
+        explicit ScopedConcurrency(uint32_t numThreads)
+        : m_previous(detail::concurrencyOverride.exchange(numThreads))
+        {}
+
+        ~ScopedConcurrency() {
+            detail::concurrencyOverride.store(m_previous);
+        }
+
+        ScopedConcurrency(const ScopedConcurrency&) = delete;
+        ScopedConcurrency& operator=(const ScopedConcurrency&) = delete;
+
+    private:
+        uint32_t m_previous;
+    };
+
+    [[nodiscard]]
+    inline uint32_t workers(size_t count, size_t minWorkPerThread = MinWorkPerThread) {
+        const auto wanted = std::max<size_t>(1, count / std::max<size_t>(1, minWorkPerThread));
+        return static_cast<uint32_t>(std::min<size_t>(wanted, concurrency()));
+    }
+
+    // the worker's share [begin, end) of count elements, shares are contiguous and in worker order
+    [[nodiscard]]
+    inline std::pair<size_t, size_t> range(size_t count, uint32_t worker, uint32_t numWorkers) {
+        const auto share = count / numWorkers;
+        const auto remainder = count % numWorkers;
+        const auto begin = worker * share + std::min<size_t>(worker, remainder);
+        return { begin, begin + share + (worker < remainder ? 1 : 0) };
+    }
+
+    // calls fn(worker) for every worker in [0, numWorkers), worker 0 runs on the calling thread
+    template<typename Fn>
+    void run(uint32_t numWorkers, Fn&& fn) {
+        if(numWorkers <= 1) {
+            fn(0u);
+            return;
+        }
+        std::vector<std::jthread> threads;
+        threads.reserve(numWorkers - 1);
+        for(uint32_t worker = 1; worker < numWorkers; worker++){
+            threads.emplace_back([&fn, worker]{ fn(worker); });
+        }
+        fn(0u);
+    }
+
+    // calls fn(begin, end) on contiguous ranges covering [0, count)
+    template<typename Fn>
+    void forEach(size_t count, Fn&& fn, size_t minWorkPerThread = MinWorkPerThread) {
+        const auto numWorkers = workers(count, minWorkPerThread);
+        run(numWorkers, [&](uint32_t worker){
+            const auto [begin, end] = range(count, worker, numWorkers);
+            fn(begin, end);
+        });
+    }
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "types.h"
+#include "snap.h"
+#include "parallel.h"
+#include "huge_pages.h"
 #include <glm/glm.hpp>
 #include <yaml-cpp/yaml.h>
 #include <memory>
@@ -13,6 +16,10 @@
 #include <memory>
 #include <algorithm>
 #include <numeric>
+#include <cstdint>
+#include <limits>
+#include <array>
+#include <new>
 
 enum class Field : int { Position = 0, PreviousPosition, Velocity, Mass, Restitution, Radius, Color };
 
@@ -55,6 +62,7 @@ struct Particles {
     using Layout = LayoutType<VecType>;
 
     using Members = Layout::Members;
+    using Block = Layout::Block;
 
     using Position = Layout::template View<VecType, Field::Position>;
     using PreviousPosition = Layout::template View<VecType, Field::PreviousPosition>;
@@ -101,27 +109,229 @@ struct Particles {
         return layout.capacity();
     };
 
-    void add(VecType pos, VecType vel, float invMass, float radius, float restitution) {
+    [[nodiscard]]
+    size_t available() const {
+        return capacity() - size();
+    }
+
+    // growable layouts allocate until count particles fit, returns whether they fit
+    bool reserve(size_t count) {
+        if constexpr (requires { layout.reserve(count); }) {
+            layout.reserve(count);
+        }
+        return count <= capacity();
+    }
+
+    // returns false without adding anything when there is no capacity left
+    bool add(VecType pos, VecType vel, float invMass, float radius, float restitution) {
+        if(!reserve(_internal.seekHead + 1)) {
+            return false;
+        }
         layout.add(pos, pos - pos * vel * 1e-4f, vel, invMass, radius, restitution, _internal.seekHead);
         _internal.seekHead++;
+        return true;
+    }
+
+    // adds as many of positions as there is capacity for, all with the same velocity and material.
+    // Returns the number of particles added
+    size_t add(std::span<const VecType> positions, VecType vel, float invMass, float radius, float restitution) {
+        reserve(size() + positions.size());
+        const auto count = std::min(positions.size(), available());
+        layout.assign(_internal.seekHead, positions.first(count), vel, invMass, radius, restitution);
+        _internal.seekHead += count;
+        return count;
+    }
+
+    // initialises particles [first, first + positions.size()) that were already reserved with
+    // append(), disjoint ranges may be assigned concurrently
+    void assign(size_t first, std::span<const VecType> positions, VecType vel, float invMass, float radius, float restitution) {
+        if(first + positions.size() > size()) {
+            throw std::runtime_error{ "assigning particles beyond size" };
+        }
+        layout.assign(first, positions, vel, invMass, radius, restitution);
+    }
+
+    // reserves the next count particles and returns writable storage for them, the caller has to
+    // initialise every field. Throws without reserving anything when count exceeds available()
+    [[nodiscard]]
+    Block append(size_t count) {
+        const auto first = _internal.seekHead;
+        extend(count);
+        return layout.block(first, count);
     }
 
+    // append() without handing out the storage, the particles are initialised with assign(). Does
+    // not allocate when count fits in available()
+    void extend(size_t count) {
+        if(!reserve(size() + count)) {
+            throw std::runtime_error{ "particle count exceeds capacity" };
+        }
+        _internal.seekHead += count;
+    }
+
+    // the layouts reorder their fields on their own and the dead flags would no longer line up, so
+    // sorting throws while any particle is dead. compact() first
     template<typename Comparator>
     void sort(Comparator&& comparator) {
+        const auto& dead = _internal.dead;
+        const auto end = dead.begin() + std::min(dead.size(), size());
+        if(std::find(dead.begin(), end, 1) != end) {
+            throw std::runtime_error{ "sorting particles while some are dead, compact() first" };
+        }
         layout.sort(_internal.seekHead, comparator);
     }
 
     void clear() {
         _internal.seekHead = 0;
+        std::fill(_internal.dead.begin(), _internal.dead.end(), 0);
+    }
+
+    // sets the number of live particles when the fields were populated directly (e.g. a loaded snapshot)
+    void resize(size_t size) {
+        if(!reserve(size)) {
+            throw std::runtime_error{ "particle count exceeds capacity" };
+        }
+        _internal.seekHead = size;
+        std::fill(_internal.dead.begin(), _internal.dead.end(), 0);
+    }
+
+    // remap[old index] is the index a particle moved to in compact(), or Removed
+    using Remap = std::vector<uint32_t>;
+    static constexpr uint32_t Removed = std::numeric_limits<uint32_t>::max();
+
+    // marks a particle dead, it keeps its slot and is still simulated until the next compact()
+    void kill(size_t index) {
+        if(index >= size()) {
+            throw std::runtime_error{ "killing particle beyond size" };
+        }
+        if(_internal.dead.size() < capacity()) {
+            _internal.dead.resize(capacity());
+        }
+        _internal.dead[index] = 1;
+    }
+
+    // kills every particle i for which dead(i) holds, returns the number of particles killed
+    template<typename Predicate>
+    size_t killIf(Predicate&& dead) {
+        const auto n = size();
+        if(_internal.dead.size() < capacity()) {
+            _internal.dead.resize(capacity());
+        }
+        const auto numWorkers = parallel::workers(n);
+        std::vector<size_t> killed(numWorkers);
+        parallel::run(numWorkers, [&](uint32_t worker){
+            const auto [begin, end] = parallel::range(n, worker, numWorkers);
+            for(auto i = begin; i < end; i++){
+                const uint8_t marked = dead(i) && !_internal.dead[i];
+                _internal.dead[i] |= marked;
+                killed[worker] += marked;
+            }
+        });
+        return std::accumulate(killed.begin(), killed.end(), size_t{0});
+    }
+
+    [[nodiscard]]
+    bool alive(size_t index) const {
+        return index < size() && (index >= _internal.dead.size() || !_internal.dead[index]);
+    }
+
+    // removes dead particles by moving the live particles at the end of the range into the slots of
+    // dead ones, so only as many particles are copied as were killed. Survivors below the new size
+    // keep their index, the returned table maps every old index to its new one so dependent arrays
+    // can follow (see applyRemap). Flags are scanned twice in parallel, fields are touched once
+    Remap compact() {
+        const auto n = size();
+        Remap remap(n);
+        auto& dead = _internal.dead;
+        if(dead.empty()) {
+            std::iota(remap.begin(), remap.end(), 0u);
+            return remap;
+        }
+        if(dead.size() < n) {
+            dead.resize(capacity());
+        }
+
+        const auto numWorkers = parallel::workers(n);
+        std::vector<size_t> deadBefore(numWorkers + 1);
+        parallel::run(numWorkers, [&](uint32_t worker){
+            const auto [begin, end] = parallel::range(n, worker, numWorkers);
+            deadBefore[worker + 1] = std::count(dead.begin() + begin, dead.begin() + end, 1);
+        });
+        std::partial_sum(deadBefore.begin(), deadBefore.end(), deadBefore.begin());
+
+        const auto newSize = n - deadBefore.back();
+        const auto deadInTail = to<size_t>(std::count(dead.begin() + newSize, dead.begin() + n, 1));
+        const auto holes = deadBefore.back() - deadInTail;
+
+        // hole k is the k-th dead particle below newSize, mover k the k-th live one above it
+        auto& moves = _internal.moves;
+        moves.resize(holes);
+        parallel::run(numWorkers, [&](uint32_t worker){
+            const auto [begin, end] = parallel::range(n, worker, numWorkers);
+            auto deadRank = deadBefore[worker];
+            for(auto i = begin; i < end; i++){
+                if(dead[i]) {
+                    remap[i] = Removed;
+                    if(i < newSize) moves[deadRank].second = to<uint32_t>(i);
+                    deadRank++;
+                    dead[i] = 0;
+                } else if(i < newSize) {
+                    remap[i] = to<uint32_t>(i);
+                } else {
+                    moves[(i - newSize) - (deadRank - holes)].first = to<uint32_t>(i);
+                }
+            }
+        });
+
+        parallel::forEach(holes, [&](size_t begin, size_t end){
+            for(auto k = begin; k < end; k++){
+                const auto [from, to] = moves[k];
+                layout.move(from, to);
+                remap[from] = to;
+            }
+        });
+
+        _internal.seekHead = newSize;
+        return remap;
+    }
+
+    template<typename Visitor>
+    void snapshot(Visitor& visitor) const {
+        const auto n = size();
+        visitor.value("size", n);
+        visitor.value("capacity", capacity());
+        visitor.sequence("position", layout.template sequence<VecType, Field::Position>(n));
+        visitor.sequence("previousPosition", layout.template sequence<VecType, Field::PreviousPosition>(n));
+        visitor.sequence("velocity", layout.template sequence<VecType, Field::Velocity>(n));
+        visitor.sequence("inverseMass", layout.template sequence<float, Field::Mass>(n));
+        visitor.sequence("restitution", layout.template sequence<float, Field::Restitution>(n));
+        visitor.sequence("radius", layout.template sequence<float, Field::Radius>(n));
     }
 
     struct {
         friend class Particles;
     private:
         size_t seekHead{};
+        std::vector<uint8_t> dead;
+        std::vector<std::pair<uint32_t, uint32_t>> moves;
     } _internal{};
 };
 
+// moves per particle values kept outside of Particles (densities, GPU staging buffers) the way
+// Particles::compact() moved the particles. Only particles moved into dead slots are copied, values
+// past the new size are left behind
+template<typename T>
+void applyRemap(std::span<T> values, std::span<const uint32_t> remap) {
+    parallel::forEach(remap.size(), [&](size_t begin, size_t end){
+        for(auto i = begin; i < end; i++){
+            const auto target = remap[i];
+            if(target != i && target != std::numeric_limits<uint32_t>::max()) {
+                values[target] = values[i];
+            }
+        }
+    });
+}
+
 template<typename VecType>
 struct InterleavedMemoryLayout {
     using Vec = VecType;
@@ -165,6 +375,8 @@ struct InterleavedMemoryLayout {
     };
 
     using Members = MembersType;
+    // fields are interleaved so a block is a run of whole particles
+    using Block = std::span<Members>;
     static constexpr auto Width = sizeof(Members) ;
 
     Members* data{};
@@ -184,6 +396,12 @@ struct InterleavedMemoryLayout {
         throw std::runtime_error{ "invalid field" };
     }
 
+    template<typename ValueType, Field field>
+    [[nodiscard]]
+    snap::Sequence<ValueType> sequence(size_t size) const {
+        return { as<const ValueType>(as<const char>(data) + get<field>()), size, sizeof(Members) };
+    }
+
     auto position(size_t size) const {
         return View<VecType, Field::Position>{ *this, size };
     }
@@ -219,6 +437,23 @@ struct InterleavedMemoryLayout {
         data[index].restitution = restitution;
     }
 
+    void assign(size_t first, std::span<const VecType> positions, VecType vel, float invMass, float radius, float restitution) {
+        assert(first + positions.size() <= _capacity);
+        auto rows = block(first, positions.size());
+        for(auto i = 0u; i < positions.size(); i++){
+            rows[i] = { positions[i], positions[i] - positions[i] * vel * 1e-4f, vel, invMass, restitution, radius };
+        }
+    }
+
+    [[nodiscard]]
+    Block block(size_t first, size_t count) const {
+        return { data + first, count };
+    }
+
+    void move(size_t from, size_t to) {
+        data[to] = data[from];
+    }
+
     [[nodiscard]] size_t capacity() const {
         return _capacity;
     }
@@ -245,6 +480,8 @@ struct SeparateFieldMemoryLayout {
     };
 
     using Members = MemberType;
+    // one span per field covering the same run of particles
+    using Block = MemberType;
     static constexpr auto Width = (sizeof(Vec) + sizeof(float)) * 3;
 
     Members data{};
@@ -302,9 +539,8 @@ struct SeparateFieldMemoryLayout {
     class View{
     public:
 
-        View(SeparateFieldMemoryLayout layout, size_t size = std::numeric_limits<size_t>::max())
-                : m_layout{layout}
-                , m_ptr(layout.get<ValueType, field>())
+        View(const SeparateFieldMemoryLayout& layout, size_t size = std::numeric_limits<size_t>::max())
+                : m_ptr(layout.get<ValueType, field>())
                 , m_size{ size }
         {}
 
@@ -317,7 +553,6 @@ struct SeparateFieldMemoryLayout {
         }
 
     private:
-        SeparateFieldMemoryLayout m_layout{};
         ValueType* m_ptr{0};
         size_t m_size{};
 
@@ -339,6 +574,12 @@ struct SeparateFieldMemoryLayout {
         throw std::runtime_error{ "invalid field" };
     }
 
+    template<typename ValueType, Field field>
+    [[nodiscard]]
+    snap::Sequence<ValueType> sequence(size_t size) const {
+        return { get<ValueType, field>(), size };
+    }
+
     auto position(size_t size) const {
         return View<VecType, Field::Position>{ *this, size };
     }
@@ -374,6 +615,38 @@ struct SeparateFieldMemoryLayout {
         data.restitution[index] = restitution;
     }
 
+    void assign(size_t first, std::span<const VecType> positions, VecType vel, float invMass, float radius, float restitution) {
+        assert(first + positions.size() <= capacity());
+        auto columns = block(first, positions.size());
+        std::copy(positions.begin(), positions.end(), columns.position.begin());
+        std::transform(positions.begin(), positions.end(), columns.prePosition.begin(), [vel](const VecType& p){ return p - p * vel * 1e-4f; });
+        std::fill(columns.velocity.begin(), columns.velocity.end(), vel);
+        std::fill(columns.inverseMass.begin(), columns.inverseMass.end(), invMass);
+        std::fill(columns.restitution.begin(), columns.restitution.end(), restitution);
+        std::fill(columns.radius.begin(), columns.radius.end(), radius);
+    }
+
+    [[nodiscard]]
+    Block block(size_t first, size_t count) const {
+        return {
+            data.position.subspan(first, count),
+            data.prePosition.subspan(first, count),
+            data.velocity.subspan(first, count),
+            data.inverseMass.subspan(first, count),
+            data.restitution.subspan(first, count),
+            data.radius.subspan(first, count)
+        };
+    }
+
+    void move(size_t from, size_t to) {
+        data.position[to] = data.position[from];
+        data.prePosition[to] = data.prePosition[from];
+        data.velocity[to] = data.velocity[from];
+        data.inverseMass[to] = data.inverseMass[from];
+        data.restitution[to] = data.restitution[from];
+        data.radius[to] = data.radius[from];
+    }
+
     [[nodiscard]]
     size_t capacity() const {
         return data.position.size();
@@ -392,13 +665,243 @@ struct SeparateFieldMemoryLayout {
     }
 
 private:
-    std::vector<char> memory;
+    // huge page backed when hugepages::enabled() at construction
+    std::vector<char, hugepages::Allocator<char>> memory;
     std::vector<int> indexes;
 
 };
 
+// fields stored in chunks of ChunkSize particles, each chunk is one cache aligned allocation holding
+// a column per field. Growing adds chunks and never moves a particle, so views stay valid and
+// capacity is only limited by memory. Views index through a per field chunk table, hot loops should
+// walk forEachChunk() and stay contiguous within a chunk. SphSolver2D runs over it (tested against
+// the separate field layout) but still goes through the views, no solver loop walks chunks yet
+template<typename VecType>
+struct PagedMemoryLayout {
+    using Vec = VecType;
+
+    static constexpr size_t ChunkShift = 12;
+    static constexpr size_t ChunkSize = size_t{1} << ChunkShift;
+    static constexpr size_t ChunkMask = ChunkSize - 1;
+    static constexpr size_t Alignment = 64;
+    static constexpr auto Width = (sizeof(Vec) + sizeof(float)) * 3;
+    static constexpr auto NumFields = 6;
+
+    using Columns = SeparateFieldMemoryLayout<Vec>::MemberType;
+    using Members = Columns;
+    // a reserved range may straddle chunks, one set of columns per chunk it touches
+    using Block = std::vector<Columns>;
+
+    PagedMemoryLayout()
+    : m_storage(std::make_shared<Storage>())
+    {}
+
+    explicit PagedMemoryLayout(size_t capacity)
+    : PagedMemoryLayout()
+    {
+        reserve(capacity);
+    }
+
+    template<typename ValueType, Field field>
+    class View{
+    public:
+
+        explicit View(const PagedMemoryLayout& layout)
+                : m_chunks(&layout.m_storage->fields[to<int>(field)])
+        {}
+
+        ValueType& operator[](int id) {
+            return as<ValueType>((*m_chunks)[to<size_t>(id) >> ChunkShift])[to<size_t>(id) & ChunkMask];
+        }
+
+        ValueType& operator[](int id) const {
+            return as<ValueType>((*m_chunks)[to<size_t>(id) >> ChunkShift])[to<size_t>(id) & ChunkMask];
+        }
+
+    private:
+        const std::vector<std::byte*>* m_chunks{};
+    };
+
+    // allocates chunks until capacity() >= count
+    void reserve(size_t count) {
+        auto& storage = *m_storage;
+        while(capacity() < count){
+            auto chunk = static_cast<std::byte*>(::operator new[](ChunkSize * Width, std::align_val_t{ Alignment }));
+            storage.chunks.emplace_back(chunk);
+            size_t offset = 0;
+            for(auto field = 0; field < NumFields; field++){
+                storage.fields[field].push_back(chunk + offset);
+                offset += ChunkSize * (field < 3 ? sizeof(Vec) : sizeof(float));
+            }
+        }
+    }
+
+    [[nodiscard]]
+    size_t capacity() const {
+        return m_storage->chunks.size() * ChunkSize;
+    }
+
+    [[nodiscard]]
+    size_t numChunks() const {
+        return m_storage->chunks.size();
+    }
+
+    // the columns of particles [first, first + count) within chunk, first and count are chunk relative
+    [[nodiscard]]
+    Columns columns(size_t chunk, size_t first, size_t count) const {
+        const auto& fields = m_storage->fields;
+        return {
+            { as<Vec>(fields[0][chunk]) + first, count },
+            { as<Vec>(fields[1][chunk]) + first, count },
+            { as<Vec>(fields[2][chunk]) + first, count },
+            { as<float>(fields[3][chunk]) + first, count },
+            { as<float>(fields[4][chunk]) + first, count },
+            { as<float>(fields[5][chunk]) + first, count }
+        };
+    }
+
+    // calls fn(first, columns) for every chunk holding particles [0, size), columns cover the
+    // particles of that chunk starting at index first
+    template<typename Fn>
+    void forEachChunk(size_t size, Fn&& fn) const {
+        for(size_t first = 0; first < size; first += ChunkSize){
+            fn(first, columns(first >> ChunkShift, 0, std::min(ChunkSize, size - first)));
+        }
+    }
+
+    [[nodiscard]]
+    Block block(size_t first, size_t count) const {
+        Block block;
+        for(auto end = first + count; first < end;){
+            const auto offset = first & ChunkMask;
+            const auto n = std::min(ChunkSize - offset, end - first);
+            block.push_back(columns(first >> ChunkShift, offset, n));
+            first += n;
+        }
+        return block;
+    }
+
+    template<typename ValueType, Field field>
+    [[nodiscard]]
+    ValueType* get(size_t index) const {
+        return as<ValueType>(m_storage->fields[to<int>(field)][index >> ChunkShift]) + (index & ChunkMask);
+    }
+
+    // visits the field in place through its chunk table, valid until chunks are added
+    template<typename ValueType, Field field>
+    [[nodiscard]]
+    snap::Sequence<ValueType> sequence(size_t size) const {
+        return { m_storage->fields[to<int>(field)].data(), ChunkShift, size };
+    }
+
+    auto position(size_t) const {
+        return View<VecType, Field::Position>{ *this };
+    }
+
+    auto previousPosition(size_t) const {
+        return View<VecType, Field::PreviousPosition>{ *this };
+    }
+
+    auto velocity(size_t) const {
+        return View<VecType, Field::Velocity>{ *this };
+    }
+
+    auto inverseMass(size_t) const {
+        return View<float, Field::Mass>{ *this };
+    }
+
+    auto restitution(size_t) const {
+        return View<float, Field::Restitution>{ *this };
+    }
+
+    auto radius(size_t) const {
+        return View<float, Field::Radius>{ *this };
+    }
+
+    void add(VecType pos, VecType prevPos, VecType vel, float invMass, float radius, float restitution, int index) {
+        assert(index >= 0 && index < capacity());
+        *get<Vec, Field::Position>(index) = pos;
+        *get<Vec, Field::PreviousPosition>(index) = prevPos;
+        *get<Vec, Field::Velocity>(index) = vel;
+        *get<float, Field::Mass>(index) = invMass;
+        *get<float, Field::Radius>(index) = radius;
+        *get<float, Field::Restitution>(index) = restitution;
+    }
+
+    void assign(size_t first, std::span<const VecType> positions, VecType vel, float invMass, float radius, float restitution) {
+        assert(first + positions.size() <= capacity());
+        for(const auto& columns : block(first, positions.size())){
+            const auto chunk = positions.first(columns.position.size());
+            std::copy(chunk.begin(), chunk.end(), columns.position.begin());
+            std::transform(chunk.begin(), chunk.end(), columns.prePosition.begin(), [vel](const VecType& p){ return p - p * vel * 1e-4f; });
+            std::fill(columns.velocity.begin(), columns.velocity.end(), vel);
+            std::fill(columns.inverseMass.begin(), columns.inverseMass.end(), invMass);
+            std::fill(columns.restitution.begin(), columns.restitution.end(), restitution);
+            std::fill(columns.radius.begin(), columns.radius.end(), radius);
+            positions = positions.subspan(chunk.size());
+        }
+    }
+
+    void move(size_t from, size_t to) {
+        *get<Vec, Field::Position>(to) = *get<Vec, Field::Position>(from);
+        *get<Vec, Field::PreviousPosition>(to) = *get<Vec, Field::PreviousPosition>(from);
+        *get<Vec, Field::Velocity>(to) = *get<Vec, Field::Velocity>(from);
+        *get<float, Field::Mass>(to) = *get<float, Field::Mass>(from);
+        *get<float, Field::Restitution>(to) = *get<float, Field::Restitution>(from);
+        *get<float, Field::Radius>(to) = *get<float, Field::Radius>(from);
+    }
+
+    // orders particles [0, size) by comparator(i, j) on their current indexes, every field is
+    // gathered into the scratch buffer in the new order and copied back
+    template<typename Comparator>
+    void sort(size_t size, Comparator&& comparator) {
+        std::vector<int> order(size);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), comparator);
+
+        permute<Vec, Field::Position>(order);
+        permute<Vec, Field::PreviousPosition>(order);
+        permute<Vec, Field::Velocity>(order);
+        permute<float, Field::Mass>(order);
+        permute<float, Field::Restitution>(order);
+        permute<float, Field::Radius>(order);
+    }
+
+private:
+    template<typename ValueType, Field field>
+    void permute(std::span<const int> order) {
+        auto& scratch = m_storage->scratch[to<int>(field)];
+        scratch.resize(order.size() * sizeof(ValueType));
+        auto gathered = as<ValueType>(scratch.data());
+        for(auto i = 0u; i < order.size(); i++){
+            gathered[i] = *get<ValueType, field>(to<size_t>(order[i]));
+        }
+        for(size_t first = 0; first < order.size(); first += ChunkSize){
+            std::copy_n(gathered + first, std::min(ChunkSize, order.size() - first), get<ValueType, field>(first));
+        }
+    }
+
+    struct AlignedDelete {
+        void operator()(std::byte* chunk) const {
+            ::operator delete[](chunk, std::align_val_t{ Alignment });
+        }
+    };
+
+    // shared by copies of the layout so views and copies of Particles see chunks added later
+    struct Storage {
+        std::array<std::vector<std::byte*>, NumFields> fields;
+        std::vector<std::unique_ptr<std::byte[], AlignedDelete>> chunks;
+        std::array<std::vector<std::byte>, NumFields> scratch;
+    };
+
+    std::shared_ptr<Storage> m_storage;
+};
+
 using InterleavedMemoryLayout2D = InterleavedMemoryLayout<glm::vec2>;
 using SeparateFieldMemoryLayout2D = SeparateFieldMemoryLayout<glm::vec2>;
+using PagedMemoryLayout2D = PagedMemoryLayout<glm::vec2>;
+
+using SeparateFieldMemoryLayout3D = SeparateFieldMemoryLayout<glm::vec3>;
 
 template<template<typename> typename Layout>
 using Particle2D = Particles<2, Layout>;
@@ -413,6 +916,13 @@ using SeparateFieldParticles = Particles<L, SeparateFieldMemoryLayout>;
 
 using SeparateFieldParticle2D = Particles<2, SeparateFieldMemoryLayout>;
 
+using SeparateFieldParticle3D = Particles<3, SeparateFieldMemoryLayout>;
+
+template<glm::length_t L>
+using PagedParticles = Particles<L, PagedMemoryLayout>;
+
+using PagedParticle2D = Particles<2, PagedMemoryLayout>;
+
 using ProtoTypeParticle2D = InterleavedMemoryLayout2D::Members;
 
 template<glm::length_t L>
@@ -468,6 +978,20 @@ inline std::shared_ptr<SeparateFieldParticle2D> createSeparateFieldParticle2DPtr
     return std::make_shared<SeparateFieldParticle2D>( particles );
 }
 
+inline std::shared_ptr<SeparateFieldParticle3D> createSeparateFieldParticle3DPtr(std::span<char> memory){
+    auto particles = SeparateFieldParticle3D{ { memory } };
+    return std::make_shared<SeparateFieldParticle3D>( particles );
+}
+
+// starts with enough chunks for capacity particles and grows as particles are added
+inline PagedParticle2D createPagedParticle2D(size_t capacity = 0){
+    return { PagedMemoryLayout2D{ capacity } };
+}
+
+inline std::shared_ptr<PagedParticle2D> createPagedParticle2DPtr(size_t capacity = 0){
+    return std::make_shared<PagedParticle2D>( createPagedParticle2D(capacity) );
+}
+
 template<template<typename> typename Layout>
 inline YAML::Emitter& operator<<(YAML::Emitter& emitter, const Particle2D<Layout>& particles) {
     emitter << YAML::BeginMap;
@@ -3,6 +3,7 @@
 #include "particle.h"
 #include "emitter/emitter.h"
 #include <memory>
+#include <utility>
 
 template<template<typename> typename Layout>
 struct ParticlePointConsumer {
@@ -23,6 +24,29 @@ struct ParticlePointConsumer {
         m_particles->add(position, velocity, m_prototype.inverseMass, m_prototype.radius, m_prototype.restitution);
     }
 
+    // adds as many of positions as there is capacity for, returns the number added
+    size_t use(std::span<const glm::vec2> positions, const glm::vec2& velocity = glm::vec2{0}) {
+        return m_particles->add(positions, velocity, m_prototype.inverseMass, m_prototype.radius, m_prototype.restitution);
+    }
+
+    // makes room for count more particles, growable layouts allocate here
+    void reserve(size_t count) {
+        m_particles->reserve(m_particles->size() + count);
+    }
+
+    // claims up to count particles of the room made by reserve() without allocating, returns the
+    // index of the first one and how many were claimed. Claimed particles are initialised with assign()
+    std::pair<size_t, size_t> claim(size_t count) {
+        const auto first = m_particles->size();
+        count = std::min(count, m_particles->available());
+        m_particles->extend(count);
+        return { first, count };
+    }
+
+    void assign(size_t first, std::span<const glm::vec2> positions, const glm::vec2& velocity = glm::vec2{0}) {
+        m_particles->assign(first, positions, velocity, m_prototype.inverseMass, m_prototype.radius, m_prototype.restitution);
+    }
+
     float offset(float deltaTime) {
         return m_prototype.radius * 1.25f;
     }
@@ -79,6 +103,28 @@ public:
         m_currentTime = 0;
     }
 
+    virtual void save(checkpoint::Writer& writer) const {
+        writer.section("particle_emitter");
+        writer.write(m_enabled);
+        writer.write(m_currentTime);
+        writer.write(static_cast<bool>(m_emitter));
+        if(m_emitter){
+            m_emitter->save(writer);
+        }
+    }
+
+    virtual void restore(checkpoint::Reader& reader) {
+        reader.section("particle_emitter");
+        reader.read(m_enabled);
+        reader.read(m_currentTime);
+        if(reader.read<bool>() != static_cast<bool>(m_emitter)) {
+            throw std::runtime_error{ "checkpoint was saved from a different type of emitter" };
+        }
+        if(m_emitter){
+            m_emitter->restore(reader);
+        }
+    }
+
 protected:
     auto target() {
         return m_consumer.m_particles;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "particle.h"
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <vector>
+
+// remaining lifetime of every particle, kept next to Particles as a dependent array. Particles added
+// since the last update get the default lifetime, expired ones are killed and disappear with the
+// next Particles::compact(), after which remap() keeps the lifetimes aligned with the particles
+class ParticleLifetime {
+public:
+    explicit ParticleLifetime(float lifetime = std::numeric_limits<float>::infinity())
+    : m_lifetime(lifetime)
+    {}
+
+    // ages every particle by deltaTime and kills the ones that expired, returns the number killed.
+    // Runs every frame, so it is one serial pass instead of starting threads
+    template<glm::length_t L, template<typename> typename Layout>
+    size_t update(Particles<L, Layout>& particles, float deltaTime) {
+        const auto n = particles.size();
+        if(m_remaining.size() < n) {
+            m_remaining.resize(n);
+        }
+        std::fill(m_remaining.begin() + std::min(m_size, n), m_remaining.begin() + n, m_lifetime);
+        m_size = n;
+
+        size_t killed = 0;
+        for(size_t i = 0; i < n; i++){
+            m_remaining[i] -= deltaTime;
+            if(m_remaining[i] <= 0 && particles.alive(i)) {
+                particles.kill(i);
+                killed++;
+            }
+        }
+        return killed;
+    }
+
+    void remap(std::span<const uint32_t> remap) {
+        applyRemap(std::span<float>{ m_remaining }, remap);
+        m_size = std::count_if(remap.begin(), remap.end(), [](auto index){ return index != std::numeric_limits<uint32_t>::max(); });
+    }
+
+    [[nodiscard]]
+    std::span<const float> remaining() const {
+        return { m_remaining.data(), m_size };
+    }
+
+    void clear() {
+        m_size = 0;
+    }
+
+private:
+    std::vector<float> m_remaining;
+    size_t m_size{};
+    float m_lifetime;
+};
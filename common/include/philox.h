@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Philox2x32-10 counter based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// The n-th random number is a pure function of (key, n), there is no state to advance or share,
+// so any range of a stream can be drawn by any thread in any order and always yields the same values.
+namespace philox {
+
+    using Result = std::array<uint32_t, 2>;
+
+    constexpr uint32_t Multiplier = 0xD256D193u;
+    constexpr uint32_t KeyIncrement = 0x9E3779B9u;
+    constexpr int Rounds = 10;
+
+    constexpr Result philox2x32(uint64_t counter, uint32_t key) {
+        auto lo = static_cast<uint32_t>(counter);
+        auto hi = static_cast<uint32_t>(counter >> 32);
+        for(int round = 0; round < Rounds; round++){
+            const auto product = uint64_t{ Multiplier } * lo;
+            lo = static_cast<uint32_t>(product >> 32) ^ key ^ hi;
+            hi = static_cast<uint32_t>(product);
+            key += KeyIncrement;
+        }
+        return { lo, hi };
+    }
+
+    // the upper 24 bits mapped to [0, 1), every value is exactly representable as a float
+    constexpr float uniform(uint32_t bits) {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // random numbers keyed by a seed and indexed by e.g. a particle index
+    class Stream {
+    public:
+        constexpr Stream() = default;
+
+        constexpr explicit Stream(uint32_t seed)
+        : m_seed(seed)
+        {}
+
+        [[nodiscard]]
+        constexpr Result operator()(uint64_t index) const {
+            return philox2x32(index, m_seed);
+        }
+
+        [[nodiscard]]
+        constexpr float uniform(uint64_t index) const {
+            return philox::uniform(philox2x32(index, m_seed)[0]);
+        }
+
+        [[nodiscard]]
+        constexpr uint32_t seed() const {
+            return m_seed;
+        }
+
+    private:
+        uint32_t m_seed{};
+    };
+}
@@ -1,4 +1,5 @@
 #pragma once
 
 #include "generator/grid_point_generator2d.h"
-#include "generator/triangle_point_generator2d.h"
\ No newline at end of file
+#include "generator/triangle_point_generator2d.h"
+#include "generator/poisson_disk_point_generator2d.h"
\ No newline at end of file
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "sdf2d.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
+
+// Compile time composition of the signed distance functions in sdf2d.h
+//
+//  auto shape = csg::smoothUnion(csg::Plane{3.f}, csg::Circle{{10, 18}, 1.5f}, 0.5f) - csg::Box{{10, 2}, {1, 1}};
+//
+// every shape and operation is a plain value type, a composite is one inlinable expression. Shapes
+// are written once against a generic scalar so the same expression evaluates a single point or a
+// Pack of points at once, see evaluate(). Sdf erases the type for scenes configured at runtime.
+namespace csg {
+
+    // one float per lane, operations are fixed length loops the compiler turns into SIMD
+    template<size_t W>
+    struct Pack {
+        static constexpr size_t Width = W;
+        float v[W];
+
+        static Pack splat(float s) {
+            Pack r;
+            for(size_t i = 0; i < W; i++) r.v[i] = s;
+            return r;
+        }
+
+        Pack() = default;
+
+        Pack(float s) : Pack(splat(s)) {}
+
+#define CSG_PACK_BINARY_OP(op) \
+        friend Pack operator op(const Pack& a, const Pack& b) { Pack r; for(size_t i = 0; i < W; i++) r.v[i] = a.v[i] op b.v[i]; return r; } \
+        friend Pack operator op(const Pack& a, float b) { Pack r; for(size_t i = 0; i < W; i++) r.v[i] = a.v[i] op b; return r; } \
+        friend Pack operator op(float a, const Pack& b) { Pack r; for(size_t i = 0; i < W; i++) r.v[i] = a op b.v[i]; return r; }
+
+        CSG_PACK_BINARY_OP(+)
+        CSG_PACK_BINARY_OP(-)
+        CSG_PACK_BINARY_OP(*)
+        CSG_PACK_BINARY_OP(/)
+#undef CSG_PACK_BINARY_OP
+
+        friend Pack operator-(const Pack& a) { Pack r; for(size_t i = 0; i < W; i++) r.v[i] = -a.v[i]; return r; }
+    };
+
+    constexpr size_t BatchWidth = 8;
+    using Batch = Pack<BatchWidth>;
+
+    // scalar functions shared by float and Pack so shapes are written once
+    inline float min(float a, float b) { return a < b ? a : b; }
+    inline float max(float a, float b) { return a > b ? a : b; }
+    inline float abs(float a) { return std::abs(a); }
+    inline float sqrt(float a) { return std::sqrt(a); }
+
+    template<size_t W>
+    Pack<W> min(const Pack<W>& a, const Pack<W>& b) { Pack<W> r; for(size_t i = 0; i < W; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+
+    template<size_t W>
+    Pack<W> max(const Pack<W>& a, const Pack<W>& b) { Pack<W> r; for(size_t i = 0; i < W; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+
+    template<size_t W>
+    Pack<W> abs(const Pack<W>& a) { Pack<W> r; for(size_t i = 0; i < W; i++) r.v[i] = std::abs(a.v[i]); return r; }
+
+    template<size_t W>
+    Pack<W> sqrt(const Pack<W>& a) { Pack<W> r; for(size_t i = 0; i < W; i++) r.v[i] = std::sqrt(a.v[i]); return r; }
+
+    template<typename T>
+    T clamp(const T& a, const T& lo, const T& hi) { return min(max(a, lo), hi); }
+
+    template<typename T>
+    T length(const T& x, const T& y) { return sqrt(x * x + y * y); }
+
+    // base of every shape, operators are only offered for types deriving from it
+    template<typename Derived>
+    struct Expression {
+        float operator()(const glm::vec2& point) const {
+            return static_cast<const Derived&>(*this).distance(point.x, point.y);
+        }
+    };
+
+    template<typename T>
+    concept Shape = std::derived_from<T, Expression<T>>;
+
+    // primitives, the same distances as sdfCircle, sdBox and sdfPlane
+
+    struct Circle : Expression<Circle> {
+        Circle(glm::vec2 center, float radius) : center(center), radius(radius) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return length(x - center.x, y - center.y) - radius;
+        }
+
+        glm::vec2 center;
+        float radius;
+    };
+
+    struct Box : Expression<Box> {
+        Box(glm::vec2 center, glm::vec2 halfExtent) : center(center), halfExtent(halfExtent) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            const T dx = abs(x - center.x) - halfExtent.x;
+            const T dy = abs(y - center.y) - halfExtent.y;
+            const T zero{0.f};
+            return length(max(dx, zero), max(dy, zero)) + min(max(dx, dy), zero);
+        }
+
+        glm::vec2 center;
+        glm::vec2 halfExtent;
+    };
+
+    // solid below y = height
+    struct Plane : Expression<Plane> {
+        explicit Plane(float height) : height(height) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return y - height;
+        }
+
+        float height;
+    };
+
+    // no surface, every point is infinitely far outside
+    struct Empty : Expression<Empty> {
+        template<typename T>
+        T distance(const T&, const T&) const {
+            return T{ std::numeric_limits<float>::infinity() };
+        }
+    };
+
+    // boolean operations
+
+    template<Shape A, Shape B>
+    struct Union : Expression<Union<A, B>> {
+        Union(A a, B b) : a(std::move(a)), b(std::move(b)) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return min(a.distance(x, y), b.distance(x, y));
+        }
+
+        A a;
+        B b;
+    };
+
+    template<Shape A, Shape B>
+    struct Intersection : Expression<Intersection<A, B>> {
+        Intersection(A a, B b) : a(std::move(a)), b(std::move(b)) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return max(a.distance(x, y), b.distance(x, y));
+        }
+
+        A a;
+        B b;
+    };
+
+    template<Shape A, Shape B>
+    struct Difference : Expression<Difference<A, B>> {
+        Difference(A a, B b) : a(std::move(a)), b(std::move(b)) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return max(a.distance(x, y), -b.distance(x, y));
+        }
+
+        A a;
+        B b;
+    };
+
+    // polynomial smooth minimum, blends the shapes over a band of width k
+    template<Shape A, Shape B>
+    struct SmoothUnion : Expression<SmoothUnion<A, B>> {
+        SmoothUnion(A a, B b, float k) : a(std::move(a)), b(std::move(b)), k(k) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            const T da = a.distance(x, y);
+            const T db = b.distance(x, y);
+            const T h = clamp(T{0.5f} + 0.5f * (db - da) / k, T{0.f}, T{1.f});
+            return db + (da - db) * h - k * h * (1.f - h);
+        }
+
+        A a;
+        B b;
+        float k;
+    };
+
+    // transforms
+
+    template<Shape S>
+    struct Translate : Expression<Translate<S>> {
+        Translate(S shape, glm::vec2 offset) : shape(std::move(shape)), offset(offset) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return shape.distance(x - offset.x, y - offset.y);
+        }
+
+        S shape;
+        glm::vec2 offset;
+    };
+
+    // rotates counter clockwise about the origin
+    template<Shape S>
+    struct Rotate : Expression<Rotate<S>> {
+        Rotate(S shape, float angleRad) : shape(std::move(shape)), c(std::cos(angleRad)), s(std::sin(angleRad)) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return shape.distance(c * x + s * y, c * y - s * x);
+        }
+
+        S shape;
+        float c;
+        float s;
+    };
+
+    // uniform scale about the origin, distances stay exact
+    template<Shape S>
+    struct Scale : Expression<Scale<S>> {
+        Scale(S shape, float factor) : shape(std::move(shape)), factor(factor), inverse(1.f / factor) {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return shape.distance(x * inverse, y * inverse) * factor;
+        }
+
+        S shape;
+        float factor;
+        float inverse;
+    };
+
+    template<Shape A, Shape B>
+    Union<A, B> operator|(A a, B b) { return { std::move(a), std::move(b) }; }
+
+    template<Shape A, Shape B>
+    Intersection<A, B> operator&(A a, B b) { return { std::move(a), std::move(b) }; }
+
+    template<Shape A, Shape B>
+    Difference<A, B> operator-(A a, B b) { return { std::move(a), std::move(b) }; }
+
+    template<Shape A, Shape B>
+    SmoothUnion<A, B> smoothUnion(A a, B b, float k) { return { std::move(a), std::move(b), k }; }
+
+    template<Shape S>
+    Translate<S> translate(S shape, glm::vec2 offset) { return { std::move(shape), offset }; }
+
+    template<Shape S>
+    Rotate<S> rotate(S shape, float angleRad) { return { std::move(shape), angleRad }; }
+
+    template<Shape S>
+    Scale<S> scale(S shape, float factor) { return { std::move(shape), factor }; }
+
+    // signed distance of every point, BatchWidth points at a time with a scalar tail
+    template<Shape S>
+    void evaluate(const S& shape, std::span<const glm::vec2> points, std::span<float> distance) {
+        const auto n = points.size();
+        size_t i = 0;
+        for(; i + BatchWidth <= n; i += BatchWidth){
+            Batch x, y;
+            for(size_t k = 0; k < BatchWidth; k++){
+                x.v[k] = points[i + k].x;
+                y.v[k] = points[i + k].y;
+            }
+            const Batch d = shape.distance(x, y);
+            for(size_t k = 0; k < BatchWidth; k++){
+                distance[i + k] = d.v[k];
+            }
+        }
+        for(; i < n; i++){
+            distance[i] = shape.distance(points[i].x, points[i].y);
+        }
+    }
+
+    // type erased shape for scenes assembled at runtime, one virtual call per point or per batch
+    // of points. Sdfs compose with each other and with static shapes, a default constructed Sdf is
+    // Empty and converts to false
+    class Sdf : public Expression<Sdf> {
+    public:
+        Sdf()
+        : m_shape(empty())
+        {}
+
+        template<typename S>
+        requires (!std::same_as<S, Sdf> && Shape<S>)
+        Sdf(S shape)
+        : m_shape(std::make_shared<Model<S>>(std::move(shape)))
+        {}
+
+        template<typename T>
+        T distance(const T& x, const T& y) const {
+            return m_shape->distance(x, y);
+        }
+
+        void evaluate(std::span<const glm::vec2> points, std::span<float> distance) const {
+            m_shape->evaluate(points, distance);
+        }
+
+        explicit operator bool() const {
+            return m_shape != empty();
+        }
+
+    private:
+        struct Concept {
+            virtual ~Concept() = default;
+            virtual float distance(float x, float y) const = 0;
+            virtual Batch distance(const Batch& x, const Batch& y) const = 0;
+            virtual void evaluate(std::span<const glm::vec2> points, std::span<float> distance) const = 0;
+        };
+
+        template<Shape S>
+        struct Model final : Concept {
+            explicit Model(S shape) : shape(std::move(shape)) {}
+
+            float distance(float x, float y) const override { return shape.distance(x, y); }
+
+            Batch distance(const Batch& x, const Batch& y) const override { return shape.distance(x, y); }
+
+            void evaluate(std::span<const glm::vec2> points, std::span<float> distance) const override {
+                csg::evaluate(shape, points, distance);
+            }
+
+            S shape;
+        };
+
+        // shared by every default constructed Sdf so they do not allocate
+        static const std::shared_ptr<const Concept>& empty() {
+            static const std::shared_ptr<const Concept> shape = std::make_shared<Model<Empty>>(Empty{});
+            return shape;
+        }
+
+        std::shared_ptr<const Concept> m_shape;
+    };
+
+    inline void evaluate(const Sdf& shape, std::span<const glm::vec2> points, std::span<float> distance) {
+        shape.evaluate(points, distance);
+    }
+}
@@ -1,14 +1,127 @@
 #pragma once
 
 #include "snap.h"
+#include <fmt/format.h>
+#include <cmath>
+#include <iterator>
 #include <map>
 #include <string>
+#include <string_view>
 #include <any>
 
 namespace yaml {
 
-//    auto serialize(const auto& object) -> std::string;
+    // typed snapshot visitor writing block style YAML straight into a string, vectors and
+    // sequences of scalars are written in flow style. Going through YAML::Emitter costs more than
+    // everything else in a snapshot of a large particle set.
+    class Writer {
+    public:
+        explicit Writer(std::string& out)
+        : m_out(out)
+        {}
+
+        template<snap::Value T>
+        void value(std::string_view name, const T& value) {
+            key(name);
+            m_out.push_back(' ');
+            write(value);
+            m_out.push_back('\n');
+        }
+
+        template<typename T>
+        void sequence(std::string_view name, snap::Sequence<T> values) {
+            key(name);
+            if constexpr (snap::Vector<T>) {
+                if(values.size() == 0) {
+                    m_out += " []\n";
+                    return;
+                }
+                m_out.push_back('\n');
+                for(auto i = 0u; i < values.size(); i++){
+                    m_out.append(m_indent + 2, ' ');
+                    m_out += "- ";
+                    write(values[i]);
+                    m_out.push_back('\n');
+                }
+            } else {
+                m_out += " [";
+                for(auto i = 0u; i < values.size(); i++){
+                    if(i != 0) m_out += ", ";
+                    write(values[i]);
+                }
+                m_out += "]\n";
+            }
+        }
+
+        template<typename T>
+        void object(std::string_view name, const T& object) {
+            key(name);
+            m_out.push_back('\n');
+            m_indent += 2;
+            snap::describe(*this, object);
+            m_indent -= 2;
+        }
+
+        template<typename T>
+        void root(const T& object) {
+            snap::describe(*this, object);
+        }
+
+    private:
+        void key(std::string_view name) {
+            m_out.append(m_indent, ' ');
+            m_out += name;
+            m_out.push_back(':');
+        }
+
+        template<typename T>
+        void write(const T& value) {
+            if constexpr (snap::Vector<T>) {
+                m_out.push_back('[');
+                for(auto i = 0; i < T::length(); i++){
+                    if(i != 0) m_out += ", ";
+                    write(value[i]);
+                }
+                m_out.push_back(']');
+            } else if constexpr (std::is_same_v<T, bool>) {
+                m_out += value ? "true" : "false";
+            } else if constexpr (std::is_floating_point_v<T>) {
+                if(std::isnan(value)) m_out += ".nan";
+                else if(std::isinf(value)) m_out += value < 0 ? "-.inf" : ".inf";
+                else fmt::format_to(std::back_inserter(m_out), "{}", value);
+            } else if constexpr (std::is_arithmetic_v<T>) {
+                fmt::format_to(std::back_inserter(m_out), "{}", value);
+            } else {
+                quote(value);
+            }
+        }
+
+        void quote(std::string_view value) {
+            m_out.push_back('"');
+            for(auto c : value){
+                switch(c){
+                    case '"': m_out += "\\\""; break;
+                    case '\\': m_out += "\\\\"; break;
+                    case '\n': m_out += "\\n"; break;
+                    case '\t': m_out += "\\t"; break;
+                    case '\r': m_out += "\\r"; break;
+                    default: m_out.push_back(c);
+                }
+            }
+            m_out.push_back('"');
+        }
+
+        std::string& m_out;
+        size_t m_indent{0};
+    };
+
+    template<typename T>
+    auto serialize(const T& object) -> std::string {
+        std::string out;
+        Writer{out}.root(object);
+        return out;
+    }
 
     auto serialize(const Snap::Snapshot& snapshot) -> std::string;
 
-}
\ No newline at end of file
+}
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <glm/glm.hpp>
+#include <algorithm>
 #include <any>
+#include <cstddef>
 #include <map>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+// legacy type erased snapshot, copies every value into a std::any. Prefer the typed snapshot below
 struct Snap {
 
     using Snapshot = std::map<std::string, std::any>;
@@ -12,4 +19,123 @@ struct Snap {
     template<typename T>
     using Sequence = std::vector<T>;
     virtual  Snapshot snapshot() = 0;
-};
\ No newline at end of file
+};
+
+// Typed snapshot: an object describes its fields by calling a visitor, either through a member
+//
+//  template<typename Visitor>
+//  void snapshot(Visitor& visitor) const {
+//      visitor.value("radius", m_radius);
+//      visitor.sequence("position", snap::Sequence<glm::vec2>{ m_positions });
+//      visitor.object("bounds", m_bounds);
+//  }
+//
+// or a free function snapshotFields(visitor, object) found by ADL. Serialisers are visitors, they see
+// the concrete type of every field and read it in place, nothing is copied or type erased.
+namespace snap {
+
+    // contiguous or strided run of values, strides let interleaved (AoS) fields be visited in place.
+    // Chunked sequences are a table of equally sized contiguous chunks (PagedMemoryLayout), visitors
+    // that want whole runs walk them with forEachSpan()
+    template<typename T>
+    class Sequence {
+    public:
+        Sequence() = default;
+
+        Sequence(std::span<const T> values)
+        : m_data(reinterpret_cast<const std::byte*>(values.data()))
+        , m_size(values.size())
+        {}
+
+        Sequence(const std::vector<T>& values)
+        : Sequence(std::span<const T>{ values })
+        {}
+
+        Sequence(const T* data, size_t size, size_t stride = sizeof(T))
+        : m_data(reinterpret_cast<const std::byte*>(data))
+        , m_size(size)
+        , m_stride(stride)
+        {}
+
+        // chunks[k] holds values [k << chunkShift, (k + 1) << chunkShift), the table is not copied
+        Sequence(const std::byte* const* chunks, size_t chunkShift, size_t size)
+        : m_chunks(chunks)
+        , m_size(size)
+        , m_chunkShift(chunkShift)
+        {}
+
+        const T& operator[](size_t i) const {
+            if(m_chunks) {
+                const auto mask = (size_t{1} << m_chunkShift) - 1;
+                return reinterpret_cast<const T*>(m_chunks[i >> m_chunkShift])[i & mask];
+            }
+            return *reinterpret_cast<const T*>(m_data + i * m_stride);
+        }
+
+        [[nodiscard]]
+        size_t size() const {
+            return m_size;
+        }
+
+        [[nodiscard]]
+        bool contiguous() const {
+            return m_stride == sizeof(T);
+        }
+
+        [[nodiscard]]
+        bool chunked() const {
+            return m_chunks != nullptr;
+        }
+
+        // only valid when contiguous() and not chunked()
+        [[nodiscard]]
+        std::span<const T> span() const {
+            return { reinterpret_cast<const T*>(m_data), m_size };
+        }
+
+        // calls fn(std::span<const T>) for every run of values in order, one per chunk when
+        // chunked(). Only valid when contiguous()
+        template<typename Fn>
+        void forEachSpan(Fn&& fn) const {
+            if(!m_chunks) {
+                fn(span());
+                return;
+            }
+            const auto chunkSize = size_t{1} << m_chunkShift;
+            for(size_t first = 0; first < m_size; first += chunkSize){
+                fn(std::span<const T>{ reinterpret_cast<const T*>(m_chunks[first >> m_chunkShift]), std::min(chunkSize, m_size - first) });
+            }
+        }
+
+    private:
+        const std::byte* m_data{};
+        const std::byte* const* m_chunks{};
+        size_t m_size{};
+        size_t m_stride{sizeof(T)};
+        size_t m_chunkShift{};
+    };
+
+    template<typename T>
+    struct IsVector : std::false_type {};
+
+    template<glm::length_t L, typename T, glm::qualifier Q>
+    struct IsVector<glm::vec<L, T, Q>> : std::true_type {};
+
+    template<typename T>
+    concept Vector = IsVector<T>::value;
+
+    template<typename T>
+    concept Scalar = std::is_arithmetic_v<T> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+    template<typename T>
+    concept Value = Scalar<T> || Vector<T>;
+
+    template<typename Visitor, typename T>
+    void describe(Visitor& visitor, const T& object) {
+        if constexpr (requires { object.snapshot(visitor); }) {
+            object.snapshot(visitor);
+        } else {
+            snapshotFields(visitor, object);
+        }
+    }
+}
@@ -5,6 +5,8 @@
 #include "particle.h"
 #include "spacial_hash.h"
 #include "snap.h"
+#include "frame_stats.h"
+#include "checkpoint.h"
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 #include <memory>
@@ -12,6 +14,9 @@
 #include <utility>
 #include <bitset>
 #include <thread>
+#include <limits>
+#include <algorithm>
+#include <array>
 
 constexpr float Gravity{-9.8};
 
@@ -61,35 +66,177 @@ inline bool contains(const Bounds2D& bounds, const glm::vec2& p){
             p.y >= min.y && p.y < max.y;
 }
 
+#ifndef COLLISION_STATS
+#define COLLISION_STATS 1
+#endif
+
+constexpr bool CollisionStatsEnabled = COLLISION_STATS != 0;
+
+// accumulates collision counts inside a narrow phase loop, each thread keeps its own counter
+// (on the stack or padded per worker) and merges it into CollisionStats once per step.
+// With COLLISION_STATS=0 every call compiles away.
+struct alignas(64) CollisionCounter {
+    int total{0};
+    int min{std::numeric_limits<int>::max()};
+    int max{0};
+    int samples{0};
+
+    inline void add(int collisions) {
+        if constexpr (CollisionStatsEnabled) {
+            total += collisions;
+            min = collisions < min ? collisions : min;
+            max = collisions > max ? collisions : max;
+            samples++;
+        }
+    }
+
+    inline void merge(const CollisionCounter& other) {
+        if constexpr (CollisionStatsEnabled) {
+            total += other.total;
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+            samples += other.samples;
+        }
+    }
+
+    void reset() {
+        *this = CollisionCounter{};
+    }
+};
+
 struct CollisionStats{
-    std::array<int, 100> average{};
+    std::array<float, 100> average{};   // average collisions per particle over the last 100 steps
     int max{0};
     int min{0};
     int next{0};
     int total{0};
+
+    void merge(const CollisionCounter& counter) {
+        if constexpr (CollisionStatsEnabled) {
+            if(counter.samples == 0) return;
+            average[next++] = to<float>(counter.total) / to<float>(counter.samples);
+            next %= average.size();
+            max = glm::max(max, counter.max);
+            min = glm::min(min, counter.min);
+            total += counter.total;
+        }
+    }
 };
 
-template<template<typename> typename Layout>
-class Solver2D {
+// adaptive sub stepping: solve(dt) takes as many sub steps as the fastest and the most accelerated
+// particle need, instead of the fixed count the solver was constructed with.
+// A particle may travel courant * length per sub step (the CFL condition) and a sub step may not
+// exceed force * sqrt(length / a), length is the particle diameter of the solver.
+// The count is clamped to [minSubSteps, maxSubSteps]
+struct SubStepping {
+    bool adaptive{false};
+    size_t minSubSteps{1};
+    size_t maxSubSteps{16};
+    float courant{0.4f};
+    float force{0.25f};
+};
+
+// sub step counts solve() chose, since construction or reset()
+struct SubStepCounts {
+    size_t last{0};
+    size_t min{std::numeric_limits<size_t>::max()};
+    size_t max{0};
+    size_t total{0};
+    size_t frames{0};
+
+    void add(size_t subSteps) {
+        last = subSteps;
+        min = std::min(min, subSteps);
+        max = std::max(max, subSteps);
+        total += subSteps;
+        frames++;
+    }
+
+    [[nodiscard]]
+    double average() const {
+        return frames == 0 ? 0 : static_cast<double>(total) / static_cast<double>(frames);
+    }
+
+    void reset() {
+        *this = SubStepCounts{};
+    }
+};
+
+// largest speed and acceleration over the particles
+struct Motion {
+    float maxSpeed{0};
+    float maxAcceleration{0};
+};
+
+constexpr size_t MotionBlocks = 64;
+
+// Motion of particles [0, N), speed(i) and acceleration(i) return the squared magnitudes.
+// dispatch(count, fn(begin, end)) runs MotionBlocks blocks inline or over a thread pool, each block
+// writes its own maxima which are combined afterwards
+template<typename Speed, typename Acceleration, typename Dispatch>
+Motion reduceMotion(size_t N, Speed&& speed, Acceleration&& acceleration, Dispatch&& dispatch) {
+    std::array<Motion, MotionBlocks> blocks{};
+    const auto blockSize = (N + MotionBlocks - 1) / MotionBlocks;
+    dispatch(MotionBlocks, [&](size_t first, size_t last){
+        for(auto block = first; block < last; block++){
+            const auto begin = std::min(N, block * blockSize);
+            const auto end = std::min(N, begin + blockSize);
+            Motion motion{};
+            for(auto i = begin; i < end; i++){
+                motion.maxSpeed = glm::max(motion.maxSpeed, speed(i));
+                motion.maxAcceleration = glm::max(motion.maxAcceleration, acceleration(i));
+            }
+            blocks[block] = motion;
+        }
+    });
+    Motion result{};
+    for(const auto& motion : blocks){
+        result.maxSpeed = glm::max(result.maxSpeed, motion.maxSpeed);
+        result.maxAcceleration = glm::max(result.maxAcceleration, motion.maxAcceleration);
+    }
+    result.maxSpeed = glm::sqrt(result.maxSpeed);
+    result.maxAcceleration = glm::sqrt(result.maxAcceleration);
+    return result;
+}
+
+// sub steps for a frame of dt under the SubStepping criteria, length is the particle diameter
+inline size_t subStepsFor(const SubStepping& subStepping, const Motion& motion, float dt, float length) {
+    float steps = 1;
+    if(motion.maxSpeed > 0) {
+        steps = glm::max(steps, dt * motion.maxSpeed / (subStepping.courant * length));
+    }
+    if(motion.maxAcceleration > 0) {
+        steps = glm::max(steps, dt / (subStepping.force * glm::sqrt(length / motion.maxAcceleration)));
+    }
+    // very large counts (a particle thrown out at absurd speed) are clamped before the conversion
+    steps = glm::min(glm::ceil(steps), static_cast<float>(subStepping.maxSubSteps));
+    return std::clamp(static_cast<size_t>(steps), subStepping.minSubSteps, subStepping.maxSubSteps);
+}
+
+// base of the particle solvers, in 2D (Solver2D) or 3D (Solver3D) with y pointing up
+template<glm::length_t L, template<typename> typename Layout>
+class Solver {
 public:
-    Solver2D() = default;
+    using VecType = glm::vec<L, float>;
+
+    Solver() = default;
 
-    Solver2D(std::shared_ptr<Particle2D<Layout>> particles
-    , Bounds2D worldBounds);
+    Solver(std::shared_ptr<Particles<L, Layout>> particles
+    , Bounds<L> worldBounds);
 
-    virtual ~Solver2D() = default;
+    virtual ~Solver() = default;
 
     [[nodiscard]]
-    const Bounds2D& bounds() const {
+    const Bounds<L>& bounds() const {
         return m_worldBounds;
     }
 
-    Particle2D<Layout>& particles() {
+    Particles<L, Layout>& particles() {
         return *m_particles;
     }
 
     [[nodiscard]]
-    const glm::vec2& gravity() const {
+    const VecType& gravity() const {
         return m_gravity;
     }
 
@@ -97,22 +244,96 @@ public:
 
     virtual void clear() {}
 
+    // solvers that time their internal phases register them with frameStats here
+    virtual void attach(stats::FrameStats& frameStats) {}
+
+    // writes the particles and all solver state needed to continue bitwise identical after restore,
+    // overrides call the base implementation first
+    virtual void save(checkpoint::Writer& writer) const;
+
+    // restores into a solver constructed with the same configuration as the one saved
+    virtual void restore(checkpoint::Reader& reader);
+
+    void subStepping(const SubStepping& subStepping) {
+        m_subStepping = subStepping;
+    }
+
+    [[nodiscard]]
+    const SubStepping& subStepping() const {
+        return m_subStepping;
+    }
+
+    [[nodiscard]]
+    const SubStepCounts& subStepCounts() const {
+        return m_subStepCounts;
+    }
+
+    void resetSubStepCounts() {
+        m_subStepCounts.reset();
+    }
+
 public:
     CollisionStats collisionStats{};
 
 protected:
-    Bounds2D m_worldBounds;
-    std::shared_ptr<Particle2D<Layout>> m_particles;
-    glm::vec2 m_gravity{0, -9.8};
+    // largest speed and acceleration of the particles, velocity over a frame and gravity by default.
+    // Solvers with a thread pool or their own forces override it
+    virtual Motion motion() {
+        const auto velocity = m_particles->velocity();
+        const auto g = glm::dot(m_gravity, m_gravity);
+        return reduceMotion(m_particles->size()
+                            , [&](size_t i){ return glm::dot(velocity[i], velocity[i]); }
+                            , [&](size_t){ return g; }
+                            , [](size_t count, auto&& fn){ fn(size_t{0}, count); });
+    }
+
+    // the sub steps of the next frame, fixed when adaptive sub stepping is off, and records the count
+    size_t subSteps(float dt, size_t fixed, float length) {
+        const auto count = m_subStepping.adaptive ? subStepsFor(m_subStepping, motion(), dt, length) : fixed;
+        m_subStepCounts.add(count);
+        return count;
+    }
+
+    Bounds<L> m_worldBounds;
+    std::shared_ptr<Particles<L, Layout>> m_particles;
+    VecType m_gravity{ [] { VecType g{0}; g.y = Gravity; return g; }() };
+    SubStepping m_subStepping{};
+    SubStepCounts m_subStepCounts{};
 };
 
 template<template<typename> typename Layout>
-Solver2D<Layout>::Solver2D(std::shared_ptr<Particle2D<Layout>>  particles
-        , Bounds2D worldBounds)
+using Solver2D = Solver<2, Layout>;
+
+template<template<typename> typename Layout>
+using Solver3D = Solver<3, Layout>;
+
+template<glm::length_t L, template<typename> typename Layout>
+Solver<L, Layout>::Solver(std::shared_ptr<Particles<L, Layout>>  particles
+        , Bounds<L> worldBounds)
         : m_particles{ particles }
         , m_worldBounds{ worldBounds }
 {}
 
+template<glm::length_t L, template<typename> typename Layout>
+void Solver<L, Layout>::save(checkpoint::Writer& writer) const {
+    writer.section(L == 2 ? "solver2d" : "solver3d");
+    writer.write(m_worldBounds);
+    writer.write(m_gravity);
+    writer.write(collisionStats);
+    writer.write(m_subStepping);
+    checkpoint::write(writer, *m_particles);
+}
+
+template<glm::length_t L, template<typename> typename Layout>
+void Solver<L, Layout>::restore(checkpoint::Reader& reader) {
+    reader.section(L == 2 ? "solver2d" : "solver3d");
+    reader.read(m_worldBounds);
+    reader.read(m_gravity);
+    reader.read(collisionStats);
+    reader.read(m_subStepping);
+    checkpoint::read(reader, *m_particles);
+}
+
 
 
 
@@ -151,6 +372,10 @@ public:
 
     void boundsCheck(int i);
 
+    void save(checkpoint::Writer& writer) const override;
+
+    void restore(checkpoint::Reader& reader) override;
+
 private:
     BoundedSpacialHashGrid2D m_grid;
     int m_iterations{1};
@@ -184,6 +409,14 @@ public:
 
     void boundsCheck(int i);
 
+    // the velocity is implied by the previous position, which assumes the sub step of the last
+    // frame. When the sub step changes the previous positions are moved to keep the velocity
+    void rescaleVelocity(float dt);
+
+    void save(checkpoint::Writer& writer) const override;
+
+    void restore(checkpoint::Reader& reader) override;
+
     std::unordered_map<int, std::set<int>>& hashCollisions() {
         return m_grid.m_collisions;
     }
@@ -193,6 +426,7 @@ private:
     int m_iterations{1};
     float m_damp{1};
     float m_radius{1};
+    float m_subStepDt{0};
 };
 
 
@@ -208,11 +442,33 @@ ExplicitEulerSolver<Layout>::ExplicitEulerSolver(std::shared_ptr<Particle2D<Layo
 
 template<template<typename> typename Layout>
 void ExplicitEulerSolver<Layout>::solve(float dt) {
-    const auto sdt = dt/to<float>(m_iterations);
-    for(auto i = 0; i < m_iterations; i++){
+    const auto subSteps = this->subSteps(dt, m_iterations, m_radius * 2);
+    const auto sdt = dt/to<float>(subSteps);
+    for(auto i = 0u; i < subSteps; i++){
         subStep(sdt);
     }
 }
+template<template<typename> typename Layout>
+void ExplicitEulerSolver<Layout>::save(checkpoint::Writer& writer) const {
+    Solver2D<Layout>::save(writer);
+    writer.section("euler");
+    writer.write(m_iterations);
+    writer.write(m_damp);
+    writer.write(m_radius);
+}
+
+template<template<typename> typename Layout>
+void ExplicitEulerSolver<Layout>::restore(checkpoint::Reader& reader) {
+    Solver2D<Layout>::restore(reader);
+    reader.section("euler");
+    reader.read(m_iterations);
+    reader.read(m_damp);
+    // the hash grid's cells are sized by the radius when the solver is constructed
+    if(reader.read<float>() != m_radius) {
+        throw std::runtime_error{ "checkpoint was saved with a different particle radius" };
+    }
+}
+
 template<template<typename> typename Layout>
 void ExplicitEulerSolver<Layout>::subStep(float dt) {
     resolveCollision(dt);
@@ -242,6 +498,7 @@ void ExplicitEulerSolver<Layout>::resolveCollision(float dt){
     auto vPositions = this->particles().position();
     m_grid.initialize(this->particles(), numParticles);
 
+    CollisionCounter counter{};
     for(int i = 0; i < numParticles; i++){
         auto& position = vPositions[i];
 
@@ -252,13 +509,9 @@ void ExplicitEulerSolver<Layout>::resolveCollision(float dt){
             if(i == j) continue;
             collisions += resolveCollision(i, j);
         }
-        this->collisionStats.average[this->collisionStats.next++] = collisions;
-        this->collisionStats.max = glm::max(this->collisionStats.max, collisions);
-        this->collisionStats.min = glm::min(this->collisionStats.min, collisions);
-
-        this->collisionStats.next %= this->collisionStats.average.size();
-        this->collisionStats.total += collisions;
+        counter.add(collisions);
     }
+    this->collisionStats.merge(counter);
     for(auto i = 0; i < numParticles; i++){
         boundsCheck(i);
     }
@@ -362,12 +615,50 @@ VarletIntegrationSolver<Layout>::VarletIntegrationSolver(std::shared_ptr<Particl
 
 template<template<typename> typename Layout>
 void VarletIntegrationSolver<Layout>::solve(float dt) {
-    const auto sdt = dt/to<float>(m_iterations);
-    for(auto i = 0; i < m_iterations; i++){
+    const auto subSteps = this->subSteps(dt, m_iterations, m_radius * 2);
+    const auto sdt = dt/to<float>(subSteps);
+    rescaleVelocity(sdt);
+    for(auto i = 0u; i < subSteps; i++){
         subStep(sdt);
     }
 }
 
+template<template<typename> typename Layout>
+void VarletIntegrationSolver<Layout>::save(checkpoint::Writer& writer) const {
+    Solver2D<Layout>::save(writer);
+    writer.section("verlet");
+    writer.write(m_iterations);
+    writer.write(m_damp);
+    writer.write(m_radius);
+    writer.write(m_subStepDt);
+}
+
+template<template<typename> typename Layout>
+void VarletIntegrationSolver<Layout>::restore(checkpoint::Reader& reader) {
+    Solver2D<Layout>::restore(reader);
+    reader.section("verlet");
+    reader.read(m_iterations);
+    reader.read(m_damp);
+    // the hash grid's cells are sized by the radius when the solver is constructed
+    if(reader.read<float>() != m_radius) {
+        throw std::runtime_error{ "checkpoint was saved with a different particle radius" };
+    }
+    reader.read(m_subStepDt);
+}
+
+template<template<typename> typename Layout>
+void VarletIntegrationSolver<Layout>::rescaleVelocity(float dt) {
+    if(m_subStepDt != 0 && m_subStepDt != dt) {
+        const auto ratio = dt / m_subStepDt;
+        auto position = this->m_particles->position();
+        auto prevPosition = this->m_particles->previousPosition();
+        for(auto i = 0; i < this->m_particles->size(); i++){
+            prevPosition[i] = position[i] - (position[i] - prevPosition[i]) * ratio;
+        }
+    }
+    m_subStepDt = dt;
+}
+
 template<template<typename> typename Layout>
 void VarletIntegrationSolver<Layout>::subStep(float dt) {
     resolveCollision(dt);
@@ -385,6 +676,7 @@ void VarletIntegrationSolver<Layout>::resolveCollision(float dt) {
 
     m_grid.initialize(this->particles(), numParticles);
 
+    CollisionCounter counter{};
     for(int i = 0; i < numParticles; i++){
         auto& position = vPositions[i];
 
@@ -395,13 +687,9 @@ void VarletIntegrationSolver<Layout>::resolveCollision(float dt) {
             if(i == j) continue;
             collisions += resolveCollision(i, j);
         }
-        this->collisionStats.average[this->collisionStats.next++] = collisions;
-        this->collisionStats.max = glm::max(this->collisionStats.max, collisions);
-        this->collisionStats.min = glm::min(this->collisionStats.min, collisions);
-
-        this->collisionStats.next %= this->collisionStats.average.size();
-        this->collisionStats.total += collisions;
+        counter.add(collisions);
     }
+    this->collisionStats.merge(counter);
     for(auto i = 0; i < numParticles; i++){
         boundsCheck(i);
     }
@@ -2,6 +2,7 @@
 
 #include "snap.h"
 #include "particle.h"
+#include "huge_pages.h"
 #include <glm/glm.hpp>
 #include <fmt/format.h>
 #include <boost/functional/hash.hpp>
@@ -11,6 +12,9 @@
 #include <span>
 #include <type_traits>
 #include <bitset>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <glm_format.h>
 
 struct PrimeHash {
@@ -19,8 +23,11 @@ struct PrimeHash {
         return 541 * pid.x + 79 * pid.y;
     }
 
+    // Teschner et al. 2003, a weighted sum of small primes spans too few buckets for a volume of cells.
+    // Computed modulo 2^32 and kept non negative
     int32_t operator()(glm::ivec3 pid) const {
-        return 541 * pid.x + 79 * pid.y + 31 * pid.z;
+        const auto h = (static_cast<uint32_t>(pid.x) * 73856093u) ^ (static_cast<uint32_t>(pid.y) * 19349663u) ^ (static_cast<uint32_t>(pid.z) * 83492791u);
+        return static_cast<int32_t>(h & 0x7fffffffu);
     }
 
 };
@@ -38,6 +45,7 @@ public:
     , m_cellEntries(maxNumObjects)
     , m_queryIds(maxNumObjects)
     , m_querySize(0)
+    , m_hashes(maxNumObjects)
     {}
 
     template<typename = std::enable_if<!Unbounded>>
@@ -49,6 +57,7 @@ public:
     , m_cellEntries(glm::floor(gridSize.x/spacing * gridSize.y/spacing))
     , m_queryIds(glm::floor(gridSize.x/spacing * gridSize.y/spacing))
     , m_querySize(0)
+    , m_hashes(glm::floor(gridSize.x/spacing * gridSize.y/spacing))
     {}
 
 
@@ -98,7 +107,7 @@ public:
 
 
     template<template<typename> typename Layout = SeparateFieldMemoryLayout>
-    void initialize(Particle2D<Layout>& particles, size_t size) {
+    void initialize(Particles<L, Layout>& particles, size_t size) {
         static int id = -1;
         const auto positions = particles.position();
 
@@ -136,6 +145,89 @@ public:
 
     }
 
+    // parallel build of the same table initialize() builds. forEach(count, fn) has to call
+    // fn(begin, end) on disjoint ranges covering [0, count), concurrently or not. Cells are filled
+    // with atomics and then sorted, so the entries do not depend on the number of threads
+    template<template<typename> typename Layout, typename ForEach>
+    void initialize(Particles<L, Layout>& particles, size_t size, ForEach&& forEach) {
+        const auto positions = particles.position();
+        const auto numObjects = glm::min(size, m_cellEntries.size());
+        const auto tableSize = to<size_t>(m_tableSize);
+
+        forEach(m_counts.size(), [&](size_t begin, size_t end){
+            std::fill(m_counts.begin() + begin, m_counts.begin() + end, 0);
+        });
+
+        forEach(numObjects, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto h = hashPosition(positions[i]);
+                m_hashes[i] = h;
+                std::atomic_ref{ m_counts[h] }.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        // inclusive scan of the counts in blocks, block totals are scanned serially
+        std::array<int32_t, ScanBlocks + 1> blockOffsets{};
+        const auto blockSize = (tableSize + ScanBlocks - 1) / ScanBlocks;
+        forEach(ScanBlocks, [&](size_t begin, size_t end){
+            for(auto block = begin; block < end; block++){
+                const auto first = std::min(tableSize, block * blockSize);
+                const auto last = std::min(tableSize, first + blockSize);
+                std::partial_sum(m_counts.begin() + first, m_counts.begin() + last, m_counts.begin() + first);
+                blockOffsets[block + 1] = last > first ? m_counts[last - 1] : 0;
+            }
+        });
+        std::partial_sum(blockOffsets.begin(), blockOffsets.end(), blockOffsets.begin());
+        forEach(ScanBlocks, [&](size_t begin, size_t end){
+            for(auto block = begin; block < end; block++){
+                const auto first = std::min(tableSize, block * blockSize);
+                const auto last = std::min(tableSize, first + blockSize);
+                for(auto h = first; h < last; h++){
+                    m_counts[h] += blockOffsets[block];
+                }
+            }
+        });
+        m_counts[tableSize] = m_counts[tableSize - 1];
+
+        forEach(numObjects, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto slot = std::atomic_ref{ m_counts[m_hashes[i]] }.fetch_sub(1, std::memory_order_relaxed) - 1;
+                m_cellEntries[slot] = to<int32_t>(i);
+            }
+        });
+
+        // initialize() leaves every cell in descending order
+        forEach(tableSize, [&](size_t begin, size_t end){
+            for(auto h = begin; h < end; h++){
+                std::sort(m_cellEntries.begin() + m_counts[h], m_cellEntries.begin() + m_counts[h + 1], std::greater<>{});
+            }
+        });
+        std::fill(m_cellEntries.begin() + numObjects, m_cellEntries.end(), 0);
+    }
+
+    // number of objects in the cells forEachNeighbour() visits, without touching the objects
+    [[nodiscard]]
+    uint32_t countNeighbours(glm::vec<L, float> position, glm::vec<L, float> maxDist) const {
+        uint32_t count = 0;
+        forEachCell(position, maxDist, [&](int32_t h){
+            count += m_counts[h + 1] - m_counts[h];
+        });
+        return count;
+    }
+
+    // reentrant alternative to query(), calls fn(id) for every object in the cells overlapping the
+    // box of half size maxDist around position. Unlike query() a bucket shared by several of those
+    // cells (hash collisions, e.g. (x, y) and (-x, -y)) is visited once, so no object is reported twice
+    template<typename Fn>
+    void forEachNeighbour(glm::vec<L, float> position, glm::vec<L, float> maxDist, Fn&& fn) const {
+        forEachCell(position, maxDist, [&](int32_t h){
+            const auto end = m_counts[h + 1];
+            for (auto i = m_counts[h]; i < end; ++i) {
+                fn(m_cellEntries[i]);
+            }
+        });
+    }
+
     [[nodiscard]]
     glm::vec<L, int> intCoords(glm::vec<L, float> position) const {
         return glm::floor(position / m_spacing);
@@ -161,23 +253,14 @@ public:
             std::fill_n(m_queryIds.begin(), m_querySize, 0);
             m_querySize = 0;
 
-            for (auto xi = d0.x; xi <= d1.x; ++xi) {
-                for (auto yi = d0.y; yi <= d1.y; ++yi) {
-                    const auto h = hash({xi, yi});
-                    auto start = m_counts[h];
-                    const auto end = m_counts[h + 1];
-
-                    auto size = end - start;
-//                    auto offset = std::max(0, size - m_cellCapacity);
-                    auto offset = 0;
-                    start += offset;
-
-                    for (auto i = start; i < end; ++i) {
-                        this->m_queryIds[m_querySize] = m_cellEntries[i];
-                        m_querySize++;
-                    }
+            forEachBoxCell(d0, d1, [&](glm::vec<L, int> cell){
+                const auto h = hash(cell);
+                const auto end = m_counts[h + 1];
+                for (auto i = m_counts[h]; i < end; ++i) {
+                    this->m_queryIds[m_querySize] = m_cellEntries[i];
+                    m_querySize++;
                 }
-            }
+            });
         }catch(...){
             spdlog::error("error processing position: {}", position);
             throw;
@@ -207,25 +290,82 @@ public:
     int32_t size() const { return m_tableSize; }
 
     [[nodiscard]]
-    const std::vector<int32_t>& entries() const { return m_cellEntries; }
+    std::span<const int32_t> entries() const { return m_cellEntries; }
 
     [[nodiscard]]
     std::vector<int32_t> queryIds() const { return m_queryIds; }
 
     [[nodiscard]]
-    const std::vector<int32_t>& counts() const { return m_counts; }
+    std::span<const int32_t> counts() const { return m_counts; }
 
     std::unordered_map<int, std::set<int>> m_collisions;
 
 
 private:
+    // calls fn(h) once for every distinct bucket of the cells overlapping the box, in ascending
+    // order. Boxes of more than MaxBoxCells cells are not deduplicated
+    template<typename Fn>
+    void forEachCell(glm::vec<L, float> position, glm::vec<L, float> maxDist, Fn&& fn) const {
+        auto d0 = intCoords(position - maxDist);
+        auto d1 = intCoords(position + maxDist);
+
+        if constexpr (!Unbounded) {
+            d0 = glm::max(glm::vec<L, int>(0), d0);
+
+            auto limit = glm::vec<L, int>(glm::vec<L, float>(m_gridSize) / m_spacing) - 1;
+            d1 = glm::min(limit, d1);
+        }
+
+        size_t numCells = 1;
+        for(glm::length_t axis = 0; axis < L; axis++){
+            numCells *= to<size_t>(glm::max(0, d1[axis] - d0[axis] + 1));
+        }
+        if(numCells > MaxBoxCells) {
+            forEachBoxCell(d0, d1, [&](glm::vec<L, int> cell){ fn(hash(cell)); });
+            return;
+        }
+
+        // cells mirrored around the origin share a bucket through abs(), any two cells can through
+        // the modulo. Sorting the buckets is O(n log n) where checking each against the ones seen
+        // so far is O(n^2), 351 compares for a 3x3x3 box
+        std::array<int32_t, MaxBoxCells> cells;
+        size_t size = 0;
+        forEachBoxCell(d0, d1, [&](glm::vec<L, int> cell){ cells[size++] = hash(cell); });
+        std::sort(cells.begin(), cells.begin() + size);
+        const auto last = std::unique(cells.begin(), cells.begin() + size);
+        for(auto h = cells.begin(); h != last; ++h) {
+            fn(*h);
+        }
+    }
+
+    // fn(cell) for every cell of the box [d0, d1], x outermost
+    template<typename Fn>
+    static void forEachBoxCell(glm::vec<L, int> d0, glm::vec<L, int> d1, Fn&& fn) {
+        for (auto xi = d0.x; xi <= d1.x; ++xi) {
+            for (auto yi = d0.y; yi <= d1.y; ++yi) {
+                if constexpr (L == 2) {
+                    fn(glm::ivec2{xi, yi});
+                } else {
+                    for (auto zi = d0.z; zi <= d1.z; ++zi) {
+                        fn(glm::ivec3{xi, yi, zi});
+                    }
+                }
+            }
+        }
+    }
+
+    // largest box deduplicated in forEachCell(), 8 cells across in 2D and 6 in 3D
+    static constexpr size_t MaxBoxCells = L == 2 ? 64 : 216;
     float m_spacing{};
     uint32_t m_tableSize{};
-    std::vector<int32_t> m_counts{};
-    std::vector<int32_t> m_cellEntries{};
+    // randomly accessed with one entry per particle, huge page backed when hugepages::enabled()
+    std::vector<int32_t, hugepages::Allocator<int32_t>> m_counts{};
+    std::vector<int32_t, hugepages::Allocator<int32_t>> m_cellEntries{};
     std::vector<int32_t> m_queryIds{};
     uint32_t m_querySize{};
     int32_t m_cellCapacity{4};
+    std::vector<int32_t> m_hashes{};
+    static constexpr size_t ScanBlocks = 64;
     glm::vec<L, int> m_gridSize{};
     std::bitset<1000000> m_set;
 };
@@ -234,5 +374,8 @@ private:
 using BoundedSpacialHashGrid2D = SpacialHashGrid2D<2, false>;
 using UnBoundedSpacialHashGrid2D = SpacialHashGrid2D<2, true>;
 
-using BoundedSpacialHashGrid3D = SpacialHashGrid2D<3, false>;
-using UnBoundedSpacialHashGrid3D = SpacialHashGrid2D<3, true>;
\ No newline at end of file
+template<bool Unbounded = true, typename Hash = PrimeHash>
+using SpacialHashGrid3D = SpacialHashGrid2D<3, Unbounded, Hash>;
+
+using BoundedSpacialHashGrid3D = SpacialHashGrid3D<false>;
+using UnBoundedSpacialHashGrid3D = SpacialHashGrid3D<true>;
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "model.h"
 #include "particle.h"
 #include <vector>
+#include <array>
+#include <cmath>
+#include <concepts>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
@@ -82,8 +85,246 @@ struct Kernel {
 };
 
 
+// squared distance and distance between a pair of particles, computed once and shared by every
+// kernel evaluated for the pair
+template<glm::length_t L>
+struct KernelPair {
+    using VecType = glm::vec<L, float>;
+
+    explicit KernelPair(const VecType& R)
+    : R(R)
+    , r2(glm::dot(R, R))
+    , r(r2 == 0.f ? 0.f : std::sqrt(r2))
+    {}
+
+    VecType R;
+    float r2;
+    float r;
+};
+
+// kernels with their constants precomputed for a support radius h, evaluated from a KernelPair
+
+template<glm::length_t L>
+struct Poly6 {
+    explicit Poly6(float h = 1)
+    : h2(h * h)
+    , c(_315_over_64_pi / std::pow(h, 9.f))
+    {}
+
+    [[nodiscard]]
+    float value(const KernelPair<L>& pair) const {
+        if(pair.r2 > h2) return 0.f;
+        const auto x = h2 - pair.r2;
+        return c * x * x * x;
+    }
+
+    float h2;
+    float c;
+};
+
+template<glm::length_t L>
+struct Spiky {
+    explicit Spiky(float h = 1)
+    : h(h)
+    , cutoff(h + 0.001f)
+    , c(_45_over_pi / std::pow(h, 6.f))
+    {}
+
+    [[nodiscard]]
+    glm::vec<L, float> gradient(const KernelPair<L>& pair) const {
+        if(pair.r == 0 || pair.r > cutoff) return glm::vec<L, float>{};
+        const auto x = h - pair.r;
+        return -c * x * x * pair.R / pair.r;
+    }
+
+    float h;
+    float cutoff;
+    float c;
+};
+
+// the viscosity smoothing term Kernel<L>::laplacian has always produced
+template<glm::length_t L>
+struct Viscosity {
+    explicit Viscosity(float h = 1)
+    : h(h)
+    , h2(h * h)
+    , inverse2h3(1.f / (2 * h * h * h))
+    {}
+
+    [[nodiscard]]
+    float laplacian(const KernelPair<L>& pair) const {
+        const auto r = pair.r;
+        if(r == 0 || r > h) return 0.f;
+        return pair.r2 * r * inverse2h3 + pair.r2 / h2 + h / (2 * r) - 1;
+    }
+
+    float h;
+    float h2;
+    float inverse2h3;
+};
+
+// M4 cubic spline with compact support h (q = r/h), used for density, gradient and laplacian
+template<glm::length_t L>
+struct CubicSpline {
+    static constexpr float Sigma = L == 2 ? 40.f / (7.f * glm::pi<float>()) : 8.f / glm::pi<float>();
+
+    explicit CubicSpline(float h = 1)
+    : h(h)
+    , inverseH(1.f / h)
+    , sigma(Sigma / std::pow(h, static_cast<float>(L)))
+    {}
+
+    [[nodiscard]]
+    float value(const KernelPair<L>& pair) const {
+        const auto q = pair.r * inverseH;
+        if(q > 1) return 0.f;
+        if(q <= 0.5f) return sigma * (6 * q * q * (q - 1) + 1);
+        const auto x = 1 - q;
+        return sigma * 2 * x * x * x;
+    }
+
+    [[nodiscard]]
+    float derivative(float q) const {
+        if(q <= 0.5f) return sigma * inverseH * q * (18 * q - 12);
+        const auto x = 1 - q;
+        return -sigma * inverseH * 6 * x * x;
+    }
+
+    [[nodiscard]]
+    glm::vec<L, float> gradient(const KernelPair<L>& pair) const {
+        const auto q = pair.r * inverseH;
+        if(pair.r == 0 || q > 1) return glm::vec<L, float>{};
+        return derivative(q) * pair.R / pair.r;
+    }
+
+    // W'' + (L - 1) W' / r
+    [[nodiscard]]
+    float laplacian(const KernelPair<L>& pair) const {
+        const auto q = pair.r * inverseH;
+        if(pair.r == 0 || q > 1) return 0.f;
+        const auto second = q <= 0.5f ? sigma * inverseH * inverseH * (36 * q - 12) : sigma * inverseH * inverseH * 12 * (1 - q);
+        return second + (L - 1) * derivative(q) / pair.r;
+    }
+
+    float h;
+    float inverseH;
+    float sigma;
+};
+
+// kernel policies for SphSolver: W for density, dW for pressure and ddW for viscosity, each
+// constructed for the support radius
+
+// Müller et al.: Poly6 density, Spiky pressure gradient and the viscosity term, the kernels Kernel<L> builds
+template<glm::length_t L>
+struct MullerKernel {
+    explicit MullerKernel(float h = 1)
+    : density(h)
+    , pressure(h)
+    , viscosity(h)
+    {}
+
+    [[nodiscard]] float W(const KernelPair<L>& pair) const { return density.value(pair); }
+
+    [[nodiscard]] glm::vec<L, float> dW(const KernelPair<L>& pair) const { return pressure.gradient(pair); }
+
+    [[nodiscard]] float ddW(const KernelPair<L>& pair) const { return viscosity.laplacian(pair); }
+
+    Poly6<L> density;
+    Spiky<L> pressure;
+    Viscosity<L> viscosity;
+};
+
+template<glm::length_t L>
+struct CubicSplineKernel {
+    explicit CubicSplineKernel(float h = 1)
+    : spline(h)
+    {}
+
+    [[nodiscard]] float W(const KernelPair<L>& pair) const { return spline.value(pair); }
+
+    [[nodiscard]] glm::vec<L, float> dW(const KernelPair<L>& pair) const { return spline.gradient(pair); }
+
+    [[nodiscard]] float ddW(const KernelPair<L>& pair) const { return spline.laplacian(pair); }
+
+    CubicSpline<L> spline;
+};
+
+// another kernel policy sampled at Samples + 1 points over r in [0, h] and linearly interpolated,
+// W, the radial derivative of W and ddW are looked up instead of evaluating powers and divisions
+// per pair. The three values of a sample share a cache line.
+// Error bounds for MullerKernel with the default 256 samples (sph_kernel_test): W within 2e-5 of
+// W(0), the gradient within 5e-5 of its largest magnitude and ddW within 1e-3 for r > h / 8 (the
+// viscosity term diverges as h / 2r)
+template<glm::length_t L, typename Source = MullerKernel<L>, size_t Samples = 256>
+struct TabulatedKernel {
+    explicit TabulatedKernel(float h = 1)
+    : h(h)
+    , scale(static_cast<float>(Samples) / h)
+    {
+        const Source source{ h };
+        for(auto i = 0u; i <= Samples; i++){
+            glm::vec<L, float> R{};
+            R.x = static_cast<float>(i) / scale;
+            const KernelPair<L> pair{ R };
+            table[i] = { source.W(pair), source.dW(pair).x, source.ddW(pair) };
+        }
+        // gradients vanish at r = 0 by convention, the table holds their limit
+        table[0].derivative = 2 * table[1].derivative - table[2].derivative;
+    }
+
+    [[nodiscard]] float W(const KernelPair<L>& pair) const {
+        return lookup(pair.r, &Sample::value);
+    }
+
+    [[nodiscard]] glm::vec<L, float> dW(const KernelPair<L>& pair) const {
+        if(pair.r == 0) return glm::vec<L, float>{};
+        return lookup(pair.r, &Sample::derivative) / pair.r * pair.R;
+    }
+
+    [[nodiscard]] float ddW(const KernelPair<L>& pair) const {
+        return lookup(pair.r, &Sample::laplacian);
+    }
+
+    struct Sample {
+        float value{};
+        float derivative{};
+        float laplacian{};
+    };
+
+    [[nodiscard]]
+    float lookup(float r, float Sample::* field) const {
+        if(r > h) return 0.f;
+        const auto t = r * scale;
+        const auto i = static_cast<size_t>(t);
+        const auto f = t - static_cast<float>(i);
+        const auto a = table[i].*field;
+        return a + (table[i + 1].*field - a) * f;
+    }
+
+    float h;
+    float scale;
+    // one zero sample past the support, r == h interpolates into it with a zero weight
+    std::array<Sample, Samples + 2> table{};
+};
+
+template<typename K, glm::length_t L>
+concept KernelPolicy = std::constructible_from<K, float> && requires(const K k, const KernelPair<L>& pair) {
+    { k.W(pair) } -> std::convertible_to<float>;
+    { k.dW(pair) } -> std::convertible_to<glm::vec<L, float>>;
+    { k.ddW(pair) } -> std::convertible_to<float>;
+};
+
+
 using SphParticle2D = SphParticle<2>;
 using SphParticle3D = SphParticle<3>;
 
 using Kernel2D = Kernel<2>;
-using Kernel3D = Kernel<3>;
\ No newline at end of file
+using Kernel3D = Kernel<3>;
+
+using MullerKernel2D = MullerKernel<2>;
+using CubicSplineKernel2D = CubicSplineKernel<2>;
+using TabulatedKernel2D = TabulatedKernel<2>;
+
+using MullerKernel3D = MullerKernel<3>;
+using CubicSplineKernel3D = CubicSplineKernel<3>;
+using TabulatedKernel3D = TabulatedKernel<3>;
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "sph.h"
+#include "spacial_hash.h"
+#include "sdf_expression.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// outward unit normal of sdf at x from central differences eps apart, zero where the gradient vanishes
+inline glm::vec2 sdfNormal(const csg::Sdf& sdf, glm::vec2 x, float eps) {
+    const glm::vec2 gradient{
+        sdf(x + glm::vec2(eps, 0)) - sdf(x - glm::vec2(eps, 0)),
+        sdf(x + glm::vec2(0, eps)) - sdf(x - glm::vec2(0, eps)) };
+    const auto length = glm::length(gradient);
+    return length > 0 ? gradient / length : glm::vec2(0);
+}
+
+// one layer of samples on the zero level set of sdf inside bounds, about spacing apart. Grid points
+// within a spacing of the surface are projected onto it along the sdf gradient and kept unless an
+// earlier sample lies closer than 3/4 of the spacing, corners and curves end up sampled unevenly,
+// which the boundary volumes compensate
+inline std::vector<glm::vec2> sampleBoundary(const csg::Sdf& sdf, const Bounds2D& bounds, float spacing) {
+    const auto eps = spacing * 0.01f;
+
+    const auto minDistance2 = 0.5625f * spacing * spacing;
+    const auto key = [&](glm::ivec2 cell){ return (static_cast<int64_t>(cell.x) << 32) ^ static_cast<uint32_t>(cell.y); };
+    std::unordered_map<int64_t, std::vector<uint32_t>> cells{};
+    std::vector<glm::vec2> samples{};
+
+    const auto [min, max] = bounds;
+    const auto size = glm::ivec2(glm::ceil((max - min) / spacing));
+    for(auto y = 0; y <= size.y; y++){
+        for(auto x = 0; x <= size.x; x++){
+            auto p = min + glm::vec2(x, y) * spacing;
+            if(glm::abs(sdf(p)) >= spacing) continue;
+            for(auto iteration = 0; iteration < 4; iteration++){
+                p -= sdf(p) * sdfNormal(sdf, p, eps);
+            }
+            if(glm::abs(sdf(p)) > eps || glm::clamp(p, min, max) != p) continue;
+
+            const auto cell = glm::ivec2(glm::floor(p / spacing));
+            auto tooClose = false;
+            for(auto dy = -1; dy <= 1 && !tooClose; dy++){
+                for(auto dx = -1; dx <= 1 && !tooClose; dx++){
+                    const auto found = cells.find(key(cell + glm::ivec2(dx, dy)));
+                    if(found == cells.end()) continue;
+                    for(const auto s : found->second){
+                        const auto d = samples[s] - p;
+                        if(glm::dot(d, d) < minDistance2){
+                            tooClose = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            if(tooClose) continue;
+            cells[key(cell)].push_back(static_cast<uint32_t>(samples.size()));
+            samples.push_back(p);
+        }
+    }
+    return samples;
+}
+
+// static boundary particles after Akinci et al. 2012, "Versatile rigid-fluid coupling for
+// incompressible SPH". Every sample b carries the volume V_b = 1 / sum_k W(x_b - x_k) over its
+// boundary neighbours and stands in for a fluid particle of mass psi_b = rho0 * V_b, so unevenly
+// sampled walls contribute the same density. The samples never move, their grid is built once
+// when the boundary is constructed and not per sub step.
+// A single layer holds the fluid back when it is sampled finer than the fluid (the particle radius),
+// particles still pushed through it (a weakly compressible fluid under its own weight) are moved
+// back out by collide(), as the box walls do
+class SphBoundary2D {
+public:
+    SphBoundary2D() = default;
+
+    // samples the surface of sdf inside bounds at spacing, gridSpacing is the cell size of the
+    // sample grid
+    SphBoundary2D(csg::Sdf sdf, const Bounds2D& bounds, float spacing, float gridSpacing)
+    : m_sdf(std::move(sdf))
+    , m_positions(sampleBoundary(m_sdf, bounds, spacing))
+    , m_mass(m_positions.size())
+    , m_grid{ gridSpacing, std::max(1, static_cast<int32_t>(m_positions.size())) }
+    , m_eps(spacing * 0.01f)
+    {
+        m_grid.initialize(std::span{ m_positions });
+    }
+
+    // recomputes the volumes for a kernel of support h and the fluid rest density
+    template<typename Kernel>
+    void update(const Kernel& kernel, float h, float restDensity) {
+        m_h = h;
+        for(auto b = 0u; b < m_positions.size(); b++){
+            float totalWeight = 0;
+            forEach(m_positions[b], [&](const KernelPair<2>& pair, float){
+                totalWeight += kernel.W(pair);
+            });
+            m_mass[b] = totalWeight > 0 ? restDensity / totalWeight : 0;
+        }
+    }
+
+    // fn(pair, psi) for every sample within the kernel support of x, pair.R points from the sample to x
+    template<typename Fn>
+    void forEach(glm::vec2 x, Fn&& fn) const {
+        if(m_positions.empty()) return;
+        const auto h2 = m_h * m_h;
+        m_grid.forEachNeighbour(x, glm::vec2(m_h), [&](int32_t b){
+            const KernelPair<2> pair{ x - m_positions[b] };
+            if(pair.r2 > h2) return;
+            fn(pair, m_mass[b]);
+        });
+    }
+
+    // keeps a particle of radius outside the solid, its velocity into the surface is reflected
+    // and scaled by restitution
+    void collide(glm::vec2& position, glm::vec2& velocity, float radius, float restitution) const {
+        if(!m_sdf) return;
+        const auto distance = m_sdf(position);
+        if(distance >= radius) return;
+        const auto n = sdfNormal(m_sdf, position, m_eps);
+        position += (radius - distance) * n;
+        if(const auto vn = glm::dot(velocity, n); vn < 0) {
+            velocity -= (1 + restitution) * vn * n;
+        }
+    }
+
+    [[nodiscard]]
+    bool empty() const {
+        return m_positions.empty();
+    }
+
+    [[nodiscard]]
+    size_t size() const {
+        return m_positions.size();
+    }
+
+    [[nodiscard]]
+    std::span<const glm::vec2> positions() const {
+        return m_positions;
+    }
+
+    // psi_b = rho0 * V_b of every sample
+    [[nodiscard]]
+    std::span<const float> mass() const {
+        return m_mass;
+    }
+
+private:
+    csg::Sdf m_sdf;
+    std::vector<glm::vec2> m_positions;
+    std::vector<float> m_mass;
+    UnBoundedSpacialHashGrid2D m_grid;
+    float m_h{0};
+    float m_eps{0};
+};
@@ -5,6 +5,7 @@
 #include "types.h"
 #include "particle.h"
 #include "profile.h"
+#include "frame_stats.h"
 #include <VulkanBaseApp.h>
 #include <GraphicsPipelineBuilder.hpp>
 #include <DescriptorSetBuilder.hpp>
@@ -152,5 +153,9 @@ private:
     int fixedUpdatesPerSecond{120};
     std::vector<std::unique_ptr<ParticleEmitter<SeparateFieldMemoryLayout>>> m_emitters;
     std::unique_ptr<SphSolver2D<SeparateFieldMemoryLayout>> solver;
+    stats::FrameStats m_frameStats;
+    // looked up once in the constructor, phase() takes a lock
+    stats::Histogram& m_emitTime;
+    stats::Histogram& m_solveTime;
 
 };
\ No newline at end of file
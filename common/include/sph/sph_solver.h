@@ -2,17 +2,37 @@
 
 #include "solver2d.h"
 #include "sph.h"
+#include "sph_boundary.h"
 #include "spacial_hash.h"
-#include <functional>
-
-template<template<typename> typename Layout>
-class SphSolver2D : public Solver2D<Layout> {
+#include "thread_pool/thread_pool.hpp"
+#include <array>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <variant>
+
+// SPH fluid in 2D (SphSolver2D) or 3D (SphSolver3D) with y pointing up.
+// Kernel is a KernelPolicy (MullerKernel2D, CubicSplineKernel2D), its evaluation is inlined into the
+// neighbour loops. The neighbours are searched once per sub step, the gathered pairs with their
+// displacement and distance feed the density pass and then the force pass.
+// With numThreads > 1 every pass of a sub step (bounds, grid, gather, density, forces, integrate) is split over a thread
+// pool, each pass only writes the outputs of the particles in its range (the symmetric force pass
+// writes a buffer per fixed block) so the results do not depend on the number of threads.
+// A single thread runs the passes inline and never allocates.
+// Boundary particles (boundary()) are sampled from 2D signed distance fields and only available in 2D
+template<glm::length_t L, template<typename> typename Layout, typename Kernel = MullerKernel<L>>
+requires KernelPolicy<Kernel, L>
+class SphSolver : public Solver<L, Layout> {
 public:
+    using VecType = glm::vec<L, float>;
 
-    SphSolver2D() = default;
+    SphSolver() = default;
 
-    SphSolver2D(
-            Kernel2D kernel,
+    // besides a few fields per particle the symmetric force pass keeps ForceBlocks buffers of
+    // maxNumParticles vectors, 16 * 12 bytes per particle in 3D (192 MB for 10^6 particles)
+    SphSolver(
             float smoothingRadius,
             float particleRadius,
             float gasConstant,
@@ -20,11 +40,11 @@ public:
             float gravity,
             float mass,
             size_t maxNumParticles,
-            std::shared_ptr<Particle2D<Layout>> particles,
-            Bounds2D worldBounds,
-            size_t numIterations)
-            : Solver2D<Layout>(particles, worldBounds)
-            , m_kernel(kernel)
+            std::shared_ptr<Particles<L, Layout>> particles,
+            Bounds<L> worldBounds,
+            size_t numIterations,
+            uint32_t numThreads = 1)
+            : Solver<L, Layout>(particles, worldBounds)
             , m_smoothingRadius( smoothingRadius )
             , m_radius(particleRadius)
             , m_gasConstant( gasConstant )
@@ -32,47 +52,227 @@ public:
             , m_gravity( gravity )
             , m_mass( mass )
             , m_numIterations( numIterations )
-            , m_gravityForce(0, -gravity)
+            , m_gravityForce(gravityForce(gravity))
             , m_density(maxNumParticles)
-            , m_previous_density(maxNumParticles)
             , m_forces(maxNumParticles)
-            , W(kernel(smoothingRadius * 2))
-            , dW(kernel.gradient(smoothingRadius * 2))
-            , ddW(kernel.laplacian(smoothingRadius * 2))
-            , m_grid{ smoothingRadius, int(maxNumParticles)}
-{}
-
-    ~SphSolver2D() override = default;
+            , m_pressure(maxNumParticles)
+            , m_pressureForces(maxNumParticles)
+            , m_pressureFactor(maxNumParticles)
+            , m_predicted(maxNumParticles)
+            , m_predictedWall(maxNumParticles)
+            , m_blockForces(ForceBlocks * maxNumParticles, VecType{0})
+            , m_candidates(maxNumParticles)
+            , m_offsets(maxNumParticles + 1)
+            , m_numNeighbours(maxNumParticles)
+            , m_kernel(smoothingRadius * 2)
+            , m_cutoff(supportCutoff(smoothingRadius))
+            , m_grid{ gridSpacing(smoothingRadius), int(maxNumParticles)}
+            , m_threadPool{ numThreads > 1 ? std::make_unique<tp::ThreadPool>(numThreads) : nullptr }
+{
+        calibratePressureSolve();
+}
+
+    ~SphSolver() override = default;
 
     void solve(float dt) override {
-        const auto sdt = dt/to<float>(m_numIterations);
-        for(auto i = 0; i < m_numIterations; i++){
+        m_pressureSolve = {};
+        const auto subSteps = this->subSteps(dt, m_numIterations, m_radius * 2);
+        const auto sdt = dt/to<float>(subSteps);
+        for(auto i = 0u; i < subSteps; i++){
             subStep(sdt);
         }
     }
 
     void clear() override {
         std::fill_n(m_density.begin(), m_density.size(), 0.f);
-        std::fill_n(m_forces.begin(), m_forces.size(), glm::vec2(0));
+        std::fill_n(m_forces.begin(), m_forces.size(), VecType(0));
+    }
+
+    void attach(stats::FrameStats& frameStats) override {
+        m_phaseTimes.grid = &frameStats.phase("sph.grid");
+        m_phaseTimes.neighbours = &frameStats.phase("sph.neighbours");
+        m_phaseTimes.density = &frameStats.phase("sph.density");
+        m_phaseTimes.forces = &frameStats.phase("sph.forces");
+        m_phaseTimes.pressure = &frameStats.phase("sph.pressure");
+        m_phaseTimes.integrate = &frameStats.phase("sph.integrate");
+    }
+
+    void save(checkpoint::Writer& writer) const override {
+        Solver<L, Layout>::save(writer);
+        writer.section("sph");
+        writer.write(m_smoothingRadius);
+        writer.write(m_gasConstant);
+        writer.write(m_gravity);
+        writer.write(m_mass);
+        writer.write(m_radius);
+        writer.write(m_viscousConstant);
+        writer.write(m_numIterations);
+        writer.write(m_gravityForce);
+        writer.write(m_density);
+        writer.write(m_forces);
+        writer.write(m_mode);
+        writer.write(m_maxDensityError);
+        writer.write(m_maxPressureIterations);
+        writer.write(m_symmetricForces);
+    }
+
+    void restore(checkpoint::Reader& reader) override {
+        Solver<L, Layout>::restore(reader);
+        reader.section("sph");
+        reader.read(m_smoothingRadius);
+        reader.read(m_gasConstant);
+        reader.read(m_gravity);
+        reader.read(m_mass);
+        reader.read(m_radius);
+        reader.read(m_viscousConstant);
+        reader.read(m_numIterations);
+        reader.read(m_gravityForce);
+        // sized by maxNumParticles, which must match the saved solver
+        reader.read(std::span<float>{ m_density });
+        reader.read(std::span<VecType>{ m_forces });
+        reader.read(m_mode);
+        reader.read(m_maxDensityError);
+        reader.read(m_maxPressureIterations);
+        reader.read(m_symmetricForces);
+        smoothingRadius(m_smoothingRadius);
+    }
+
+    // WeaklyCompressible: pressure from the state equation with the gas constant (the default).
+    // PredictiveCorrective: PCISPH (Solenthaler & Pajarola 2009), pressure is iterated until the
+    // average predicted compression is below maxDensityError (relative to the rest density) or
+    // maxPressureIterations is reached. Each particle is corrected by its own density response
+    // (the DFSPH factor, Bender & Koschier 2015) rather than one from a prototype particle. The rest
+    // density is the density of particles packed at their diameter, the gas constant is not used
+    enum class Mode { WeaklyCompressible, PredictiveCorrective };
+
+    // pressure iterations summed and the largest remaining average compression over the sub steps
+    // of the last solve(), zero in WeaklyCompressible mode
+    struct PressureSolve {
+        size_t iterations{};
+        float densityError{};
+    };
+
+    void mode(Mode mode) {
+        m_mode = mode;
+    }
+
+    [[nodiscard]]
+    Mode mode() const {
+        return m_mode;
+    }
+
+    void maxDensityError(float error) {
+        m_maxDensityError = error;
+    }
+
+    [[nodiscard]]
+    float maxDensityError() const {
+        return m_maxDensityError;
+    }
+
+    // weakly compressible forces over unordered pairs (computeSymmetricForces, the default) or per
+    // particle over all its neighbours (computeForces)
+    void symmetricForces(bool symmetric) {
+        m_symmetricForces = symmetric;
+    }
+
+    [[nodiscard]]
+    bool symmetricForces() const {
+        return m_symmetricForces;
+    }
+
+    void maxPressureIterations(size_t iterations) {
+        m_maxPressureIterations = iterations;
+    }
+
+    [[nodiscard]]
+    const PressureSolve& pressureSolve() const {
+        return m_pressureSolve;
+    }
+
+    [[nodiscard]]
+    float restDensity() const {
+        return m_restDensity;
+    }
+
+    // densities of the last sub step, indexed by particle
+    [[nodiscard]]
+    std::span<const float> density() const {
+        return m_density;
+    }
+
+    // boundary particles sampled from the surface of sdf (solid where sdf < 0) at spacing, the
+    // particle radius by default. They add to the density of nearby fluid and push it back with
+    // the pressure of the fluid particle in both modes, the box stays the outer limit. Like the
+    // emitters a boundary belongs to the scene setup and is not checkpointed
+    void boundary(csg::Sdf sdf, float spacing = 0) requires (L == 2) {
+        spacing = spacing > 0 ? spacing : m_radius;
+        m_boundary = SphBoundary2D{ std::move(sdf), expand(this->bounds(), m_cutoff), spacing, m_smoothingRadius };
+        m_boundary.update(m_kernel, m_cutoff, m_restDensity);
+    }
+
+    [[nodiscard]]
+    const SphBoundary2D& boundary() const requires (L == 2) {
+        return m_boundary;
     }
 
     void subStep(float dt) {
 
         const auto N = this->particles().size();
-        m_grid.initialize(this->particles(), N);
-        const auto h = glm::vec2(m_smoothingRadius * 2);
+        {
+            stats::ScopedTimer timer{m_phaseTimes.grid};
+            m_grid.initialize(this->particles(), N, [this](size_t count, auto&& fn){ forEach(count, fn); });
+        }
+        const auto h = VecType(m_smoothingRadius * 2);
 
         resolveCollision(N, dt);
-//        computeDensity(N, h);
-        computeForces(N, h);
-        integrate(N, dt);
-        std::swap(m_previous_density, m_density);
+        {
+            stats::ScopedTimer timer{m_phaseTimes.neighbours};
+            gatherNeighbours(N, h);
+        }
+        if(m_mode == Mode::PredictiveCorrective) {
+            {
+                stats::ScopedTimer timer{m_phaseTimes.density};
+                computeKernelDensity(N);
+            }
+            {
+                stats::ScopedTimer timer{m_phaseTimes.forces};
+                computeNonPressureForces(N);
+            }
+            {
+                stats::ScopedTimer timer{m_phaseTimes.pressure};
+                solvePressure(N, dt);
+            }
+            {
+                stats::ScopedTimer timer{m_phaseTimes.integrate};
+                integrate(N, dt);
+            }
+            return;
+        }
+        {
+            stats::ScopedTimer timer{m_phaseTimes.density};
+            computeDensity(N);
+        }
+        {
+            stats::ScopedTimer timer{m_phaseTimes.forces};
+            if(m_symmetricForces) {
+                computeSymmetricForces(N);
+            } else {
+                computeForces(N);
+            }
+        }
+        {
+            stats::ScopedTimer timer{m_phaseTimes.integrate};
+            integrate(N, dt);
+        }
     }
 
     void resolveCollision(size_t N, float dt) {
-        for(auto i = 0; i < N; i++){
-            boundsCheck(i);
-        }
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                boundsCheck(to<int>(i));
+            }
+        });
     }
 
     void boundsCheck(int i) {
@@ -83,119 +283,356 @@ public:
         auto [min, max] = shrink(this->bounds(), m_radius);
 
         auto& p = position;
-        glm::vec2 n{0};
-
-        if(p.x < min.x){
-            p.x = min.x;
-            velocity.x *= -rest;
-        }
-        if(p.x > max.x){
-            p.x = max.x;
-            velocity.x *= -rest;
+        for(glm::length_t axis = 0; axis < L; axis++){
+            if(p[axis] < min[axis]){
+                p[axis] = min[axis];
+                velocity[axis] *= -rest;
+            }
+            if(p[axis] > max[axis]){
+                p[axis] = max[axis];
+                velocity[axis] *= -rest;
+            }
         }
-        if(p.y < min.y){
-            p.y = min.y;
-            velocity.y *= -rest;
-        }
-        if(p.y > max.y){
-            p.y = max.y;
-            velocity.y *= -rest;
+        if constexpr (L == 2) {
+            m_boundary.collide(position, velocity, m_radius, rest);
         }
     }
 
-    void computeDensity(size_t N, glm::vec2 h) {
-        float d;
-        for(auto i = 0; i < N; i++){
-            auto p = this->particles().position()[i];
-            auto neighbours = m_grid.query(p, h);
-            m_density[i] = computeDensity(i, neighbours);
+    // the one neighbour search of a sub step. Every pair inside the kernel support is stored with
+    // its displacement and distance, particle i owns m_pairs[m_offsets[i], m_offsets[i] + m_numNeighbours[i]).
+    // The offsets come from the grid cell counts, so the storage is sized before any distance is computed
+    void gatherNeighbours(size_t N, VecType h) {
+        const auto position = this->particles().position();
+
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                m_candidates[i] = m_grid.countNeighbours(position[i], h);
+            }
+        });
+        m_offsets[0] = 0;
+        std::inclusive_scan(m_candidates.begin(), m_candidates.begin() + N, m_offsets.begin() + 1, std::plus<>{}, uint32_t{0});
+        if(const size_t total = m_offsets[N]; total > m_pairs.size()) {
+            m_pairs.resize(total + total / 2, KernelPair<L>{ VecType{} });
+            m_neighbours.resize(m_pairs.size());
         }
+
+        const auto cutoff2 = m_cutoff * m_cutoff;
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto xi = position[i];
+                auto next = m_offsets[i];
+                m_grid.forEachNeighbour(xi, h, [&](int32_t j){
+                    // most candidates are outside the support, the distance is only taken for the pairs kept
+                    const auto R = xi - position[j];
+                    if(glm::dot(R, R) > cutoff2) return;
+                    m_pairs[next] = KernelPair<L>{ R };
+                    m_neighbours[next] = j;
+                    ++next;
+                });
+                m_numNeighbours[i] = next - m_offsets[i];
+            }
+        });
     }
 
-    float computeDensity(int i, std::span<int> neighbours) {
-        const auto N = neighbours.size();
-        auto xi = this->particles().position()[i];
+    // the neighbours gathered for particle i, including i itself
+    [[nodiscard]]
+    std::span<const int32_t> neighbours(size_t i) const {
+        return { m_neighbours.data() + m_offsets[i], m_numNeighbours[i] };
+    }
 
-        float totalWeight = 0;
-        for(auto j : neighbours) {
-            auto xj = this->particles().position()[j];
-            totalWeight += W(xi - xj);
-        }
+    [[nodiscard]]
+    std::span<const KernelPair<L>> pairs(size_t i) const {
+        return { m_pairs.data() + m_offsets[i], m_numNeighbours[i] };
+    }
 
-        return glm::max(RestDensity, m_mass * N * totalWeight);
+    // in 2D the estimate scales the kernel sum by the number of particles in the searched cells,
+    // as the neighbour query always has. 3D has no such legacy and uses the plain m * sum(W)
+    void computeDensity(size_t N) {
+        const auto position = this->particles().position();
+        const auto m = m_mass;
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                float totalWeight = 0;
+                for(const auto& pair : pairs(i)){
+                    totalWeight += m_kernel.W(pair);
+                }
+                // boundary samples stand in for the fluid particles missing at the walls
+                forEachBoundary(position[i], [&](const KernelPair<L>& pair, float psi){
+                    totalWeight += psi / m * m_kernel.W(pair);
+                });
+                const auto scale = L == 2 ? to<float>(m_candidates[i]) : 1.f;
+                m_density[i] = glm::max(RestDensity, m * scale * totalWeight);
+            }
+        });
     }
 
-    void computeForces(size_t N, glm::vec2 h) {
-        for(auto i = 0; i < N; i++){
-            auto& f = m_forces[i];
-            auto density = m_density[i];
-            auto x = this->particles().position()[i];
-            auto neighbours = m_grid.query(x, h);
+    // pressure and viscosity from the densities of this sub step over the gathered pairs
+    void computeForces(size_t N) {
+        const auto position = this->particles().position();
+        const auto velocity = this->particles().velocity();
+        const auto k = m_gasConstant;
+        const auto m = m_mass;
+        const auto mu = m_viscousConstant;
+        constexpr auto d0 = RestDensity;
 
-            m_previous_density[i] = computeDensity(i, neighbours);
-            f = m_gravityForce
-                 + computePressureForce(i, neighbours, x, density)
-                 + computeViscousForce(i, neighbours, x, density);
-        }
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto di = m_density[i];
+                const auto vi = velocity[i];
+                const auto ids = neighbours(i);
+                const auto iPairs = pairs(i);
+
+                VecType pressure{};
+                VecType viscous{};
+                for(auto n = 0u; n < ids.size(); n++){
+                    const auto j = ids[n];
+                    if(to<size_t>(j) == i) continue;
+
+                    const auto dj = m_density[j];
+                    if(dj == 0) continue;
+                    const auto& pair = iPairs[n];
+                    pressure += (m/dj) * k * ((di - d0) + (dj - d0)) * m_kernel.dW(pair) * 0.5f;
+                    if(mu > 0) {
+                        viscous += (m/dj) * (velocity[j] - vi) * m_kernel.ddW(pair);
+                    }
+                }
+                pressure += boundaryPressure(position[i], di);
+
+                auto& f = m_forces[i];
+                f = m_gravityForce;
+                if(di != 0) {
+                    f += pressure * -(m/di);
+                    if(mu > 0) {
+                        f += mu * (m/di) * viscous;
+                    }
+                }
+            }
+        });
     }
 
-    glm::vec2 computePressureForce(int i, std::span<int> neighbours, const glm::vec2& xi, float di) {
+    // the forces of computeForces() over unordered pairs: the pressure and viscosity terms of a pair
+    // are equal and opposite, so each pair (i, j > i) is evaluated once and applied to both particles.
+    // Particles are split into ForceBlocks blocks, each accumulating into its own buffer so blocks
+    // run in parallel without races. Block b only reaches particles from its first one on. The
+    // buffers are summed in block order, so the result does not depend on the number of threads, and
+    // cleared while summing, so they are zero for the next call and no block has to clear the
+    // entries of the others
+    void computeSymmetricForces(size_t N) {
+        const auto position = this->particles().position();
+        const auto velocity = this->particles().velocity();
         const auto k = m_gasConstant;
         const auto m = m_mass;
+        const auto mu = m_viscousConstant;
         constexpr auto d0 = RestDensity;
-        if(di == 0 ) return {};
-
-        glm::vec2 f{};
-        for(auto j : neighbours){
-            if(j == i) continue;
-            auto xj = this->particles().position()[j];
-            auto dj = m_density[j];
-            auto r = xi - xj;
-            auto w = dW(r);
-            f +=  (dj == 0) ? glm::vec2{0} : (m/dj) * k * ((di - d0) + (dj - d0)) * w * 0.5f;
-        }
-        return f * -(m/di);
+        const auto stride = m_density.size();
+
+        forEachBlock(ForceBlocks, N, [&](size_t block, size_t begin, size_t end){
+            const auto forces = m_blockForces.data() + block * stride;
+            for(auto i = begin; i < end; i++){
+                const auto di = m_density[i];
+                if(di == 0) continue;
+                const auto vi = velocity[i];
+                const auto ids = neighbours(i);
+                const auto iPairs = pairs(i);
+
+                VecType force{};
+                for(auto n = 0u; n < ids.size(); n++){
+                    const auto j = ids[n];
+                    if(to<size_t>(j) <= i) continue;
+
+                    const auto dj = m_density[j];
+                    if(dj == 0) continue;
+                    const auto& pair = iPairs[n];
+                    const auto scale = m * m / (di * dj);
+                    auto f = -scale * k * ((di - d0) + (dj - d0)) * m_kernel.dW(pair) * 0.5f;
+                    if(mu > 0) {
+                        f += mu * scale * (velocity[j] - vi) * m_kernel.ddW(pair);
+                    }
+                    force += f;
+                    forces[j] -= f;
+                }
+                forces[i] += force - (m/di) * boundaryPressure(position[i], di);
+            }
+        });
+
+        const auto blockSize = (N + ForceBlocks - 1) / ForceBlocks;
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                auto f = m_gravityForce;
+                for(auto block = 0u; block <= i / blockSize; block++){
+                    auto& blockForce = m_blockForces[block * stride + i];
+                    f += blockForce;
+                    blockForce = VecType{0};
+                }
+                m_forces[i] = f;
+            }
+        });
     }
 
-
-    glm::vec2 computeViscousForce(int i, std::span<int> neighbours, const glm::vec2& xi, float di) {
-        if(m_viscousConstant <= 0) return {};
-
-        const auto mu = m_viscousConstant;
-        const auto vi = this->particles().velocity()[i];
+    // plain SPH density m * sum(W) plus the density of the walls, used by the predictive corrective mode
+    void computeKernelDensity(size_t N) {
+        const auto position = this->particles().position();
         const auto m = m_mass;
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                float totalWeight = 0;
+                for(const auto& pair : pairs(i)){
+                    totalWeight += m_kernel.W(pair);
+                }
+                m_density[i] = m * totalWeight + wall(position[i]).density;
+            }
+        });
+    }
 
-        if(di == 0) return {};
+    // gravity and viscosity, the forces the pressure solve corrects for
+    void computeNonPressureForces(size_t N) {
+        const auto velocity = this->particles().velocity();
+        const auto m = m_mass;
+        const auto mu = m_viscousConstant;
 
-        glm::vec2 f{};
-        for(auto j : neighbours){
-            if(j == i) continue;
-            auto xj = this->particles().position()[j];
-            auto vj = this->particles().velocity()[j];
-            auto dj =  m_density[j];
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto vi = velocity[i];
+                const auto ids = neighbours(i);
+                const auto iPairs = pairs(i);
+
+                VecType viscous{};
+                if(mu > 0) {
+                    for(auto n = 0u; n < ids.size(); n++){
+                        const auto j = ids[n];
+                        if(to<size_t>(j) == i) continue;
+                        viscous += (m/m_density[j]) * (velocity[j] - vi) * m_kernel.ddW(iPairs[n]);
+                    }
+                }
+                m_forces[i] = m_gravityForce + mu * (m/m_density[i]) * viscous;
+            }
+        });
+    }
 
-            f += (dj == 0) ? glm::vec2{0} : (m/dj) * (vj - vi) * ddW(xi - xj);
+    // predict positions with the current pressure forces, correct the pressure of every particle by
+    // its predicted density error and recompute the pressure forces, until the average compression
+    // is within m_maxDensityError. Pressure starts from zero every sub step, carrying it over lets it
+    // outlast the compression it was built for (after an impact) and throw particles off
+    void solvePressure(size_t N, float dt) {
+        const auto position = this->particles().position();
+        const auto velocity = this->particles().velocity();
+        const auto m = m_mass;
+        const auto rho0 = m_restDensity;
+        const auto relaxation = PressureRelaxation / (dt * dt);
+        const auto inverseMass = 1 / m;
+        const auto [min, max] = shrink(this->bounds(), m_radius);
+
+        // the density change of a particle per unit of its own pressure (times dt^2), from its actual
+        // neighbours and walls
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                m_pressure[i] = 0;
+                m_pressureForces[i] = VecType{0};
+                VecType sumGradient{};
+                float sumGradient2 = 0;
+                for(const auto& pair : pairs(i)){
+                    const auto gradient = m * m_kernel.dW(pair);
+                    sumGradient += gradient;
+                    sumGradient2 += glm::dot(gradient, gradient);
+                }
+                const auto wallGradient = wall(position[i]).gradient;
+                const auto response = glm::dot(sumGradient + wallGradient, sumGradient + 2.f * wallGradient) + sumGradient2;
+                m_pressureFactor[i] = response > 0 ? rho0 * rho0 / response : 0;
+            }
+        });
+
+        size_t iteration = 0;
+        float densityError = std::numeric_limits<float>::max();
+        while(iteration < m_maxPressureIterations && (iteration < MinPressureIterations || densityError > m_maxDensityError)) {
+            forEach(N, [&](size_t begin, size_t end){
+                for(auto i = begin; i < end; i++){
+                    const auto v = velocity[i] + dt * (m_forces[i] + m_pressureForces[i]) * inverseMass;
+                    // the walls are only enforced on positions, the prediction has to respect them as well
+                    m_predicted[i] = glm::clamp(position[i] + dt * v, min, max);
+                }
+            });
+
+            m_blockErrors.fill(0);
+            forEachBlock(ReduceBlocks, N, [&](size_t block, size_t begin, size_t end){
+                float totalError = 0;
+                for(auto i = begin; i < end; i++){
+                    const auto xi = m_predicted[i];
+                    float totalWeight = 0;
+                    for(const auto j : neighbours(i)){
+                        totalWeight += m_kernel.W(KernelPair<L>{ xi - m_predicted[j] });
+                    }
+                    m_predictedWall[i] = wall(xi);
+                    // pressure is clamped at zero, particles short of neighbours (at the surface) are not pulled together
+                    const auto error = m * totalWeight + m_predictedWall[i].density - rho0;
+                    m_pressure[i] = glm::max(0.f, m_pressure[i] + relaxation * m_pressureFactor[i] * error);
+                    totalError += glm::max(0.f, error);
+                }
+                m_blockErrors[block] = totalError;
+            });
+            densityError = N > 0 ? std::accumulate(m_blockErrors.begin(), m_blockErrors.end(), 0.f) / (to<float>(N) * rho0) : 0.f;
+
+            forEach(N, [&](size_t begin, size_t end){
+                for(auto i = begin; i < end; i++){
+                    const auto xi = m_predicted[i];
+                    const auto pi = m_pressure[i];
+                    VecType force{};
+                    for(const auto j : neighbours(i)){
+                        if(to<size_t>(j) == i) continue;
+                        const KernelPair<L> pair{ xi - m_predicted[j] };
+                        force -= m * m * (pi + m_pressure[j]) / (rho0 * rho0) * m_kernel.dW(pair);
+                    }
+                    // the wall particles mirror the pressure of the particle, pi + pj of the pair term
+                    // above with pj = pi. boundaryPressure() averages the pair pressures and mirrors with pi
+                    force -= m * 2 * pi / (rho0 * rho0) * m_predictedWall[i].gradient;
+                    m_pressureForces[i] = force;
+                }
+            });
+            ++iteration;
         }
-        return mu * (m/di) * f;
+
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                m_forces[i] += m_pressureForces[i];
+            }
+        });
+        m_pressureSolve.iterations += iteration;
+        m_pressureSolve.densityError = glm::max(m_pressureSolve.densityError, N > 0 ? densityError : 0.f);
     }
 
     void integrate(const size_t N, float dt) {
         auto position = this->particles().position();
         auto velocity = this->particles().velocity();
-        for(auto i = 0; i < N; i++){
-            auto& v = velocity[i];
-            auto& p = position[i];
-            auto a = m_forces[i]/m_mass;
-            v += a * dt;
-            p += v * dt;
-        }
+        forEach(N, [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                auto& v = velocity[i];
+                auto& p = position[i];
+                auto a = m_forces[i]/m_mass;
+                v += a * dt;
+                p += v * dt;
+            }
+        });
+    }
+
+    [[nodiscard]]
+    uint32_t numThreads() const {
+        return m_threadPool ? m_threadPool->m_thread_count : 1;
+    }
+
+    // the pool of the sub step passes, nullptr with a single thread. Idle between solve() calls,
+    // so work that runs after solve() can share it instead of starting threads of its own
+    [[nodiscard]]
+    tp::ThreadPool* threadPool() const {
+        return m_threadPool.get();
     }
 
     void smoothingRadius(float h) {
         m_smoothingRadius = h;
-        W = m_kernel(h * 2);
-        dW = m_kernel.gradient(h * 2);
-        ddW = m_kernel.laplacian(h * 2);
+        m_kernel = Kernel{ h * 2 };
+        m_cutoff = supportCutoff(h);
+        calibratePressureSolve();
+        if constexpr (L == 2) {
+            m_boundary.update(m_kernel, m_cutoff, m_restDensity);
+        }
     }
 
     [[nodiscard]]
@@ -232,8 +669,40 @@ public:
         m_gravityForce.y = -g;
     }
 
+protected:
+    // the accelerations are the forces of the last sub step. A weakly compressible fluid carries
+    // pressure waves at the speed of sound of its state equation (c^2 = dp/drho = gasConstant),
+    // which is added to the fastest particle. The predictive corrective pressure grows with 1 / dt^2
+    // to undo the compression of one sub step, it is left out or shorter sub steps would ask for
+    // even shorter ones
+    Motion motion() override {
+        const auto velocity = this->particles().velocity();
+        const auto inverseMass2 = 1 / (m_mass * m_mass);
+        const auto predictiveCorrective = m_mode == Mode::PredictiveCorrective;
+        auto result = reduceMotion(this->particles().size()
+                                   , [&](size_t i){ return glm::dot(velocity[i], velocity[i]); }
+                                   , [&](size_t i){
+                                       const auto f = predictiveCorrective ? m_forces[i] - m_pressureForces[i] : m_forces[i];
+                                       return glm::dot(f, f) * inverseMass2;
+                                   }
+                                   , [this](size_t count, auto&& fn){ forEach(count, fn); });
+        if(!predictiveCorrective) {
+            result.maxSpeed += glm::sqrt(m_gasConstant);
+        }
+        return result;
+    }
 
 private:
+    struct WallSample {
+        float density{};
+        float gradient{};
+    };
+
+    struct WallDensity {
+        float density{};
+        VecType gradient{};
+    };
+
     float m_smoothingRadius{1};
     float m_gasConstant{1};
     float m_gravity{9.8};
@@ -242,17 +711,213 @@ private:
     float m_viscousConstant;
     size_t m_numIterations{1};
 
-    glm::vec2 m_gravityForce{0};
+    VecType m_gravityForce{0};
 
-    std::vector<float> m_previous_density;
     std::vector<float> m_density;
-    std::vector<glm::vec2> m_forces;
-
-    Kernel2D m_kernel;
-    std::function<float(glm::vec2)> W;
-    std::function<glm::vec2(glm::vec2)> dW;
-    std::function<float(glm::vec2)> ddW;
+    std::vector<VecType> m_forces;
+
+    // force buffers of computeSymmetricForces(), maxNumParticles each. The block count is fixed so
+    // the order of the sums is the same for any number of threads, it bounds the pass to 16 threads
+    static constexpr size_t ForceBlocks = 16;
+    std::vector<VecType> m_blockForces;
+    bool m_symmetricForces{true};
+
+    // predictive corrective pressure solve
+    std::vector<float> m_pressure;
+    std::vector<VecType> m_pressureForces;
+    std::vector<float> m_pressureFactor;
+    std::vector<VecType> m_predicted;
+    std::vector<WallDensity> m_predictedWall;
+    Mode m_mode{Mode::WeaklyCompressible};
+    float m_maxDensityError{0.01f};
+    size_t m_maxPressureIterations{50};
+    float m_restDensity{1};
+    PressureSolve m_pressureSolve{};
+    // fewer iterations let the compression of an impact through, a full correction overshoots
+    static constexpr size_t MinPressureIterations = 4;
+    static constexpr float PressureRelaxation = 0.5f;
+    static constexpr size_t ReduceBlocks = 64;
+    std::array<float, ReduceBlocks> m_blockErrors{};
+    static constexpr size_t WallSamples = 64;
+    std::array<WallSample, WallSamples + 1> m_wallTable{};
+
+    // neighbour gather of the current sub step, see gatherNeighbours()
+    std::vector<uint32_t> m_candidates;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_numNeighbours;
+    std::vector<KernelPair<L>> m_pairs;
+    std::vector<int32_t> m_neighbours;
+
+    Kernel m_kernel{};
+    float m_cutoff{};
+    [[no_unique_address]] std::conditional_t<L == 2, SphBoundary2D, std::monostate> m_boundary;
     static constexpr float RestDensity = 0;
 
-    UnBoundedSpacialHashGrid2D m_grid;
-};
\ No newline at end of file
+    SpacialHashGrid2D<L, true> m_grid;
+    std::unique_ptr<tp::ThreadPool> m_threadPool;
+
+    // pairs further apart than the kernel support are dropped by the gather, the Spiky gradient
+    // is cut off slightly past it
+    static float supportCutoff(float smoothingRadius) {
+        return smoothingRadius * 2 + 0.001f;
+    }
+
+    // rest density of a particle in the middle of a block packed at the particle diameter, and the
+    // density the box walls add, both for the current kernel
+    void calibratePressureSolve() {
+        const auto spacing = 2 * m_radius;
+        const auto extent = to<int>(std::ceil(m_cutoff / spacing));
+        float totalWeight = 0;
+        forEachLatticePoint<L>(extent, [&](glm::vec<L, float> point){
+            totalWeight += m_kernel.W(KernelPair<L>{ point * spacing });
+        });
+        m_restDensity = m_mass * totalWeight;
+
+        // a wall is a half space of particles continuing the packing, the first layer a particle
+        // radius behind the wall. Sampled by the distance of a particle to the wall, with the
+        // gradient taken along the wall normal (y, the layers of the wall span the other axes)
+        for(auto s = 0u; s < m_wallTable.size(); s++){
+            const auto distance = m_cutoff * to<float>(s) / to<float>(WallSamples);
+            WallSample sample{};
+            for(auto layer = m_radius + distance; layer <= m_cutoff; layer += spacing){
+                forEachLatticePoint<L - 1>(extent, [&](glm::vec<L - 1, float> point){
+                    VecType R{0};
+                    R.x = point.x * spacing;
+                    R.y = layer;
+                    if constexpr (L == 3) {
+                        R.z = point.y * spacing;
+                    }
+                    const KernelPair<L> pair{ R };
+                    sample.density += m_mass * m_kernel.W(pair);
+                    sample.gradient += m_mass * m_kernel.dW(pair).y;
+                });
+            }
+            m_wallTable[s] = sample;
+        }
+    }
+
+    // fn(point) for the integer points of [-extent, extent]^D, x innermost
+    template<glm::length_t D, typename Fn>
+    static void forEachLatticePoint(int extent, Fn&& fn) {
+        if constexpr (D == 1) {
+            for(auto x = -extent; x <= extent; x++){
+                fn(glm::vec<1, float>(to<float>(x)));
+            }
+        } else if constexpr (D == 2) {
+            for(auto y = -extent; y <= extent; y++){
+                for(auto x = -extent; x <= extent; x++){
+                    fn(glm::vec2(x, y));
+                }
+            }
+        } else {
+            for(auto z = -extent; z <= extent; z++){
+                for(auto y = -extent; y <= extent; y++){
+                    for(auto x = -extent; x <= extent; x++){
+                        fn(glm::vec3(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+
+    // fn(pair, psi) for the boundary samples around x, there are none in 3D
+    template<typename Fn>
+    void forEachBoundary(VecType x, Fn&& fn) const {
+        if constexpr (L == 2) {
+            m_boundary.forEach(x, fn);
+        }
+    }
+
+    // cells of the smoothing radius in 2D. A 3D query box would span 125 to 216 of them, sorting their
+    // buckets costs more than the extra candidates of cells as large as the support (27 to 64 cells)
+    static float gridSpacing(float smoothingRadius) {
+        return L == 2 ? smoothingRadius : smoothingRadius * 2;
+    }
+
+    static VecType gravityForce(float gravity) {
+        VecType force{0};
+        force.y = -gravity;
+        return force;
+    }
+
+    // pressure term of the boundary samples around a particle of density di, the samples mirror its
+    // pressure and density (Akinci et al. 2012). computeForces() averages the pressures of a pair,
+    // (pi + pj) / 2 with pj = pi is pi, so a sample adds its pressure once. The predictive corrective
+    // force sums them instead and mirrors with 2 * pi
+    [[nodiscard]]
+    VecType boundaryPressure(VecType x, float di) const {
+        VecType pressure{};
+        if(di == 0) return pressure;
+        const auto p = m_gasConstant * (di - RestDensity);
+        forEachBoundary(x, [&](const KernelPair<L>& pair, float psi){
+            pressure += (psi / di) * p * m_kernel.dW(pair);
+        });
+        return pressure;
+    }
+
+    // density the box walls and the boundary samples add at x and its gradient, the box walls are
+    // linear in the wall table
+    [[nodiscard]]
+    WallDensity wall(VecType x) const {
+        const auto& [min, max] = this->bounds();
+        WallDensity result{};
+        const auto add = [&](float distance, VecType normal){
+            const auto t = glm::max(0.f, distance) / m_cutoff * WallSamples;
+            if(t >= WallSamples) return;
+            const auto s = to<size_t>(t);
+            const auto f = t - to<float>(s);
+            const auto& a = m_wallTable[s];
+            const auto& b = m_wallTable[s + 1];
+            result.density += glm::mix(a.density, b.density, f);
+            result.gradient += glm::mix(a.gradient, b.gradient, f) * normal;
+        };
+        for(glm::length_t axis = 0; axis < L; axis++){
+            VecType normal{0};
+            normal[axis] = 1;
+            add(x[axis] - min[axis], normal);
+            add(max[axis] - x[axis], -normal);
+        }
+        forEachBoundary(x, [&](const KernelPair<L>& pair, float psi){
+            result.density += psi * m_kernel.W(pair);
+            result.gradient += psi * m_kernel.dW(pair);
+        });
+        return result;
+    }
+
+    // fn(block, begin, end) over blocks blocks of [0, count), for reductions with one result per block
+    template<typename Fn>
+    void forEachBlock(size_t blocks, size_t count, Fn&& fn) {
+        const auto blockSize = (count + blocks - 1) / blocks;
+        forEach(blocks, [&](size_t first, size_t last){
+            for(auto block = first; block < last; block++){
+                const auto begin = std::min(count, block * blockSize);
+                fn(block, begin, std::min(count, begin + blockSize));
+            }
+        });
+    }
+
+    // fn(begin, end) over [0, count), split over the pool when there is one
+    template<typename Fn>
+    void forEach(size_t count, Fn&& fn) {
+        if(m_threadPool) {
+            m_threadPool->dispatch(to<uint32_t>(count), fn);
+        } else {
+            fn(size_t{0}, count);
+        }
+    }
+
+    struct {
+        stats::Histogram* grid{};
+        stats::Histogram* neighbours{};
+        stats::Histogram* density{};
+        stats::Histogram* forces{};
+        stats::Histogram* pressure{};
+        stats::Histogram* integrate{};
+    } m_phaseTimes;
+};
+
+template<template<typename> typename Layout, typename Kernel = MullerKernel2D>
+using SphSolver2D = SphSolver<2, Layout, Kernel>;
+
+template<template<typename> typename Layout, typename Kernel = MullerKernel3D>
+using SphSolver3D = SphSolver<3, Layout, Kernel>;
@@ -0,0 +1,374 @@
+#pragma once
+
+#include "sph.h"
+#include "spacial_hash.h"
+#include "model2d.h"
+#include "thread_pool/thread_pool.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// closed polylines of one frame, polyline i is points[offsets[i], offsets[i + 1]) and its last point
+// connects back to the first
+struct Polylines {
+    std::vector<glm::vec2> points;
+    std::vector<uint32_t> offsets{0};
+
+    [[nodiscard]]
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    [[nodiscard]]
+    std::span<const glm::vec2> operator[](size_t i) const {
+        return { points.data() + offsets[i], offsets[i + 1] - offsets[i] };
+    }
+
+    void clear() {
+        points.clear();
+        offsets.resize(1);
+    }
+};
+
+// free surface of a 2D SPH fluid extracted on the CPU, for headless runs that have no metaballs pass.
+// The colour field c(x) = sum_j W(x - x_j) / W0 is sampled on the nodes of a grid over bounds, W0 is
+// the kernel sum of a particle inside a block packed at the particle diameter, so c is about 1 in the
+// fluid and 0 outside. Marching squares turns the isoValue contour into closed polylines with the
+// fluid on their left (counter clockwise around a drop), a ring of empty nodes around the grid closes
+// them where the fluid touches the bounds.
+// The nodes are evaluated in tiles of TileNodes x TileNodes, each tile gathers its particles from a
+// spatial hash with cells the size of a tile and adds them into its own nodes, tiles without fluid
+// nearby cost one query. With a thread pool the tiles are interleaved over its threads, fluid
+// usually fills a part of the bounds and contiguous ranges of tiles would leave threads without
+// work. The pool is borrowed, e.g. from the solver, so extraction does not compete with the solver
+// threads. Every node and crossing is written by one tile or cell, so the output does not depend on
+// the number of threads. extract() only reads positions, it can run on a copy of the particles in a
+// pipeline stage of its own, given a pool of its own.
+template<typename Kernel = MullerKernel2D>
+requires KernelPolicy<Kernel, 2>
+class SurfaceExtractor2D {
+public:
+    SurfaceExtractor2D(
+            Bounds2D bounds,
+            float cellSize,
+            float smoothingRadius,
+            float particleRadius,
+            size_t maxNumParticles,
+            float isoValue = 0.5f,
+            tp::ThreadPool* threadPool = nullptr)
+    : m_cellSize(cellSize)
+    , m_support(smoothingRadius * 2)
+    , m_isoValue(isoValue)
+    , m_origin(bounds.lower - cellSize)
+    , m_cells(glm::ivec2(glm::ceil((bounds.upper - bounds.lower) / cellSize)) + 2)
+    , m_tiles((m_cells + TileNodes) / TileNodes)
+    , m_kernel(smoothingRadius * 2)
+    , m_field(to<size_t>(m_cells.x + 1) * to<size_t>(m_cells.y + 1))
+    , m_next(2 * m_field.size(), NoEdge)
+    , m_crossings(2 * m_field.size())
+    , m_fluidTiles(to<size_t>(m_tiles.x) * to<size_t>(m_tiles.y))
+    , m_contourTiles(to<size_t>(m_tiles.x) * to<size_t>(m_tiles.y))
+    , m_grid{ glm::max(cellSize * TileNodes, m_support), to<int32_t>(maxNumParticles) }
+    , m_threadPool{ threadPool }
+    {
+        const auto spacing = 2 * particleRadius;
+        const auto extent = to<int>(std::ceil(m_support / spacing));
+        float totalWeight = 0;
+        for(auto y = -extent; y <= extent; y++){
+            for(auto x = -extent; x <= extent; x++){
+                totalWeight += m_kernel.W(KernelPair<2>{ glm::vec2(x, y) * spacing });
+            }
+        }
+        m_inverseRestWeight = 1 / totalWeight;
+
+        // the weight of a node is looked up by its squared distance, without a square root per node
+        for(auto s = 0u; s <= WeightSamples; s++){
+            const auto r2 = to<float>(s) / to<float>(WeightSamples) * m_support * m_support;
+            m_weights[s] = m_kernel.W(KernelPair<2>{ glm::vec2(std::sqrt(r2), 0) }) * m_inverseRestWeight;
+        }
+    }
+
+    // the surface of the first size particles, valid until the next call. Uses the thread pool of the
+    // constructor, it must not be dispatched from elsewhere while extract() runs
+    template<template<typename> typename Layout>
+    const Polylines& extract(Particle2D<Layout>& particles, size_t size) {
+        m_grid.initialize(particles, size, [this](size_t count, auto&& fn){ forEach(count, fn); });
+        computeField(particles);
+        march();
+        stitch();
+        return m_polylines;
+    }
+
+    template<template<typename> typename Layout>
+    const Polylines& extract(Particle2D<Layout>& particles) {
+        return extract(particles, particles.size());
+    }
+
+    [[nodiscard]]
+    const Polylines& polylines() const {
+        return m_polylines;
+    }
+
+    // colour field of the last extract(), node (x, y) at origin() + (x, y) * cellSize()
+    [[nodiscard]]
+    std::span<const float> field() const {
+        return m_field;
+    }
+
+    [[nodiscard]]
+    float field(glm::ivec2 node) const {
+        return m_field[index(node)];
+    }
+
+    // number of cells along x and y, there is one more node than cells
+    [[nodiscard]]
+    glm::ivec2 cells() const {
+        return m_cells;
+    }
+
+    [[nodiscard]]
+    glm::vec2 origin() const {
+        return m_origin;
+    }
+
+    [[nodiscard]]
+    float cellSize() const {
+        return m_cellSize;
+    }
+
+    [[nodiscard]]
+    float isoValue() const {
+        return m_isoValue;
+    }
+
+    [[nodiscard]]
+    uint32_t numThreads() const {
+        return m_threadPool ? m_threadPool->m_thread_count : 1;
+    }
+
+private:
+    static constexpr int TileNodes = 16;
+    static constexpr size_t WeightSamples = 256;
+    static constexpr uint32_t NoEdge = 0xffffffffu;
+
+    [[nodiscard]]
+    size_t index(glm::ivec2 node) const {
+        return to<size_t>(node.y) * to<size_t>(m_cells.x + 1) + to<size_t>(node.x);
+    }
+
+    [[nodiscard]]
+    glm::vec2 position(glm::ivec2 node) const {
+        return m_origin + glm::vec2(node) * m_cellSize;
+    }
+
+    [[nodiscard]]
+    size_t numTiles() const {
+        return to<size_t>(m_tiles.x) * to<size_t>(m_tiles.y);
+    }
+
+    // first node of a tile, the tile covers TileNodes nodes along each axis from it
+    [[nodiscard]]
+    glm::ivec2 tileFirst(size_t tile) const {
+        return glm::ivec2{ to<int>(tile % to<size_t>(m_tiles.x)), to<int>(tile / to<size_t>(m_tiles.x)) } * TileNodes;
+    }
+
+    [[nodiscard]]
+    bool hasFluid(glm::ivec2 tile) const {
+        return tile.x < m_tiles.x && tile.y < m_tiles.y && m_fluidTiles[to<size_t>(tile.y) * to<size_t>(m_tiles.x) + to<size_t>(tile.x)];
+    }
+
+    // every node of a tile is written by the tile alone, the particles come in the order of the
+    // spatial hash so each node sums them in the same order whatever the number of threads
+    template<template<typename> typename Layout>
+    void computeField(Particle2D<Layout>& particles) {
+        const auto positions = particles.position();
+        const auto support2 = m_support * m_support;
+        const auto weightScale = to<float>(WeightSamples) / support2;
+        const auto halfTile = glm::vec2(0.5f * m_cellSize * TileNodes);
+
+        forEachTile([&](size_t tile){
+            const auto first = tileFirst(tile);
+            const auto last = glm::min(first + TileNodes - 1, m_cells);
+            for(auto y = first.y; y <= last.y; y++){
+                std::fill_n(m_field.begin() + to<std::ptrdiff_t>(index({ first.x, y })), last.x - first.x + 1, 0.f);
+            }
+            m_fluidTiles[tile] = 0;
+
+            // the ring of nodes around the grid stays empty
+            const auto lower = glm::max(first, glm::ivec2(1));
+            const auto upper = glm::min(last, m_cells - 1);
+            if(lower.x > upper.x || lower.y > upper.y) return;
+
+            const auto center = position(first) + halfTile;
+            bool fluid = false;
+            m_grid.forEachNeighbour(center, halfTile + m_support, [&](int32_t j){
+                const auto xj = positions[j];
+                const auto nodeMin = glm::max(lower, glm::ivec2(glm::ceil((xj - m_support - m_origin) / m_cellSize)));
+                const auto nodeMax = glm::min(upper, glm::ivec2(glm::floor((xj + m_support - m_origin) / m_cellSize)));
+                for(auto y = nodeMin.y; y <= nodeMax.y; y++){
+                    const auto row = m_field.data() + index({ 0, y });
+                    const auto dy = m_origin.y + to<float>(y) * m_cellSize - xj.y;
+                    for(auto x = nodeMin.x; x <= nodeMax.x; x++){
+                        const glm::vec2 R{ m_origin.x + to<float>(x) * m_cellSize - xj.x, dy };
+                        const auto r2 = glm::dot(R, R);
+                        if(r2 > support2) continue;
+                        const auto t = r2 * weightScale;
+                        const auto s = to<int>(t);
+                        row[x] += glm::mix(m_weights[s], m_weights[s + 1], t - to<float>(s));
+                        fluid = true;
+                    }
+                }
+            });
+            m_fluidTiles[tile] = fluid;
+        });
+    }
+
+    // edge 2 * index(node) runs from node along x, 2 * index(node) + 1 along y
+    [[nodiscard]]
+    uint32_t edge(glm::ivec2 node, int axis) const {
+        return to<uint32_t>(2 * index(node) + to<size_t>(axis));
+    }
+
+    [[nodiscard]]
+    glm::vec2 crossing(uint32_t edge) const {
+        const auto node = edge / 2;
+        const auto a = m_field[node];
+        const auto b = m_field[node + ((edge & 1) ? to<size_t>(m_cells.x + 1) : 1)];
+        const glm::ivec2 n{ to<int>(node % to<size_t>(m_cells.x + 1)), to<int>(node / to<size_t>(m_cells.x + 1)) };
+        auto p = position(n);
+        p[to<glm::length_t>(edge & 1)] += (m_isoValue - a) / (b - a) * m_cellSize;
+        return p;
+    }
+
+    // cells of a tile are those with their lower left node in the tile, their corners lie in the
+    // tile and the ones to its right and top, without fluid in any of them the tile is skipped.
+    // Every crossing is where exactly one segment of the contour starts, the cell that owns the
+    // segment links the crossing to the next one in m_next and computes its position
+    void march() {
+        // segments per case from edge to edge (bottom, right, top, left), corners bottom left, bottom
+        // right, top right, top left are bits 0 to 3. The saddles 5 and 10 join the inside corners
+        // when the middle of the cell is inside and are the second table
+        static constexpr std::array<std::array<int8_t, 4>, 16> Segments{{
+            {-1, -1, -1, -1}, {0, 3, -1, -1}, {1, 0, -1, -1}, {1, 3, -1, -1},
+            {2, 1, -1, -1}, {0, 3, 2, 1}, {2, 0, -1, -1}, {2, 3, -1, -1},
+            {3, 2, -1, -1}, {0, 2, -1, -1}, {1, 0, 3, 2}, {1, 2, -1, -1},
+            {3, 1, -1, -1}, {0, 1, -1, -1}, {3, 0, -1, -1}, {-1, -1, -1, -1},
+        }};
+        static constexpr std::array<std::array<int8_t, 4>, 2> Saddles{{
+            {0, 1, 2, 3}, {3, 0, 1, 2},
+        }};
+
+        forEachTile([&](size_t tile){
+            m_contourTiles[tile] = 0;
+            const auto first = tileFirst(tile);
+            const auto t = first / TileNodes;
+            if(!hasFluid(t) && !hasFluid(t + glm::ivec2(1, 0)) && !hasFluid(t + glm::ivec2(0, 1)) && !hasFluid(t + 1)) return;
+
+            const auto last = glm::min(first + TileNodes, m_cells);
+            for(auto y = first.y; y < last.y; y++){
+                for(auto x = first.x; x < last.x; x++){
+                    const std::array<float, 4> corners{
+                        field({ x, y }), field({ x + 1, y }), field({ x + 1, y + 1 }), field({ x, y + 1 }) };
+                    uint32_t configuration = 0;
+                    for(auto corner = 0u; corner < 4; corner++){
+                        configuration |= (corners[corner] >= m_isoValue ? 1u : 0u) << corner;
+                    }
+                    if(configuration == 0 || configuration == 15) continue;
+
+                    const std::array<uint32_t, 4> edges{
+                        edge({ x, y }, 0), edge({ x + 1, y }, 1), edge({ x, y + 1 }, 0), edge({ x, y }, 1) };
+                    auto segments = Segments[configuration];
+                    if(configuration == 5 || configuration == 10) {
+                        const auto middle = 0.25f * (corners[0] + corners[1] + corners[2] + corners[3]);
+                        if(middle >= m_isoValue) {
+                            segments = Saddles[configuration == 5 ? 0 : 1];
+                        }
+                    }
+                    for(auto s = 0; s < 4 && segments[s] >= 0; s += 2){
+                        const auto from = edges[segments[s]];
+                        m_next[from] = edges[segments[s + 1]];
+                        m_crossings[from] = crossing(from);
+                    }
+                    m_contourTiles[tile] = 1;
+                }
+            }
+        });
+    }
+
+    // follows the links from the unvisited crossings, clearing them for the next frame. A crossing
+    // is on the bottom or left edge of a cell the contour passes through, so only the bottom and
+    // left edges of the cells of tiles with a contour are searched, in tile and then edge order
+    void stitch() {
+        m_polylines.clear();
+        for(auto tile = 0u; tile < numTiles(); tile++){
+            if(!m_contourTiles[tile]) continue;
+            const auto first = tileFirst(tile);
+            const auto last = glm::min(first + TileNodes, m_cells);
+            for(auto y = first.y; y < last.y; y++){
+                for(auto x = first.x; x < last.x; x++){
+                    for(const auto start : { edge({ x, y }, 0), edge({ x, y }, 1) }){
+                        if(m_next[start] == NoEdge) continue;
+                        // the contour is closed, the link back to start ends the polyline without
+                        // adding start a second time
+                        auto e = start;
+                        do {
+                            m_polylines.points.push_back(m_crossings[e]);
+                            e = std::exchange(m_next[e], NoEdge);
+                        } while(e != start && e != NoEdge);
+                        m_polylines.offsets.push_back(to<uint32_t>(m_polylines.points.size()));
+                    }
+                }
+            }
+        }
+    }
+
+    // fn(tile) for every tile, with a pool thread t takes the tiles t, t + numThreads(), ... so the
+    // tiles with fluid are spread over all threads wherever the fluid is
+    template<typename Fn>
+    void forEachTile(Fn&& fn) {
+        const auto tiles = numTiles();
+        const auto stride = to<size_t>(numThreads());
+        forEach(stride, [&](size_t begin, size_t end){
+            for(auto lane = begin; lane < end; lane++){
+                for(auto tile = lane; tile < tiles; tile += stride){
+                    fn(tile);
+                }
+            }
+        });
+    }
+
+    // fn(begin, end) over [0, count), split over the pool when there is one
+    template<typename Fn>
+    void forEach(size_t count, Fn&& fn) {
+        if(m_threadPool) {
+            m_threadPool->dispatch(to<uint32_t>(count), fn);
+        } else {
+            fn(size_t{0}, count);
+        }
+    }
+
+    float m_cellSize;
+    float m_support;
+    float m_isoValue;
+    glm::vec2 m_origin;
+    glm::ivec2 m_cells;
+    glm::ivec2 m_tiles;
+    Kernel m_kernel;
+    float m_inverseRestWeight{1};
+    // W / W0 over r^2 in [0, support^2], one zero sample past the support
+    std::array<float, WeightSamples + 2> m_weights{};
+    std::vector<float> m_field;
+    std::vector<uint32_t> m_next;
+    std::vector<glm::vec2> m_crossings;
+    // per tile, written by the tile alone
+    std::vector<uint8_t> m_fluidTiles;
+    std::vector<uint8_t> m_contourTiles;
+    Polylines m_polylines;
+    UnBoundedSpacialHashGrid2D m_grid;
+    // borrowed, serial without one
+    tp::ThreadPool* m_threadPool{};
+};
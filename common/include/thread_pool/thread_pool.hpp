@@ -45,9 +45,13 @@ namespace tp
         }
     };
 
+    // tasks live in a ring buffer that only grows when it is full, a std::queue (std::deque) allocates
+    // and frees a node every few tasks, so a pool dispatching every frame would allocate every frame
     struct TaskQueue
     {
-        std::queue<std::function<void()>> m_tasks;
+        std::vector<std::function<void()>> m_tasks = std::vector<std::function<void()>>(64);
+        size_t                            m_head  = 0;
+        size_t                            m_count = 0;
         std::mutex                        m_mutex;
         std::atomic<uint32_t>             m_remaining_tasks = 0;
 
@@ -55,7 +59,11 @@ namespace tp
         void addTask(TCallback&& callback)
         {
             std::lock_guard<std::mutex> lock_guard{m_mutex};
-            m_tasks.push(std::forward<TCallback>(callback));
+            if (m_count == m_tasks.size()) {
+                grow();
+            }
+            m_tasks[(m_head + m_count) % m_tasks.size()] = std::forward<TCallback>(callback);
+            m_count++;
             m_remaining_tasks++;
         }
 
@@ -63,14 +71,26 @@ namespace tp
         {
             {
                 std::lock_guard<std::mutex> lock_guard{m_mutex};
-                if (m_tasks.empty()) {
+                if (m_count == 0) {
                     return;
                 }
-                target_callback = std::move(m_tasks.front());
-                m_tasks.pop();
+                target_callback = std::move(m_tasks[m_head]);
+                m_tasks[m_head] = nullptr;
+                m_head = (m_head + 1) % m_tasks.size();
+                m_count--;
             }
         }
 
+        void grow()
+        {
+            std::vector<std::function<void()>> tasks(m_tasks.size() * 2);
+            for (size_t i = 0; i < m_count; ++i) {
+                tasks[i] = std::move(m_tasks[(m_head + i) % m_tasks.size()]);
+            }
+            m_tasks = std::move(tasks);
+            m_head = 0;
+        }
+
         static void wait()
         {
             std::this_thread::yield();
@@ -189,6 +209,9 @@ namespace tp
             for (Worker& worker : m_workers) {
                 worker.stop();
             }
+            for (Worker2& worker : m_workers2) {
+                worker.stop();
+            }
         }
 
         template<typename TCallback>
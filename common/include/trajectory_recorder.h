@@ -0,0 +1,210 @@
+#pragma once
+
+#include "particle.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams particle positions and velocities to disk without blocking the simulation thread.
+//
+//  [FileHeader][FrameHeader][zlib payload][FrameHeader][zlib payload]...[IndexEntry * frameCount]
+//
+// capture() copies the particles into one of two staging buffers and returns, a writer thread
+// quantises each frame, delta encodes it against the previous written frame (every keyFrameInterval
+// frames is stored whole), shuffles the bytes into planes and compresses them. If both staging
+// buffers are still owned by the writer the frame is dropped rather than waiting for the disk. A frame
+// that fails to compress or write is skipped and the next one is encoded against the last frame on
+// disk, so readers never see a delta against a frame they do not have.
+namespace trajectory {
+
+    constexpr std::array<char, 8> Magic{'P', 'P', 'T', 'R', 'A', 'J', '\0', '\0'};
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t KeyFrame = 1u;
+
+    struct FileHeader {
+        std::array<char, 8> magic{Magic};
+        uint32_t version{Version};
+        uint32_t dimension{2};
+        float positionStep{};
+        float velocityStep{};
+        uint32_t keyFrameInterval{};
+        uint32_t reserved{};
+        uint64_t indexOffset{};     // zero until the recorder is closed
+        uint64_t frameCount{};
+    };
+    static_assert(sizeof(FileHeader) == 48);
+
+    struct FrameHeader {
+        uint64_t step{};            // capture number, gaps are dropped frames
+        double time{};
+        uint32_t count{};
+        uint32_t flags{};
+        uint64_t compressedBytes{};
+        uint64_t rawBytes{};
+    };
+    static_assert(sizeof(FrameHeader) == 40);
+
+    struct IndexEntry {
+        uint64_t offset{};          // file offset of the FrameHeader
+        uint64_t step{};
+        double time{};
+        uint32_t count{};
+        uint32_t flags{};
+    };
+    static_assert(sizeof(IndexEntry) == 32);
+
+    // zlib compress2 of raw into compressed (resized to the compressed size), false on failure
+    bool compress(std::span<const char> raw, std::vector<char>& compressed, int level);
+
+    using Compressor = std::function<bool(std::span<const char> raw, std::vector<char>& compressed, int level)>;
+
+    struct Settings {
+        float positionStep{1e-4f};  // quantisation step, decoded values are within step / 2
+        float velocityStep{1e-3f};
+        uint32_t keyFrameInterval{60};
+        int compressionLevel{1};
+        Compressor compressor{compress};    // called on the writer thread, the output has to be a zlib stream
+    };
+
+    struct Counters {
+        uint64_t captured{};
+        uint64_t written{};
+        uint64_t dropped{};         // frames discarded because both staging buffers were busy
+        uint64_t backPressure{};    // frames staged while the writer was still behind
+        uint64_t failed{};          // frames that could not be compressed or written
+        uint64_t rawBytes{};
+        uint64_t compressedBytes{};
+    };
+
+    class Recorder {
+    public:
+        explicit Recorder(const std::string& path, Settings settings = {});
+
+        ~Recorder();
+
+        Recorder(const Recorder&) = delete;
+
+        Recorder& operator=(const Recorder&) = delete;
+
+        // call at the end of a solve, returns false if the frame was dropped
+        template<template<typename> typename Layout>
+        bool capture(const Particle2D<Layout>& particles, double time) {
+            auto staging = acquire();
+            if(!staging) return false;
+
+            const auto size = particles.size();
+            auto position = particles.position();
+            auto velocity = particles.velocity();
+            staging->position.resize(size);
+            staging->velocity.resize(size);
+            for(auto i = 0; i < size; i++){
+                staging->position[i] = position[i];
+                staging->velocity[i] = velocity[i];
+            }
+            publish(*staging, time);
+            return true;
+        }
+
+        bool capture(std::span<const glm::vec2> position, std::span<const glm::vec2> velocity, double time);
+
+        // blocks until every frame captured so far has been written or failed
+        void flush();
+
+        // writes the remaining staged frames and the frame index, called by the destructor
+        void close();
+
+        [[nodiscard]]
+        Counters counters() const;
+
+    private:
+        enum State : uint32_t { Free = 0, Filling, Ready, Writing };
+
+        struct Staging {
+            std::vector<glm::vec2> position;
+            std::vector<glm::vec2> velocity;
+            uint64_t step{};
+            double time{};
+            std::atomic<uint32_t> state{Free};
+        };
+
+        Staging* acquire();
+
+        void publish(Staging& staging, double time);
+
+        void run();
+
+        void write(const Staging& staging);
+
+        std::ofstream m_file;
+        FileHeader m_header{};
+        Settings m_settings;
+        std::array<Staging, 2> m_staging{};
+        std::vector<IndexEntry> m_index;
+        uint64_t m_nextStep{};
+
+        // writer thread state, m_next becomes m_previous once its frame is on disk
+        std::vector<glm::ivec4> m_previous;
+        std::vector<glm::ivec4> m_next;
+        std::vector<uint32_t> m_values;
+        std::vector<char> m_raw;
+        std::vector<char> m_compressed;
+
+        std::atomic<uint64_t> m_captured{};
+        std::atomic<uint64_t> m_written{};
+        std::atomic<uint64_t> m_dropped{};
+        std::atomic<uint64_t> m_backPressure{};
+        std::atomic<uint64_t> m_failed{};
+        std::atomic<uint64_t> m_rawBytes{};
+        std::atomic<uint64_t> m_compressedBytes{};
+
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::condition_variable m_idle;
+        bool m_stop{false};
+        std::thread m_writer;
+    };
+
+    // random access to a recorded trajectory, sequential reads only decode one frame each
+    class Reader {
+    public:
+        explicit Reader(const std::string& path);
+
+        [[nodiscard]]
+        size_t frameCount() const {
+            return m_index.size();
+        }
+
+        [[nodiscard]]
+        const IndexEntry& frame(size_t id) const {
+            return m_index.at(id);
+        }
+
+        [[nodiscard]]
+        const FileHeader& header() const {
+            return m_header;
+        }
+
+        void read(size_t id, std::vector<glm::vec2>& position, std::vector<glm::vec2>& velocity);
+
+    private:
+        void decode(size_t id);
+
+        std::ifstream m_file;
+        uint64_t m_size{};
+        FileHeader m_header{};
+        std::vector<IndexEntry> m_index;
+        std::vector<glm::ivec4> m_current;
+        std::vector<char> m_raw;
+        std::vector<char> m_compressed;
+        int64_t m_decoded{-1};
+    };
+}
@@ -2,6 +2,7 @@
 
 #include "particle_emitter.h"
 #include "point_generators.h"
+#include "sdf_expression.h"
 #include <glm/glm.hpp>
 #include <random>
 #include <limits>
@@ -17,6 +18,23 @@ public:
             Bounds2D bounds,
             float spacing);
 
+    // the SDF is evaluated over batches of points instead of one std::function call per point
+    VolumeEmitter2D(
+            csg::Sdf sdf,
+            std::unique_ptr<PointGenerator2D> pointGenerator,
+            Bounds2D bounds,
+            float spacing);
+
+    template<csg::Shape S>
+    requires (!std::same_as<S, csg::Sdf>)
+    VolumeEmitter2D(
+            S shape,
+            std::unique_ptr<PointGenerator2D> pointGenerator,
+            Bounds2D bounds,
+            float spacing)
+    : VolumeEmitter2D(csg::Sdf{ std::move(shape) }, std::move(pointGenerator), bounds, spacing)
+    {}
+
     VolumeEmitter2D() = default;
 
     ~VolumeEmitter2D() override = default;
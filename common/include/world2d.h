@@ -7,6 +7,8 @@
 #include "particle.h"
 #include "world2d.h"
 #include "profile.h"
+#include "frame_stats.h"
+#include "trajectory_recorder.h"
 #include <VulkanBaseApp.h>
 #include <GraphicsPipelineBuilder.hpp>
 #include <DescriptorSetBuilder.hpp>
@@ -118,7 +120,14 @@ private:
         VkDescriptorSet descriptorSet;
     } m_render;
     int m_numIterations{8};
-    std::array<double, 100> execTime{};
+    stats::FrameStats m_frameStats;
+    // looked up once in the constructor, phase() takes a lock
+    stats::Histogram& m_emitTime;
+    stats::Histogram& m_solveTime;
+    stats::Histogram& m_recordTime;
+    stats::Histogram& m_transferTime;
+    std::unique_ptr<trajectory::Recorder> m_recorder;
+    double m_simulationTime{};
 
 
     float m_restitution{0.5};
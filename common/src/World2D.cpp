@@ -1,5 +1,7 @@
 #include "world2d.h"
 #include "serializer.h"
+#include "binary_snapshot.h"
+#include "allocation_tracker.h"
 #include "profile.h"
 #include "c_debug.h"
 #include "multi_threaded_solver_2d.h"
@@ -16,10 +18,27 @@
 #include "stb_image.h"
 static int g_iterations = 0;
 
+namespace {
+    // world.yaml has always named the bounds min and max, Bounds describes itself as lower and upper
+    struct WorldBounds {
+        const Bounds2D& bounds;
+
+        template<typename Visitor>
+        void snapshot(Visitor& visitor) const {
+            visitor.value("min", bounds.lower);
+            visitor.value("max", bounds.upper);
+        }
+    };
+}
+
 template<template<typename> typename Layout>
 World2D<Layout>::World2D(const std::string &title, Bounds2D bounds, uDimension screenDim, Emitters<Layout>&& emitters, float radius)
         : VulkanBaseApp(title, create(screenDim))
         , m_bounds(bounds)
+        , m_emitTime(m_frameStats.phase("emit"))
+        , m_solveTime(m_frameStats.phase("solve"))
+        , m_recordTime(m_frameStats.phase("record"))
+        , m_transferTime(m_frameStats.phase("transfer"))
         , emitters(std::move(emitters))
         , m_radius(radius)
 {
@@ -96,8 +115,7 @@ void World2D<Layout>::renderOverlay(VkCommandBuffer commandBuffer) {
     ImGui::SetWindowPos({0, 0});
     ImGui::SetWindowSize({ 500, 500 });
 
-    auto avg = std::accumulate(execTime.begin(), execTime.end(), 0.0);
-    avg /= (to<double>(execTime.size()));
+    const auto step = m_frameStats.step().summary();
 
     auto& collisionStats = solver->collisionStats;
     auto cAvg = std::accumulate(collisionStats.average.begin(), collisionStats.average.end(), 0.0);
@@ -106,7 +124,8 @@ void World2D<Layout>::renderOverlay(VkCommandBuffer commandBuffer) {
 
 
 
-    ImGui::TextColored({1, 1, 1, 1}, "physics %d ms/frame", to<int>(avg));
+    ImGui::TextColored({1, 1, 1, 1}, "physics %.2f ms/frame (p50 %.2f, p95 %.2f, p99 %.2f, max %.2f)",
+                       step.mean, step.p50, step.p95, step.p99, step.max);
     ImGui::TextColored({1, 1, 1, 1}, "%d frames/second", framePerSecond);
     ImGui::TextColored({1, 1, 1, 1}, "%d particles", particles.handle->size());
     ImGui::TextColored({1, 1, 1, 1}, "%d total collisions", collisionStats.total);
@@ -153,7 +172,7 @@ void World2D<Layout>::renderOverlay(VkCommandBuffer commandBuffer) {
 
     ImGui::Begin("controls");
     float y = pausePhysics ? 100 : 80;
-    ImGui::SetWindowSize({250, y});
+    ImGui::SetWindowSize({380, y});
 //    ImGui::Checkbox("debug", &debugMode);
 //    if(debugMode){
 //        ImGui::SameLine();
@@ -168,6 +187,22 @@ void World2D<Layout>::renderOverlay(VkCommandBuffer commandBuffer) {
 
     ImGui::SameLine();
 
+    if(ImGui::Button("dump stats")){
+        m_frameStats.dump("world_stats.json");
+    }
+
+    ImGui::SameLine();
+
+    if(ImGui::Button(m_recorder ? "stop recording" : "record")){
+        if(m_recorder) {
+            m_recorder.reset();
+        } else {
+            m_recorder = std::make_unique<trajectory::Recorder>("world.ptraj");
+        }
+    }
+
+    ImGui::SameLine();
+
     if(ImGui::Button("restart")){
         particles.handle->clear();
         for(auto& emitter : emitters){
@@ -204,6 +239,7 @@ void World2D<Layout>::update(float time) {
             }
         }
     }
+    stats::ScopedTimer timer{m_transferTime};
     transferStateToGPU();
 }
 
@@ -211,16 +247,25 @@ template<template<typename> typename Layout>
 void World2D<Layout>::fixedUpdate(float deltaTime) {
     initDebug();
 //    colorParticles();
-    static int count = 0;
-    for(auto& emitter : emitters) {
-        emitter->update(deltaTime);
+    stats::ScopedTimer stepTimer{m_frameStats.step()};
+    {
+        alloc::Scope scope{"emit"};
+        stats::ScopedTimer timer{m_emitTime};
+        for(auto& emitter : emitters) {
+            emitter->update(deltaTime);
+        }
     }
-    auto duration = profile<chrono::milliseconds>([&] {
+    {
+        alloc::Scope scope{"solve"};
+        stats::ScopedTimer timer{m_solveTime};
         g_iterations++;
         solver->solve(deltaTime);
-    });
-    execTime[count++] = to<double>(duration.count());
-    count %= execTime.size();
+        m_simulationTime += deltaTime;
+    }
+    if(m_recorder){
+        stats::ScopedTimer timer{m_recordTime};
+        m_recorder->capture(*particles.handle, m_simulationTime);
+    }
 //    for(auto i : ballCollisions){
 //        particles.color[i] = {0.961, 0.714, 0.260, 1};
 //    }
@@ -415,6 +460,7 @@ void World2D<Layout>::createParticles() {
 //    loadParticles();
     solver = std::make_unique<VarletIntegrationSolver<Layout>>(particles.handle, m_bounds, m_radius, m_numIterations);
 //    solver = std::make_unique<VoidSolver<Layout>>();
+    solver->attach(m_frameStats);
     colorParticles();
 
 }
@@ -474,6 +520,7 @@ void World2D<Layout>::colorParticles() {
     for(auto& emitter : emitters){
         emitter->clear();
     }
+    m_frameStats.clear();
 //    g_iterations = 0;
 }
 
@@ -571,26 +618,20 @@ Dimension World2D<Layout>::computeSimDimensions(float simWidth, Dimension screen
 
 template<template<typename> typename Layout>
 void World2D<Layout>::snapshot() {
-    YAML::Emitter emitter;
-    emitter << YAML::BeginMap;
-    emitter << YAML::Key << "bounds";
-    emitter << YAML::Value;
-    emitter << YAML::BeginMap;
-        emitter << YAML::Key << "min";
-        emitter << YAML::Value << YAML::BeginSeq << m_bounds.lower.x << m_bounds.lower.y << YAML::EndSeq;
-        emitter << YAML::Key << "max";
-        emitter << YAML::Value << YAML::BeginSeq << m_bounds.upper.x << m_bounds.upper.y << YAML::EndSeq;
-    emitter << YAML::EndMap;
-
-    emitter << YAML::Key << "particles";
-    emitter << YAML::Value;
-    emitter << *particles.handle;
-
-    emitter << YAML::EndMap;
+    if constexpr (std::is_same_v<Particle2D<Layout>, SeparateFieldParticle2D>) {
+        ::snapshot::write("world.psnap", *particles.handle, m_bounds);
+        return;
+    }
+
+    // particles are written field by field, one sequence per field, not as a list of particles
+    std::string yaml;
+    yaml::Writer writer{yaml};
+    writer.object("bounds", WorldBounds{ m_bounds });
+    writer.object("particles", *particles.handle);
 
     std::ofstream fout{"world.yaml"};
     if(fout.bad()) return;
-    fout << emitter.c_str();
+    fout << yaml;
 }
 
 template World2D<InterleavedMemoryLayout>;
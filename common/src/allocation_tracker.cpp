@@ -0,0 +1,199 @@
+#include "allocation_tracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace alloc {
+
+    namespace {
+        std::atomic_bool g_enabled{false};
+        std::atomic_size_t g_count{0};
+        std::atomic_size_t g_bytes{0};
+        std::atomic_size_t g_frees{0};
+        std::atomic_size_t g_generation{0};
+
+        thread_local Stats t_stats{};
+        thread_local size_t t_generation{0};
+        thread_local bool t_suspended{false};
+
+        std::mutex g_phaseMutex;
+
+        std::map<std::string, Stats>& phaseTable() {
+            static std::map<std::string, Stats> table;
+            return table;
+        }
+
+        // the calling thread's counters, reset() zeroes those of other threads when they next use them
+        inline Stats& threadCounters() {
+            if(const auto generation = g_generation.load(std::memory_order_relaxed); generation != t_generation) {
+                t_stats = {};
+                t_generation = generation;
+            }
+            return t_stats;
+        }
+
+        inline void recordAllocation(size_t size) {
+            if(!g_enabled.load(std::memory_order_relaxed) || t_suspended) return;
+            auto& stats = threadCounters();
+            stats.count++;
+            stats.bytes += size;
+            g_count.fetch_add(1, std::memory_order_relaxed);
+            g_bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        inline void recordFree(void* ptr) {
+            if(!ptr || !g_enabled.load(std::memory_order_relaxed) || t_suspended) return;
+            threadCounters().frees++;
+            g_frees.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // bookkeeping done by the tracker itself must not show up in the counters
+        struct Suspend {
+            bool previous{ std::exchange(t_suspended, true) };
+            ~Suspend() { t_suspended = previous; }
+        };
+    }
+
+    bool available() {
+#ifdef TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void enable() {
+        g_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void disable() {
+        g_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    bool enabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    Stats threadStats() {
+        return threadCounters();
+    }
+
+    Stats globalStats() {
+        return {
+            g_count.load(std::memory_order_relaxed),
+            g_bytes.load(std::memory_order_relaxed),
+            g_frees.load(std::memory_order_relaxed)
+        };
+    }
+
+    void reset() {
+        g_generation.fetch_add(1, std::memory_order_relaxed);
+        g_count.store(0, std::memory_order_relaxed);
+        g_bytes.store(0, std::memory_order_relaxed);
+        g_frees.store(0, std::memory_order_relaxed);
+    }
+
+    std::map<std::string, Stats> phases() {
+        Suspend suspend{};
+        std::lock_guard<std::mutex> lock{g_phaseMutex};
+        return phaseTable();
+    }
+
+    void clearPhases() {
+        Suspend suspend{};
+        std::lock_guard<std::mutex> lock{g_phaseMutex};
+        phaseTable().clear();
+    }
+
+    Scope::Scope(const char* name, bool record)
+    : m_name(name)
+    , m_start(threadCounters())
+    , m_generation(t_generation)
+    , m_record(record)
+    {}
+
+    Scope::~Scope() {
+        if(!m_record || !enabled()) return;
+        const auto delta = stats();
+
+        Suspend suspend{};
+        std::lock_guard<std::mutex> lock{g_phaseMutex};
+        phaseTable()[std::string{m_name}] += delta;
+    }
+
+    // a reset() while the scope is open restarts it from zero
+    Stats Scope::stats() const {
+        const auto& counters = threadCounters();
+        return t_generation == m_generation ? counters - m_start : counters;
+    }
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+namespace {
+
+    void* allocate(size_t size) {
+        alloc::recordAllocation(size);
+        if(auto ptr = std::malloc(size == 0 ? 1 : size)){
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+
+    void* allocate(size_t size, std::align_val_t alignment) {
+        alloc::recordAllocation(size);
+        const auto align = static_cast<size_t>(alignment);
+        size = (size + align - 1) & ~(align - 1);
+#ifdef _MSC_VER
+        auto ptr = _aligned_malloc(size == 0 ? align : size, align);
+#else
+        auto ptr = std::aligned_alloc(align, size == 0 ? align : size);
+#endif
+        if(ptr) {
+            return ptr;
+        }
+        throw std::bad_alloc{};
+    }
+
+    void release(void* ptr) noexcept {
+        alloc::recordFree(ptr);
+        std::free(ptr);
+    }
+
+    void release(void* ptr, std::align_val_t) noexcept {
+        alloc::recordFree(ptr);
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch(...) { return nullptr; }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch(...) { return nullptr; }
+}
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete(void* ptr, std::align_val_t alignment) noexcept { release(ptr, alignment); }
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept { release(ptr, alignment); }
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept { release(ptr, alignment); }
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept { release(ptr, alignment); }
+
+#endif
@@ -0,0 +1,72 @@
+#include "binary_snapshot.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace snapshot {
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &path) {
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(m_file == INVALID_HANDLE_VALUE) {
+            m_file = nullptr;
+            throw std::runtime_error{ fmt::format("unable to open {}", path) };
+        }
+        LARGE_INTEGER size{};
+        GetFileSizeEx(m_file, &size);
+        m_size = static_cast<size_t>(size.QuadPart);
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if(!m_mapping) {
+            CloseHandle(m_file);
+            throw std::runtime_error{ fmt::format("unable to map {}", path) };
+        }
+        m_data = static_cast<char*>(MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0));
+        if(!m_data) {
+            CloseHandle(m_mapping);
+            CloseHandle(m_file);
+            throw std::runtime_error{ fmt::format("unable to map {}", path) };
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if(m_data) UnmapViewOfFile(m_data);
+        if(m_mapping) CloseHandle(m_mapping);
+        if(m_file) CloseHandle(m_file);
+    }
+#else
+    MappedFile::MappedFile(const std::string &path) {
+        auto fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::runtime_error{ fmt::format("unable to open {}", path) };
+        }
+        struct stat info{};
+        if(fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            throw std::runtime_error{ fmt::format("unable to map {}", path) };
+        }
+        m_size = static_cast<size_t>(info.st_size);
+
+        // private + writable gives copy on write pages, the simulation can keep going from a snapshot
+        auto ptr = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(ptr == MAP_FAILED) {
+            throw std::runtime_error{ fmt::format("unable to map {}", path) };
+        }
+        m_data = static_cast<char*>(ptr);
+    }
+
+    MappedFile::~MappedFile() {
+        if(m_data) munmap(m_data, m_size);
+    }
+#endif
+
+}
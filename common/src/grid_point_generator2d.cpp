@@ -1,4 +1,5 @@
 #include "generator/grid_point_generator2d.h"
+#include "types.h"
 
 void GridPointGenerator2D::forEachPoint(const Bounds2D &bounds, float spacing, Callback callback) const {
     const auto [boxWidth, boxHeight] = dimensions(bounds);
@@ -16,4 +17,27 @@ void GridPointGenerator2D::forEachPoint(const Bounds2D &bounds, float spacing, C
             }
         }
     }
-}
\ No newline at end of file
+}
+
+GridPointGenerator2D::Rows GridPointGenerator2D::rows(const Bounds2D &bounds, float spacing) const {
+    const auto [boxWidth, boxHeight] = dimensions(bounds);
+
+    // same loop conditions as forEachPoint so both agree on the last row and column
+    size_t columns = 0;
+    for (int i = 0; i * spacing <= boxWidth; ++i) {
+        columns++;
+    }
+
+    std::vector<size_t> offsets{ 0 };
+    for (int j = 0; j * spacing <= boxHeight; ++j) {
+        offsets.push_back(offsets.back() + columns);
+    }
+    return { std::move(offsets) };
+}
+
+void GridPointGenerator2D::row(const Bounds2D &bounds, float spacing, size_t row, std::span<glm::vec2> points) const {
+    const auto y = to<int>(row) * spacing + bounds.lower.y;
+    for (int i = 0; i < to<int>(points.size()); ++i) {
+        points[i] = glm::vec2{ i * spacing + bounds.lower.x, y };
+    }
+}
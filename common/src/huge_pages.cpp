@@ -0,0 +1,131 @@
+#include "huge_pages.h"
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace hugepages {
+
+    namespace {
+        std::atomic_bool g_enabled{false};
+
+        enum class Backing { Explicit, Transparent };
+
+        struct Mapping {
+            size_t length{};
+            Backing backing{};
+        };
+
+        // huge page mappings by address, everything else came from operator new
+        std::mutex g_mutex;
+        std::unordered_map<void*, Mapping> g_mappings;
+        Stats g_stats{};
+
+        size_t alignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+#if defined(__linux__)
+        void* mapExplicit(size_t length) {
+            auto ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            return ptr == MAP_FAILED ? nullptr : ptr;
+        }
+
+        // over maps by a page so the mapping can be trimmed to a 2 MB boundary, a transparent huge
+        // page is only used for 2 MB aligned ranges
+        void* mapTransparent(size_t length) {
+            auto ptr = mmap(nullptr, length + PageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(ptr == MAP_FAILED) return nullptr;
+
+            const auto address = reinterpret_cast<uintptr_t>(ptr);
+            const auto aligned = alignUp(address, PageSize);
+            if(aligned > address) {
+                munmap(ptr, aligned - address);
+            }
+            if(const auto tail = address + length + PageSize - (aligned + length); tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + length), tail);
+            }
+            ptr = reinterpret_cast<void*>(aligned);
+            if(madvise(ptr, length, MADV_HUGEPAGE) != 0) {
+                spdlog::debug("madvise(MADV_HUGEPAGE) failed, {} bytes stay on regular pages", length);
+            }
+            return ptr;
+        }
+#endif
+
+        void* map(size_t bytes) {
+#if defined(__linux__)
+            const auto length = alignUp(bytes, PageSize);
+            auto backing = Backing::Explicit;
+            auto ptr = mapExplicit(length);
+            if(!ptr) {
+                backing = Backing::Transparent;
+                ptr = mapTransparent(length);
+            }
+            if(!ptr) return nullptr;
+
+            std::lock_guard lock{ g_mutex };
+            g_mappings.emplace(ptr, Mapping{ length, backing });
+            (backing == Backing::Explicit ? g_stats.explicitBytes : g_stats.transparentBytes) += length;
+            return ptr;
+#else
+            return nullptr;
+#endif
+        }
+
+        bool unmap(void* ptr) {
+#if defined(__linux__)
+            Mapping mapping;
+            {
+                std::lock_guard lock{ g_mutex };
+                auto itr = g_mappings.find(ptr);
+                if(itr == g_mappings.end()) return false;
+                mapping = itr->second;
+                g_mappings.erase(itr);
+                (mapping.backing == Backing::Explicit ? g_stats.explicitBytes : g_stats.transparentBytes) -= mapping.length;
+            }
+            munmap(ptr, mapping.length);
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+
+    void enable() {
+        g_enabled = true;
+    }
+
+    void disable() {
+        g_enabled = false;
+    }
+
+    bool enabled() {
+        return g_enabled;
+    }
+
+    void* allocate(size_t bytes) {
+        if(g_enabled.load(std::memory_order_relaxed) && bytes >= PageSize) {
+            if(auto ptr = map(bytes)) {
+                return ptr;
+            }
+        }
+        return ::operator new(bytes);
+    }
+
+    void deallocate(void* ptr, size_t bytes) {
+        if(!ptr) return;
+        if(bytes >= PageSize && unmap(ptr)) return;
+        ::operator delete(ptr);
+    }
+
+    Stats stats() {
+        std::lock_guard lock{ g_mutex };
+        return g_stats;
+    }
+}
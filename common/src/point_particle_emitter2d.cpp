@@ -24,4 +24,5 @@ PointParticleEmitter2D<Layout>::Builder PointParticleEmitter2D<Layout>::builder(
 
 
 template PointParticleEmitter2D<InterleavedMemoryLayout>;
-template PointParticleEmitter2D<SeparateFieldMemoryLayout>;
\ No newline at end of file
+template PointParticleEmitter2D<SeparateFieldMemoryLayout>;
+template PointParticleEmitter2D<PagedMemoryLayout>;
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "generator/poisson_disk_point_generator2d.h"
+#include "parallel.h"
+#include "types.h"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+    constexpr int TileSizeInCells = 64;
+
+    // conflicting points can only lie two cells away, the outer cells are padding so neighbour
+    // lookups never leave the grid
+    constexpr int Padding = 2;
+
+    struct Grid {
+        Grid(const Bounds2D& bounds, float spacing)
+        : origin(bounds.lower)
+        , cellSize(spacing / std::sqrt(2.0f))
+        , inverseCellSize(1.0f / cellSize)
+        {
+            const auto [width, height] = dimensions(bounds);
+            columns = std::max(1, to<int>(std::ceil(width * inverseCellSize)));
+            rows = std::max(1, to<int>(std::ceil(height * inverseCellSize)));
+            stride = columns + 2 * Padding;
+            cells.assign(to<size_t>(stride) * (rows + 2 * Padding), glm::vec2{ Empty });
+
+            // the 21 cells of the 5x5 block that can hold a point closer than spacing, nearest
+            // first so most rejected candidates are rejected after a cell or two. A point in the
+            // candidate's own cell is always too close
+            std::vector<glm::ivec2> offsets;
+            for(auto y = -2; y <= 2; y++){
+                for(auto x = -2; x <= 2; x++){
+                    if(std::abs(x) == 2 && std::abs(y) == 2) continue;
+                    offsets.push_back({x, y});
+                }
+            }
+            std::stable_sort(offsets.begin(), offsets.end(), [](auto a, auto b){ return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y; });
+            for(auto i = 0u; i < neighbours.size(); i++){
+                neighbours[i] = offsets[i].y * stride + offsets[i].x;
+            }
+        }
+
+        [[nodiscard]]
+        glm::ivec2 cellOf(const glm::vec2& point) const {
+            auto cell = glm::ivec2((point - origin) * inverseCellSize);
+            return { std::clamp(cell.x, 0, columns - 1), std::clamp(cell.y, 0, rows - 1) };
+        }
+
+        [[nodiscard]]
+        size_t index(int x, int y) const {
+            return to<size_t>(y + Padding) * stride + x + Padding;
+        }
+
+        [[nodiscard]]
+        const glm::vec2& at(int x, int y) const {
+            return cells[index(x, y)];
+        }
+
+        // empty cells are infinitely far from everything so the distance test needs no branch
+        static constexpr float Empty = std::numeric_limits<float>::infinity();
+
+        glm::vec2 origin;
+        float cellSize;
+        float inverseCellSize;
+        int columns{};
+        int rows{};
+        int stride{};
+        std::array<int, 21> neighbours{};
+        std::vector<glm::vec2> cells;
+    };
+
+    struct Sampler {
+        Grid& grid;
+        std::vector<std::vector<glm::vec2>>& tiles;
+        const Bounds2D& bounds;
+        float spacing;
+        int attempts;
+
+        [[nodiscard]]
+        bool accepts(const glm::vec2& candidate) const {
+            const auto cell = grid.cellOf(candidate);
+            const auto* centre = grid.cells.data() + grid.index(cell.x, cell.y);
+            const auto rr = spacing * spacing;
+            // the five nearest cells reject most candidates, each group is tested without a branch
+            // per cell
+            auto free = [&](size_t begin, size_t end){
+                bool result = true;
+                for(auto i = begin; i < end; i++){
+                    const auto d = centre[grid.neighbours[i]] - candidate;
+                    result &= glm::dot(d, d) >= rr;
+                }
+                return result;
+            };
+            return free(0, 5) && free(5, grid.neighbours.size());
+        }
+
+        // fills the cells [lower, upper) of the grid, reading neighbouring tiles but only adding
+        // points inside its own cells.
+        //
+        // Candidates are spread evenly on a circle just beyond spacing around the active point,
+        // starting at a random angle (Roberts' variant of Bridson). They pack denser than uniform
+        // annulus samples and need fewer attempts, each attempt is a rotation instead of sin/cos.
+        void fill(int tile, glm::ivec2 lower, glm::ivec2 upper, std::mt19937& rng) {
+            auto& points = tiles[tile];
+            const glm::vec2 tileLower = grid.origin + glm::vec2(lower) * grid.cellSize;
+            const glm::vec2 tileUpper = glm::min(grid.origin + glm::vec2(upper) * grid.cellSize, bounds.upper);
+
+            // tileUpper is clipped to the bounds
+            auto inside = [&](const glm::vec2& p){
+                return p.x >= tileLower.x && p.x < tileUpper.x && p.y >= tileLower.y && p.y < tileUpper.y;
+            };
+
+            auto insert = [&](const glm::vec2& p){
+                const auto cell = grid.cellOf(p);
+                grid.cells[grid.index(cell.x, cell.y)] = p;
+                points.push_back(p);
+            };
+
+            auto unit = [&rng]{ return to<float>(rng() >> 8) * (1.0f / 16777216.0f); };
+
+            constexpr auto TwoPi = 6.28318530718f;
+            const auto radius = spacing * 1.0001f;
+            const auto step = TwoPi / to<float>(attempts);
+            const glm::vec2 rotation{ std::cos(step), std::sin(step) };
+
+            // origin is a copy, spreading the tile's own points appends to them
+            auto spread = [&](glm::vec2 origin){
+                const auto angle = TwoPi * unit();
+                glm::vec2 direction{ std::cos(angle), std::sin(angle) };
+                for(auto attempt = 0; attempt < attempts; attempt++){
+                    const glm::vec2 candidate = origin + radius * direction;
+                    if(inside(candidate) && accepts(candidate)) {
+                        insert(candidate);
+                    }
+                    direction = { direction.x * rotation.x - direction.y * rotation.y, direction.x * rotation.y + direction.y * rotation.x };
+                }
+            };
+
+            // points of finished neighbours next to the tile grow into it first, then a random
+            // start for tiles no neighbour reaches. The tile's own points are retired in the order
+            // they were added, so they are their own queue of active points. The cells of the
+            // tile fill up while its neighbours spread and are skipped
+            for(auto y = std::max(0, lower.y - 2); y < std::min(grid.rows, upper.y + 2); y++){
+                for(auto x = std::max(0, lower.x - 2); x < std::min(grid.columns, upper.x + 2); x++){
+                    if(x >= lower.x && x < upper.x && y >= lower.y && y < upper.y) continue;
+                    if(const auto p = grid.at(x, y); p.x != Grid::Empty) spread(p);
+                }
+            }
+
+            const auto start = tileLower + (tileUpper - tileLower) * glm::vec2{ unit(), unit() };
+            if(inside(start) && accepts(start)) {
+                insert(start);
+            }
+
+            for(size_t next = 0; next < points.size(); next++){
+                spread(points[next]);
+            }
+        }
+    };
+}
+
+PoissonDiskPointGenerator2D::PoissonDiskPointGenerator2D(uint32_t seed, int attempts, bool tiled)
+: m_seed(seed)
+, m_attempts(attempts)
+, m_tiled(tiled)
+{}
+
+PoissonDiskPointGenerator2D::Tiles PoissonDiskPointGenerator2D::sample(const Bounds2D &bounds, float spacing) const {
+    Grid grid{ bounds, spacing };
+    const auto tileSize = m_tiled ? TileSizeInCells : std::max(grid.columns, grid.rows);
+    const auto tilesX = (grid.columns + tileSize - 1) / tileSize;
+    const auto tilesY = (grid.rows + tileSize - 1) / tileSize;
+
+    Tiles result(to<size_t>(tilesX) * tilesY);
+    Sampler sampler{ grid, result, bounds, spacing, m_attempts };
+
+    // tiles of the same pass are a tile apart, their reads (two cells around the tile) never
+    // reach cells another tile of the pass writes
+    for(auto pass = 0; pass < 4; pass++){
+        std::vector<int> tiles;
+        for(auto ty = pass / 2; ty < tilesY; ty += 2){
+            for(auto tx = pass % 2; tx < tilesX; tx += 2){
+                tiles.push_back(ty * tilesX + tx);
+            }
+        }
+
+        parallel::forEach(tiles.size(), [&](size_t begin, size_t end){
+            for(auto i = begin; i < end; i++){
+                const auto tile = tiles[i];
+                const glm::ivec2 lower{ (tile % tilesX) * tileSize, (tile / tilesX) * tileSize };
+                const glm::ivec2 upper = glm::min(lower + tileSize, glm::ivec2{ grid.columns, grid.rows });
+                std::seed_seq seq{ m_seed, to<uint32_t>(tile) };
+                std::mt19937 rng{ seq };
+                sampler.fill(tile, lower, upper, rng);
+            }
+        }, 1);
+    }
+
+    return result;
+}
+
+void PoissonDiskPointGenerator2D::forEachPoint(const Bounds2D &bounds, float spacing, Callback callback) const {
+    for(const auto& tile : sample(bounds, spacing)){
+        for(const auto& point : tile){
+            if(!callback(point)) {
+                return;
+            }
+        }
+    }
+}
+
+void PoissonDiskPointGenerator2D::generate(const Bounds2D &bounds, float spacing, const Allocate& allocate) const {
+    const auto tiles = sample(bounds, spacing);
+    std::vector<size_t> offsets{ 0 };
+    for(const auto& tile : tiles){
+        offsets.push_back(offsets.back() + tile.size());
+    }
+    forEachRow(offsets, allocate(offsets.back()), [&tiles](size_t tile, std::span<glm::vec2> points){
+        std::copy(tiles[tile].begin(), tiles[tile].end(), points.begin());
+    });
+}
+
+size_t PoissonDiskPointGenerator2D::count(const Bounds2D &bounds, float spacing) const {
+    size_t numPoints = 0;
+    for(const auto& tile : sample(bounds, spacing)){
+        numPoints += tile.size();
+    }
+    return numPoints;
+}
@@ -4,6 +4,8 @@ SphSim::SphSim(const std::string &title, Bounds2D bounds, uDimension screenDim,
         : VulkanBaseApp(title, create(screenDim))
         , m_bounds(bounds)
         , m_emitters(std::move(emitters))
+        , m_emitTime(m_frameStats.phase("emit"))
+        , m_solveTime(m_frameStats.phase("solve"))
 {
     std::unique_ptr<Plugin> plugin = std::make_unique<ImGuiPlugin>();
     addPlugin(plugin);
@@ -62,7 +64,6 @@ void SphSim::createParticles() {
 
 
     solver = std::make_unique<SphSolver2D<SeparateFieldMemoryLayout>>(
-            Kernel2D{},
             particles.handle.smoothingRadius,
             0.1f,
             particles.handle.gasConstant,
@@ -73,6 +74,7 @@ void SphSim::createParticles() {
             particles.handle.data,
             m_bounds,
             1);
+    solver->attach(m_frameStats);
 
     options.h = particles.handle.smoothingRadius;
     options.k = particles.handle.gasConstant/options.h;
@@ -265,7 +267,7 @@ void SphSim::renderOverlay(VkCommandBuffer commandBuffer) {
     auto& imgui = plugin<ImGuiPlugin>(IM_GUI_PLUGIN);
 
     ImGui::Begin("Smoothed particle hydrodynamics");
-    ImGui::SetWindowSize({400, 150});
+    ImGui::SetWindowSize({400, 180});
     ImGui::SliderFloat("smoothing radius", &options.h, 0.1, 1.0);
     ImGui::SliderFloat("gravity", &options.g, 0, 100);
     ImGui::SliderFloat("pressure constant", &options.k, 35, 750);
@@ -282,6 +284,11 @@ void SphSim::renderOverlay(VkCommandBuffer commandBuffer) {
         }
     }
     ImGui::Text("FPS %d, particles: %zu", framePerSecond, particles.handle.data->size());
+    const auto step = m_frameStats.step().summary();
+    ImGui::Text("step p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", step.p50, step.p95, step.p99, step.max);
+    if(ImGui::Button("dump stats")){
+        m_frameStats.dump("sph_stats.json");
+    }
     ImGui::End();
     
     imgui.draw(commandBuffer);
@@ -305,9 +312,14 @@ void SphSim::update(float time) {
 }
 
 void SphSim::fixedUpdate(float deltaTime) {
-    for(auto& emitter : m_emitters){
-        emitter->update(deltaTime);
+    stats::ScopedTimer stepTimer{m_frameStats.step()};
+    {
+        stats::ScopedTimer timer{m_emitTime};
+        for(auto& emitter : m_emitters){
+            emitter->update(deltaTime);
+        }
     }
+    stats::ScopedTimer timer{m_solveTime};
     solver->solve(deltaTime);
 }
 
@@ -319,8 +331,8 @@ void SphSim::transferStateToGPU() {
     grid.initialize(*particles.handle.data, particles.handle.data->size());
     gpuSpacialHash.constants.spacing = grid.numSpacing();
     gpuSpacialHash.constants.tableSize = grid.size();
-    gpuSpacialHash.countsCopy.copy(grid.counts());
-    gpuSpacialHash.cellEntriesCopy.copy(grid.entries());
+    gpuSpacialHash.countsCopy.copy(grid.counts().data(), BYTE_SIZE(grid.counts()));
+    gpuSpacialHash.cellEntriesCopy.copy(grid.entries().data(), BYTE_SIZE(grid.entries()));
 
     device.graphicsCommandPool().oneTimeCommand([&](auto commandBuffer){
         device.copy(particles.pBuffer, particles.buffer, particles.pBuffer.size);
@@ -446,6 +458,7 @@ void SphSim::newFrame() {
             emitter->enable();
         }
         particles.handle.data->clear();
+        m_frameStats.clear();
         options.start = true;
     }
 }
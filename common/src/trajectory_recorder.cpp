@@ -0,0 +1,354 @@
+#include "trajectory_recorder.h"
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace trajectory {
+
+    namespace {
+        constexpr int Components = 4;   // position.xy, velocity.xy
+
+        uint32_t zigzag(int32_t value) {
+            return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        }
+
+        int32_t unzigzag(uint32_t value) {
+            return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+        }
+
+        int32_t quantise(float value, float step) {
+            return static_cast<int32_t>(std::lround(value / step));
+        }
+
+        // byte i of every value is stored together, small deltas leave the upper planes mostly zero
+        void shuffle(std::span<const uint32_t> values, std::span<char> bytes) {
+            const auto n = values.size();
+            for(auto i = 0u; i < n; i++){
+                for(auto b = 0u; b < sizeof(uint32_t); b++){
+                    bytes[b * n + i] = static_cast<char>((values[i] >> (8 * b)) & 0xFF);
+                }
+            }
+        }
+
+        void unshuffle(std::span<const char> bytes, std::span<uint32_t> values) {
+            const auto n = values.size();
+            for(auto i = 0u; i < n; i++){
+                uint32_t value = 0;
+                for(auto b = 0u; b < sizeof(uint32_t); b++){
+                    value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[b * n + i])) << (8 * b);
+                }
+                values[i] = value;
+            }
+        }
+    }
+
+    bool compress(std::span<const char> raw, std::vector<char>& compressed, int level) {
+        auto compressedBytes = compressBound(static_cast<uLong>(raw.size()));
+        compressed.resize(compressedBytes);
+        const auto result = compress2(as<Bytef>(compressed.data()), &compressedBytes,
+                                      as<const Bytef>(raw.data()), static_cast<uLong>(raw.size()), level);
+        if(result != Z_OK) {
+            spdlog::error("trajectory compression failed: {}", result);
+            return false;
+        }
+        compressed.resize(compressedBytes);
+        return true;
+    }
+
+    Recorder::Recorder(const std::string& path, Settings settings)
+    : m_file(path, std::ios::binary | std::ios::trunc)
+    , m_settings(settings)
+    {
+        if(!m_file.good()) {
+            throw std::runtime_error{ fmt::format("unable to open {} for writing", path) };
+        }
+        if(settings.positionStep <= 0 || settings.velocityStep <= 0 || settings.keyFrameInterval == 0 || !settings.compressor) {
+            throw std::runtime_error{ "invalid trajectory recorder settings" };
+        }
+        m_header.positionStep = settings.positionStep;
+        m_header.velocityStep = settings.velocityStep;
+        m_header.keyFrameInterval = settings.keyFrameInterval;
+        m_file.write(as<char>(&m_header), sizeof(m_header));
+
+        m_writer = std::thread{ [this]{ run(); } };
+    }
+
+    Recorder::~Recorder() {
+        close();
+    }
+
+    bool Recorder::capture(std::span<const glm::vec2> position, std::span<const glm::vec2> velocity, double time) {
+        auto staging = acquire();
+        if(!staging) return false;
+
+        staging->position.assign(position.begin(), position.end());
+        staging->velocity.assign(velocity.begin(), velocity.end());
+        publish(*staging, time);
+        return true;
+    }
+
+    Recorder::Staging* Recorder::acquire() {
+        m_captured.fetch_add(1, std::memory_order_relaxed);
+        const auto step = m_nextStep++;
+
+        for(auto i = 0; i < 2; i++){
+            auto expected = to<uint32_t>(Free);
+            if(m_staging[i].state.compare_exchange_strong(expected, Filling, std::memory_order_acquire)){
+                if(m_staging[1 - i].state.load(std::memory_order_relaxed) != Free){
+                    m_backPressure.fetch_add(1, std::memory_order_relaxed);
+                }
+                m_staging[i].step = step;
+                return &m_staging[i];
+            }
+        }
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    void Recorder::publish(Staging& staging, double time) {
+        staging.time = time;
+        staging.state.store(Ready, std::memory_order_release);
+        {
+            // the writer only holds the lock to check for work, never while encoding or writing
+            std::lock_guard<std::mutex> lock{m_mutex};
+        }
+        m_ready.notify_one();
+    }
+
+    void Recorder::flush() {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_idle.wait(lock, [&]{
+            return std::ranges::all_of(m_staging, [](const auto& staging){ return staging.state.load(std::memory_order_acquire) == Free; });
+        });
+    }
+
+    void Recorder::run() {
+        auto next = [this]() -> Staging* {
+            Staging* result = nullptr;
+            for(auto& staging : m_staging){
+                if(staging.state.load(std::memory_order_acquire) == Ready && (!result || staging.step < result->step)){
+                    result = &staging;
+                }
+            }
+            return result;
+        };
+
+        while(true){
+            Staging* staging;
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_ready.wait(lock, [&]{ return next() != nullptr || m_stop; });
+                staging = next();
+                if(!staging) break;
+            }
+            staging->state.store(Writing, std::memory_order_relaxed);
+            write(*staging);
+            staging->state.store(Free, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+            }
+            m_idle.notify_all();
+        }
+    }
+
+    void Recorder::write(const Staging& staging) {
+        const auto count = staging.position.size();
+        const bool keyFrame = m_index.size() % m_settings.keyFrameInterval == 0;
+
+        m_values.resize(count * Components);
+        m_next.resize(count);
+        for(auto i = 0u; i < count; i++){
+            const glm::ivec4 q{
+                quantise(staging.position[i].x, m_settings.positionStep),
+                quantise(staging.position[i].y, m_settings.positionStep),
+                quantise(staging.velocity[i].x, m_settings.velocityStep),
+                quantise(staging.velocity[i].y, m_settings.velocityStep)
+            };
+            // particles added since the previous frame, or removed and back again, start from zero
+            const auto delta = keyFrame || i >= m_previous.size() ? q : q - m_previous[i];
+            for(auto c = 0; c < Components; c++){
+                m_values[c * count + i] = zigzag(delta[c]);
+            }
+            m_next[i] = q;
+        }
+
+        m_raw.resize(m_values.size() * sizeof(uint32_t));
+        shuffle(m_values, m_raw);
+
+        if(!m_settings.compressor(m_raw, m_compressed, m_settings.compressionLevel)) {
+            spdlog::error("trajectory frame {} skipped, compression failed", staging.step);
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const auto compressedBytes = m_compressed.size();
+
+        FrameHeader frame{};
+        frame.step = staging.step;
+        frame.time = staging.time;
+        frame.count = static_cast<uint32_t>(count);
+        frame.flags = keyFrame ? KeyFrame : 0;
+        frame.compressedBytes = compressedBytes;
+        frame.rawBytes = m_raw.size();
+
+        IndexEntry entry{};
+        entry.offset = static_cast<uint64_t>(m_file.tellp());
+        entry.step = frame.step;
+        entry.time = frame.time;
+        entry.count = frame.count;
+        entry.flags = frame.flags;
+
+        m_file.write(as<char>(&frame), sizeof(frame));
+        m_file.write(m_compressed.data(), static_cast<std::streamsize>(compressedBytes));
+        if(!m_file.good()) {
+            spdlog::error("error writing trajectory frame {}", staging.step);
+            m_failed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_index.push_back(entry);
+        std::swap(m_previous, m_next);
+
+        m_written.fetch_add(1, std::memory_order_relaxed);
+        m_rawBytes.fetch_add(frame.rawBytes, std::memory_order_relaxed);
+        m_compressedBytes.fetch_add(frame.compressedBytes, std::memory_order_relaxed);
+    }
+
+    void Recorder::close() {
+        if(!m_writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_ready.notify_one();
+        m_writer.join();
+
+        m_header.indexOffset = static_cast<uint64_t>(m_file.tellp());
+        m_header.frameCount = m_index.size();
+        m_file.write(as<char>(m_index.data()), static_cast<std::streamsize>(m_index.size() * sizeof(IndexEntry)));
+        m_file.seekp(0);
+        m_file.write(as<char>(&m_header), sizeof(m_header));
+        m_file.close();
+    }
+
+    Counters Recorder::counters() const {
+        return {
+            m_captured.load(std::memory_order_relaxed),
+            m_written.load(std::memory_order_relaxed),
+            m_dropped.load(std::memory_order_relaxed),
+            m_backPressure.load(std::memory_order_relaxed),
+            m_failed.load(std::memory_order_relaxed),
+            m_rawBytes.load(std::memory_order_relaxed),
+            m_compressedBytes.load(std::memory_order_relaxed)
+        };
+    }
+
+    Reader::Reader(const std::string& path)
+    : m_file(path, std::ios::binary)
+    {
+        if(!m_file.good()) {
+            throw std::runtime_error{ fmt::format("unable to open {}", path) };
+        }
+        m_file.read(as<char>(&m_header), sizeof(m_header));
+        if(!m_file.good() || m_header.magic != Magic) {
+            throw std::runtime_error{ fmt::format("{} is not a particle trajectory", path) };
+        }
+        if(m_header.version == 0 || m_header.version > Version) {
+            throw std::runtime_error{ fmt::format("trajectory version {} is not supported, expected 1 to {}", m_header.version, Version) };
+        }
+        m_file.seekg(0, std::ios::end);
+        m_size = static_cast<uint64_t>(m_file.tellg());
+
+        if(m_header.indexOffset != 0) {
+            // sizes read from the file are checked against it before anything is allocated
+            if(m_header.indexOffset > m_size || m_header.frameCount > (m_size - m_header.indexOffset) / sizeof(IndexEntry)) {
+                throw std::runtime_error{ fmt::format("trajectory {} has a truncated index", path) };
+            }
+            m_index.resize(m_header.frameCount);
+            m_file.seekg(static_cast<std::streamoff>(m_header.indexOffset));
+            m_file.read(as<char>(m_index.data()), static_cast<std::streamsize>(m_index.size() * sizeof(IndexEntry)));
+            if(!m_file.good()) {
+                throw std::runtime_error{ fmt::format("trajectory {} has a truncated index", path) };
+            }
+            return;
+        }
+
+        // the recorder was not closed, rebuild the index from the frames that were written completely
+        spdlog::warn("trajectory {} has no index, scanning frames", path);
+        const auto end = m_size;
+        for(uint64_t offset = sizeof(FileHeader); offset + sizeof(FrameHeader) <= end;){
+            FrameHeader frame{};
+            m_file.seekg(static_cast<std::streamoff>(offset));
+            m_file.read(as<char>(&frame), sizeof(frame));
+            if(!m_file.good() || offset + sizeof(FrameHeader) + frame.compressedBytes > end) break;
+            m_index.push_back({ offset, frame.step, frame.time, frame.count, frame.flags });
+            offset += sizeof(FrameHeader) + frame.compressedBytes;
+        }
+        m_file.clear();
+    }
+
+    void Reader::read(size_t id, std::vector<glm::vec2>& position, std::vector<glm::vec2>& velocity) {
+        if(id >= m_index.size()) {
+            throw std::out_of_range{ fmt::format("trajectory frame {} out of range, {} frames recorded", id, m_index.size()) };
+        }
+
+        if(m_decoded != static_cast<int64_t>(id)) {
+            auto start = id;
+            while(!(m_index[start].flags & KeyFrame) && static_cast<int64_t>(start) != m_decoded + 1){
+                start--;
+            }
+            for(auto i = start; i <= id; i++){
+                decode(i);
+            }
+        }
+
+        const auto count = m_index[id].count;
+        position.resize(count);
+        velocity.resize(count);
+        for(auto i = 0u; i < count; i++){
+            position[i] = glm::vec2(m_current[i].x, m_current[i].y) * m_header.positionStep;
+            velocity[i] = glm::vec2(m_current[i].z, m_current[i].w) * m_header.velocityStep;
+        }
+    }
+
+    void Reader::decode(size_t id) {
+        const auto& entry = m_index[id];
+        m_decoded = -1;
+        FrameHeader frame{};
+        m_file.seekg(static_cast<std::streamoff>(entry.offset));
+        m_file.read(as<char>(&frame), sizeof(frame));
+        if(!m_file.good() || entry.offset + sizeof(FrameHeader) > m_size || frame.compressedBytes > m_size - entry.offset - sizeof(FrameHeader)) {
+            throw std::runtime_error{ fmt::format("trajectory frame {} is corrupt", id) };
+        }
+        m_compressed.resize(frame.compressedBytes);
+        m_file.read(m_compressed.data(), static_cast<std::streamsize>(m_compressed.size()));
+        if(!m_file.good() || frame.rawBytes != uint64_t{frame.count} * Components * sizeof(uint32_t)) {
+            throw std::runtime_error{ fmt::format("trajectory frame {} is corrupt", id) };
+        }
+
+        m_raw.resize(frame.rawBytes);
+        auto rawBytes = static_cast<uLongf>(m_raw.size());
+        const auto result = uncompress(as<Bytef>(m_raw.data()), &rawBytes, as<const Bytef>(m_compressed.data()), static_cast<uLong>(m_compressed.size()));
+        if(result != Z_OK || rawBytes != m_raw.size()) {
+            throw std::runtime_error{ fmt::format("unable to decompress trajectory frame {}: {}", id, result) };
+        }
+
+        const auto count = frame.count;
+        std::vector<uint32_t> values(count * Components);
+        unshuffle(m_raw, values);
+
+        const bool keyFrame = frame.flags & KeyFrame;
+        const auto previousCount = m_current.size();
+        m_current.resize(count);
+        for(auto i = 0u; i < count; i++){
+            glm::ivec4 delta{0};
+            for(auto c = 0; c < Components; c++){
+                delta[c] = unzigzag(values[c * count + i]);
+            }
+            m_current[i] = keyFrame || i >= previousCount ? delta : m_current[i] + delta;
+        }
+        m_decoded = static_cast<int64_t>(id);
+    }
+}
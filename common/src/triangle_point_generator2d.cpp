@@ -1,4 +1,5 @@
 #include "generator/triangle_point_generator2d.h"
+#include "types.h"
 #include <cmath>
 
 void TrianglePointGenerator::forEachPoint(const Bounds2D &bounds, float spacing, Callback callback) const {
@@ -24,4 +25,34 @@ void TrianglePointGenerator::forEachPoint(const Bounds2D &bounds, float spacing,
 
         hasOffset = !hasOffset;
     }
-}
\ No newline at end of file
+}
+
+TrianglePointGenerator::Rows TrianglePointGenerator::rows(const Bounds2D &bounds, float spacing) const {
+    const auto halfSpacing = spacing / 2.0f;
+    const auto ySpacing = spacing * std::sqrtf(3.0f) / 2.0f;
+    const auto [boxWidth, boxHeight] = dimensions(bounds);
+
+    // same loop conditions as forEachPoint, odd rows are offset and may hold one point less
+    size_t columns[2]{};
+    for (auto k = 0; k < 2; ++k) {
+        const auto offset = k == 1 ? halfSpacing : 0.0f;
+        for (int i = 0; i * spacing + offset <= boxWidth; ++i) {
+            columns[k]++;
+        }
+    }
+
+    std::vector<size_t> offsets{ 0 };
+    for (int j = 0; j * ySpacing <= boxHeight; ++j) {
+        offsets.push_back(offsets.back() + columns[j % 2]);
+    }
+    return { std::move(offsets) };
+}
+
+void TrianglePointGenerator::row(const Bounds2D &bounds, float spacing, size_t row, std::span<glm::vec2> points) const {
+    const auto ySpacing = spacing * std::sqrtf(3.0f) / 2.0f;
+    const auto offset = (row % 2 == 1) ? spacing / 2.0f : 0.0f;
+    const auto y = to<int>(row) * ySpacing + bounds.lower.y;
+    for (int i = 0; i < to<int>(points.size()); ++i) {
+        points[i] = glm::vec2{ i * spacing + offset + bounds.lower.x, y };
+    }
+}
@@ -1,6 +1,16 @@
 #include "volume_emitter_2d.h"
 #include "emitter/volume_emitter.h"
 
+namespace {
+    ProtoTypeParticle2D prototype(float spacing) {
+        ProtoTypeParticle2D prototype{};
+        prototype.radius = spacing * .5;
+        prototype.inverseMass = 1.f;
+        prototype.restitution = 0.5;
+        return prototype;
+    }
+}
+
 template<template<typename> typename Layout>
 VolumeEmitter2D<Layout>::VolumeEmitter2D(std::function<float(const glm::vec2&)> sdf,
                                          std::unique_ptr<PointGenerator2D> pointGenerator,
@@ -11,11 +21,7 @@ VolumeEmitter2D<Layout>::VolumeEmitter2D(std::function<float(const glm::vec2&)>
 //, m_bounds(bounds)
 //, m_spacing(spacing)
 {
-    ProtoTypeParticle2D prototype{};
-    prototype.radius = spacing * .5;
-    prototype.inverseMass = 1.f;
-    prototype.restitution = 0.5;
-    this->m_consumer.set(prototype);
+    this->m_consumer.set(prototype(spacing));
     this->m_emitter = std::make_unique<VolumeEmitter<2, ParticlePointConsumer<Layout>>>(
             std::move(sdf),
             std::move(pointGenerator),
@@ -24,5 +30,24 @@ VolumeEmitter2D<Layout>::VolumeEmitter2D(std::function<float(const glm::vec2&)>
     );
 }
 
+template<template<typename> typename Layout>
+VolumeEmitter2D<Layout>::VolumeEmitter2D(csg::Sdf sdf,
+                                         std::unique_ptr<PointGenerator2D> pointGenerator,
+                                         Bounds2D bounds,
+                                         float spacing)
+{
+    using Emitter = VolumeEmitter<2, ParticlePointConsumer<Layout>>;
+    this->m_consumer.set(prototype(spacing));
+    this->m_emitter = std::make_unique<Emitter>(
+            typename Emitter::BatchSdf{ [sdf = std::move(sdf)](std::span<const glm::vec2> points, std::span<float> distance){
+                sdf.evaluate(points, distance);
+            }},
+            std::move(pointGenerator),
+            bounds,
+            spacing
+    );
+}
+
 template VolumeEmitter2D<InterleavedMemoryLayout>;
-template VolumeEmitter2D<SeparateFieldMemoryLayout>;
\ No newline at end of file
+template VolumeEmitter2D<SeparateFieldMemoryLayout>;
+template VolumeEmitter2D<PagedMemoryLayout>;
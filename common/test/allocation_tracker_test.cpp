@@ -0,0 +1,158 @@
+#include "allocation_tracker.h"
+#include "solver2d.h"
+#include "sph/sph_solver.h"
+#include "multi_threaded_solver_2d.h"
+#include <gtest/gtest.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class AllocationTrackerFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if(!alloc::available()) {
+            GTEST_SKIP() << "built without TRACK_ALLOCATIONS";
+        }
+        particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(NumParticles));
+        for(auto i = 0; i < NumParticles; i++) {
+            glm::vec2 position{ 1 + to<float>(i % 40) * 0.2f, 1 + to<float>(i / 40) * 0.2f };
+            particles->add(position, glm::vec2{0}, 1, 0.1f, 0.5f);
+        }
+        alloc::enable();
+    }
+
+    void TearDown() override {
+        alloc::disable();
+        alloc::clearPhases();
+    }
+
+    template<typename Solver>
+    alloc::Stats solveAfterWarmUp(Solver& solver) {
+        for(auto i = 0; i < WarmUpFrames; i++) {
+            solver.solve(TimeStep);
+        }
+        alloc::Scope scope{"solve"};
+        for(auto i = 0; i < Frames; i++) {
+            solver.solve(TimeStep);
+        }
+        return scope.stats();
+    }
+
+    // Scope only sees the calling thread, threaded solvers are measured on every thread. The pool
+    // workers spin while idle so nothing else allocates in between
+    template<typename Solver>
+    alloc::Stats solveOnAllThreadsAfterWarmUp(Solver& solver) {
+        for(auto i = 0; i < WarmUpFrames; i++) {
+            solver.solve(TimeStep);
+        }
+        const auto start = alloc::globalStats();
+        for(auto i = 0; i < Frames; i++) {
+            solver.solve(TimeStep);
+        }
+        return alloc::globalStats() - start;
+    }
+
+    static constexpr int NumParticles = 1600;
+    static constexpr int WarmUpFrames = 2;
+    static constexpr int Frames = 10;
+    static constexpr float TimeStep = 0.0166667f;
+    Bounds2D bounds{ glm::vec2(0), glm::vec2(20) };
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+};
+
+static void* volatile g_sink{};
+
+TEST_F(AllocationTrackerFixture, countsAllocationsInsideScope) {
+    alloc::Scope scope{"allocate"};
+    g_sink = ::operator new(64);
+    ::operator delete(g_sink);
+    g_sink = ::operator new(32);
+    ::operator delete(g_sink);
+
+    auto stats = scope.stats();
+    ASSERT_EQ(stats.count, 2);
+    ASSERT_EQ(stats.bytes, 96);
+    ASSERT_EQ(stats.frees, 2);
+}
+
+TEST_F(AllocationTrackerFixture, recordsNamedPhasesWhenScopeCloses) {
+    {
+        alloc::Scope scope{"phase"};
+        g_sink = ::operator new(128);
+        ::operator delete(g_sink);
+    }
+    auto phases = alloc::phases();
+    ASSERT_TRUE(phases.contains("phase"));
+    ASSERT_EQ(phases["phase"].count, 1);
+    ASSERT_EQ(phases["phase"].bytes, 128);
+}
+
+TEST_F(AllocationTrackerFixture, nothingIsCountedWhenDisabled) {
+    alloc::disable();
+    alloc::Scope scope{"disabled"};
+    g_sink = ::operator new(64);
+    ::operator delete(g_sink);
+
+    ASSERT_EQ(scope.stats().count, 0);
+}
+
+TEST_F(AllocationTrackerFixture, resetClearsTheCountersOfOtherThreads) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    int stage = 0;
+    alloc::Stats afterReset{};
+    std::thread worker{[&]{
+        g_sink = ::operator new(64);
+        ::operator delete(g_sink);
+        std::unique_lock lock{mutex};
+        stage = 1;
+        changed.notify_all();
+        changed.wait(lock, [&]{ return stage == 2; });
+        afterReset = alloc::threadStats();
+    }};
+    {
+        std::unique_lock lock{mutex};
+        changed.wait(lock, [&]{ return stage == 1; });
+        alloc::reset();
+        stage = 2;
+    }
+    changed.notify_all();
+    worker.join();
+
+    ASSERT_EQ(afterReset.count, 0);
+    ASSERT_EQ(afterReset.frees, 0);
+}
+
+TEST_F(AllocationTrackerFixture, explicitEulerSolverDoesNotAllocateAfterWarmUp) {
+    auto solver = std::make_unique<ExplicitEulerSolver<SeparateFieldMemoryLayout>>(particles, bounds, 0.1f, 4);
+    auto stats = solveAfterWarmUp(*solver);
+    ASSERT_EQ(stats.count, 0) << stats.bytes << " bytes allocated in solve()";
+}
+
+TEST_F(AllocationTrackerFixture, verletIntegrationSolverDoesNotAllocateAfterWarmUp) {
+    auto solver = std::make_unique<VarletIntegrationSolver<SeparateFieldMemoryLayout>>(particles, bounds, 0.1f, 4);
+    auto stats = solveAfterWarmUp(*solver);
+    ASSERT_EQ(stats.count, 0) << stats.bytes << " bytes allocated in solve()";
+}
+
+TEST_F(AllocationTrackerFixture, sphSolverDoesNotAllocateAfterWarmUp) {
+    auto solver = std::make_unique<SphSolver2D<SeparateFieldMemoryLayout>>(
+            0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 2);
+    auto stats = solveAfterWarmUp(*solver);
+    ASSERT_EQ(stats.count, 0) << stats.bytes << " bytes allocated in solve()";
+}
+
+TEST_F(AllocationTrackerFixture, threadedSphSolverDoesNotAllocateAfterWarmUp) {
+    auto solver = std::make_unique<SphSolver2D<SeparateFieldMemoryLayout>>(
+            0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 2, 4);
+    ASSERT_EQ(solver->numThreads(), 4);
+    auto stats = solveOnAllThreadsAfterWarmUp(*solver);
+    ASSERT_EQ(stats.count, 0) << stats.bytes << " bytes allocated in solve()";
+}
+
+TEST_F(AllocationTrackerFixture, multiThreadedSolverDoesNotAllocateAfterWarmUp) {
+    auto solver = std::make_unique<MultiThreadedSolver<SeparateFieldMemoryLayout>>(particles, bounds, 0.1f, 4, 4);
+    auto stats = solveOnAllThreadsAfterWarmUp(*solver);
+    ASSERT_EQ(stats.count, 0) << stats.bytes << " bytes allocated in solve()";
+}
@@ -0,0 +1,95 @@
+#include "binary_snapshot.h"
+#include "model2d.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <filesystem>
+#include <random>
+
+class BinarySnapshotFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "binary_snapshot_test.psnap").string();
+        particles = createSeparateFieldParticle2D(NumParticles);
+        std::default_random_engine engine{ 1 << 20 };
+        std::uniform_real_distribution<float> dist{0, 20};
+        for(auto i = 0; i < NumParticles; i++){
+            particles.add({dist(engine), dist(engine)}, {dist(engine), dist(engine)}, 1.f/(1 + i), 0.1f * i, 0.5f);
+        }
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    static constexpr int NumParticles = 1000;
+    std::string path;
+    SeparateFieldParticle2D particles;
+    Bounds2D bounds{ glm::vec2(-1, 0), glm::vec2(20, 30) };
+};
+
+TEST_F(BinarySnapshotFixture, roundTripRestoresAllFields) {
+    snapshot::write(path, particles, bounds);
+    auto loaded = snapshot::load<2>(path);
+
+    ASSERT_EQ(loaded.particles->size(), NumParticles);
+    ASSERT_EQ(loaded.bounds.lower, bounds.lower);
+    ASSERT_EQ(loaded.bounds.upper, bounds.upper);
+    for(auto i = 0; i < NumParticles; i++){
+        ASSERT_EQ(loaded.particles->position()[i], particles.position()[i]);
+        ASSERT_EQ(loaded.particles->previousPosition()[i], particles.previousPosition()[i]);
+        ASSERT_EQ(loaded.particles->velocity()[i], particles.velocity()[i]);
+        ASSERT_EQ(loaded.particles->inverseMass()[i], particles.inverseMass()[i]);
+        ASSERT_EQ(loaded.particles->restitution()[i], particles.restitution()[i]);
+        ASSERT_EQ(loaded.particles->radius()[i], particles.radius()[i]);
+    }
+}
+
+TEST_F(BinarySnapshotFixture, columnsAreAlignedAndSizedByCapacity) {
+    snapshot::write(path, particles, bounds, 4096);
+    auto loaded = snapshot::load<2>(path);
+
+    ASSERT_EQ(loaded.header.capacity, 4096);
+    ASSERT_EQ(loaded.particles->capacity(), 4096);
+    ASSERT_EQ(loaded.particles->size(), NumParticles);
+    auto address = reinterpret_cast<uintptr_t>(&loaded.particles->velocity()[0]);
+    ASSERT_EQ(address % snapshot::ColumnAlignment, 0);
+
+    loaded.particles->add(glm::vec2(1), glm::vec2(2), 1, 1, 1);
+    ASSERT_EQ(loaded.particles->size(), NumParticles + 1);
+}
+
+TEST_F(BinarySnapshotFixture, writesToMappedParticlesDoNotChangeTheFile) {
+    snapshot::write(path, particles, bounds);
+    {
+        auto loaded = snapshot::load<2>(path);
+        loaded.particles->position()[0] = glm::vec2(-100);
+    }
+    auto loaded = snapshot::load<2>(path);
+    ASSERT_EQ(loaded.particles->position()[0], particles.position()[0]);
+}
+
+TEST_F(BinarySnapshotFixture, rejectsFilesThatAreNotSnapshots) {
+    {
+        std::ofstream fout{path, std::ios::binary};
+        std::string garbage(256, 'x');
+        fout << garbage;
+    }
+    ASSERT_THROW(snapshot::load<2>(path), std::runtime_error);
+}
+
+TEST_F(BinarySnapshotFixture, rejectsSnapshotWithWrongDimension) {
+    snapshot::write(path, particles, bounds);
+    ASSERT_THROW(snapshot::load<3>(path), std::runtime_error);
+}
+
+TEST_F(BinarySnapshotFixture, rejectsUnknownVersions) {
+    for(auto version : { 0u, snapshot::Version + 1 }) {
+        snapshot::write(path, particles, bounds);
+        {
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(offsetof(snapshot::Header, version));
+            file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        }
+        ASSERT_THROW(snapshot::load<2>(path), std::runtime_error) << "version " << version;
+    }
+}
@@ -0,0 +1,182 @@
+#include "checkpoint.h"
+#include "sph/sph_solver.h"
+#include "volume_emitter_2d.h"
+#include "point_particle_emitter2d.h"
+#include "point_generators.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+
+class CheckpointFixture : public ::testing::Test {
+protected:
+    struct Scene {
+        std::shared_ptr<SeparateFieldParticle2D> particles;
+        std::unique_ptr<Solver2D<SeparateFieldMemoryLayout>> solver;
+        Emitters<SeparateFieldMemoryLayout> emitters;
+
+        void step(int frames) {
+            for(auto frame = 0; frame < frames; frame++){
+                for(auto& emitter : emitters){
+                    emitter->update(TimeStep);
+                }
+                solver->solve(TimeStep);
+            }
+        }
+    };
+
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "checkpoint_test.pckpt").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    Scene sphScene() {
+        Scene scene{};
+        scene.particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(MaxParticles));
+        std::function<float(const glm::vec2&)> sdf = [](const glm::vec2& point){ return point.y - 2.0f; };
+        scene.emitters.push_back(std::make_unique<VolumeEmitter2D<SeparateFieldMemoryLayout>>(
+                std::move(sdf), std::make_unique<TrianglePointGenerator>(), shrink(bounds, 0.1f), 0.2f));
+        scene.emitters.push_back(PointParticleEmitter2D<SeparateFieldMemoryLayout>::builder()
+                .withOrigin({5, 8})
+                .withDirection({1, 0})
+                .withSpeed(5)
+                .withSpreadAngleInDegrees(60)
+                .withMaxNumberOfNewParticlesPerSecond(200)
+                .withMaxNumberOfParticles(1000)
+                .withRadius(0.1f)
+                .withRandomSeed(7)
+                .makeUnique());
+        for(auto& emitter : scene.emitters){
+            emitter->set(scene.particles);
+        }
+        scene.solver = std::make_unique<SphSolver2D<SeparateFieldMemoryLayout>>(
+                0.2f, 0.1f, 20.f, 0.99f, 10.f, 1.f, MaxParticles, scene.particles, bounds, 2);
+        return scene;
+    }
+
+    Scene verletScene() {
+        auto scene = sphScene();
+        scene.solver = std::make_unique<VarletIntegrationSolver<SeparateFieldMemoryLayout>>(scene.particles, bounds, 0.1f, 4);
+        return scene;
+    }
+
+    static void assertBitwiseEqual(const Scene& expected, const Scene& actual) {
+        const auto& a = expected.particles->layout.data;
+        const auto& b = actual.particles->layout.data;
+        const auto n = expected.particles->size();
+        ASSERT_EQ(actual.particles->size(), n);
+        ASSERT_EQ(std::memcmp(a.position.data(), b.position.data(), n * sizeof(glm::vec2)), 0);
+        ASSERT_EQ(std::memcmp(a.prePosition.data(), b.prePosition.data(), n * sizeof(glm::vec2)), 0);
+        ASSERT_EQ(std::memcmp(a.velocity.data(), b.velocity.data(), n * sizeof(glm::vec2)), 0);
+        ASSERT_EQ(std::memcmp(a.radius.data(), b.radius.data(), n * sizeof(float)), 0);
+    }
+
+    static constexpr size_t MaxParticles = 10000;
+    static constexpr float TimeStep = 1.0f / 120.f;
+    Bounds2D bounds{ glm::vec2(0), glm::vec2(10) };
+    std::string path;
+};
+
+TEST_F(CheckpointFixture, sphRunContinuesBitwiseIdenticalAfterRestore) {
+    auto original = sphScene();
+    original.step(30);
+    checkpoint::save(path, *original.solver, original.emitters);
+    original.step(60);
+
+    auto restored = sphScene();
+    checkpoint::restore(path, *restored.solver, restored.emitters);
+    restored.step(60);
+
+    ASSERT_GT(original.particles->size(), 0);
+    assertBitwiseEqual(original, restored);
+}
+
+TEST_F(CheckpointFixture, verletRunContinuesBitwiseIdenticalAfterRestore) {
+    auto original = verletScene();
+    original.step(30);
+    checkpoint::save(path, *original.solver, original.emitters);
+    original.step(60);
+
+    auto restored = verletScene();
+    checkpoint::restore(path, *restored.solver, restored.emitters);
+    restored.step(60);
+
+    assertBitwiseEqual(original, restored);
+}
+
+TEST_F(CheckpointFixture, restoringIntoADifferentSolverFails) {
+    auto original = sphScene();
+    original.step(5);
+    checkpoint::save(path, *original.solver, original.emitters);
+
+    auto restored = verletScene();
+    ASSERT_THROW(checkpoint::restore(path, *restored.solver, restored.emitters), std::runtime_error);
+}
+
+TEST_F(CheckpointFixture, restoringWithADifferentRadiusFails) {
+    auto original = verletScene();
+    original.step(5);
+    checkpoint::save(path, *original.solver, original.emitters);
+
+    auto restored = verletScene();
+    restored.solver = std::make_unique<VarletIntegrationSolver<SeparateFieldMemoryLayout>>(restored.particles, bounds, 0.2f, 4);
+    ASSERT_THROW(checkpoint::restore(path, *restored.solver, restored.emitters), std::runtime_error);
+}
+
+TEST_F(CheckpointFixture, truncatedCheckpointFails) {
+    auto original = sphScene();
+    original.step(5);
+    checkpoint::save(path, *original.solver, original.emitters);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+
+    auto restored = sphScene();
+    ASSERT_THROW(checkpoint::restore(path, *restored.solver, restored.emitters), std::runtime_error);
+}
+
+TEST_F(CheckpointFixture, corruptLengthFailsBeforeAllocating) {
+    {
+        checkpoint::Writer writer{ path };
+        writer.write(std::numeric_limits<uint64_t>::max() / 8);
+        writer.write(std::string{ "abc" });
+        writer.write(std::numeric_limits<uint64_t>::max());
+        writer.close();
+    }
+    auto expectTruncated = [](auto&& read){
+        try {
+            read();
+            FAIL() << "expected a truncated checkpoint";
+        } catch(const std::runtime_error& error) {
+            ASSERT_NE(std::string{ error.what() }.find("is truncated"), std::string::npos) << error.what();
+        }
+    };
+
+    checkpoint::Reader reader{ path };
+    std::vector<double> values;
+    expectTruncated([&]{ reader.read(values); });
+
+    checkpoint::Reader strings{ path };
+    strings.read<uint64_t>();
+    std::string text;
+    strings.read(text);
+    ASSERT_EQ(text, "abc");
+    expectTruncated([&]{ strings.read(text); });
+}
+
+TEST_F(CheckpointFixture, adaptiveSubSteppingIsRestored) {
+    auto original = verletScene();
+    original.solver->subStepping({ .adaptive = true, .minSubSteps = 1, .maxSubSteps = 8 });
+    original.step(30);
+    checkpoint::save(path, *original.solver, original.emitters);
+    original.step(60);
+
+    auto restored = verletScene();
+    checkpoint::restore(path, *restored.solver, restored.emitters);
+    ASSERT_TRUE(restored.solver->subStepping().adaptive);
+    restored.step(60);
+
+    assertBitwiseEqual(original, restored);
+}
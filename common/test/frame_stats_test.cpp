@@ -0,0 +1,76 @@
+#include "frame_stats.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+class FrameStatsFixture : public ::testing::Test {};
+
+TEST_F(FrameStatsFixture, smallValuesHaveExactBuckets) {
+    for(uint64_t v = 0; v < 2 * stats::Histogram::SubBucketCount; v++){
+        auto index = stats::Histogram::bucketIndex(v);
+        ASSERT_EQ(stats::Histogram::bucketLowerBound(index), v);
+    }
+}
+
+TEST_F(FrameStatsFixture, bucketsCoverValueWithBoundedRelativeError) {
+    for(uint64_t v = 64; v < (uint64_t{1} << 34); v = v * 3 / 2 + 7){
+        auto index = stats::Histogram::bucketIndex(v);
+        auto lower = stats::Histogram::bucketLowerBound(index);
+        auto width = stats::Histogram::bucketWidth(index);
+        ASSERT_LE(lower, v);
+        ASSERT_LT(v, lower + width);
+        ASSERT_LE(static_cast<double>(width) / static_cast<double>(lower), 1.0 / stats::Histogram::SubBucketCount);
+    }
+}
+
+TEST_F(FrameStatsFixture, percentilesOfUniformDistribution) {
+    stats::Histogram histogram;
+    for(uint64_t v = 1; v <= 10000; v++){
+        histogram.record(v * 1000);    // 1us .. 10ms
+    }
+    ASSERT_EQ(histogram.count(), 10000);
+    ASSERT_NEAR(histogram.percentile(0.50), 5e6, 5e6 * 0.04);
+    ASSERT_NEAR(histogram.percentile(0.95), 9.5e6, 9.5e6 * 0.04);
+    ASSERT_NEAR(histogram.percentile(0.99), 9.9e6, 9.9e6 * 0.04);
+
+    auto summary = histogram.summary();
+    ASSERT_DOUBLE_EQ(summary.max, 10.0);
+    ASSERT_NEAR(summary.mean, 5.0005, 1e-6);
+}
+
+TEST_F(FrameStatsFixture, tailSpikeIsVisibleInMaxAndP99) {
+    stats::Histogram histogram;
+    for(auto i = 0; i < 985; i++) histogram.record(uint64_t{2'000'000});
+    for(auto i = 0; i < 15; i++) histogram.record(uint64_t{40'000'000});
+
+    auto summary = histogram.summary();
+    ASSERT_NEAR(summary.p50, 2.0, 2.0 * 0.04);
+    ASSERT_NEAR(summary.p99, 40.0, 40.0 * 0.04);
+    ASSERT_DOUBLE_EQ(summary.max, 40.0);
+}
+
+TEST_F(FrameStatsFixture, concurrentWritersAreAllCounted) {
+    stats::Histogram histogram;
+    constexpr int numThreads = 8;
+    constexpr int perThread = 20000;
+    std::vector<std::thread> threads;
+    for(auto t = 0; t < numThreads; t++){
+        threads.emplace_back([&histogram, t]{
+            for(auto i = 0; i < perThread; i++) histogram.record(uint64_t(1000 + t));
+        });
+    }
+    for(auto& thread : threads) thread.join();
+
+    ASSERT_EQ(histogram.count(), numThreads * perThread);
+}
+
+TEST_F(FrameStatsFixture, jsonContainsStepAndPhases) {
+    stats::FrameStats frameStats;
+    frameStats.step().record(uint64_t{1'000'000});
+    frameStats.phase("solve").record(uint64_t{500'000});
+
+    auto json = frameStats.json();
+    ASSERT_NE(json.find(R"("step":{"count":1)"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"("solve":{"count":1)"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"("p99_ms")"), std::string::npos) << json;
+}
@@ -0,0 +1,58 @@
+#include "huge_pages.h"
+#include "particle.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class HugePagesFixture : public ::testing::Test {
+protected:
+    void TearDown() override {
+        hugepages::disable();
+    }
+};
+
+TEST_F(HugePagesFixture, largeAllocationsAreHugePageAlignedWhenEnabled) {
+    hugepages::enable();
+    const auto before = hugepages::stats();
+    const auto bytes = 3 * hugepages::PageSize + 100;
+
+    auto ptr = hugepages::allocate(bytes);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0xAB, bytes);
+
+#if defined(__linux__)
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % hugepages::PageSize, 0);
+    const auto during = hugepages::stats();
+    ASSERT_EQ(during.explicitBytes + during.transparentBytes, before.explicitBytes + before.transparentBytes + 4 * hugepages::PageSize);
+#endif
+
+    hugepages::deallocate(ptr, bytes);
+    const auto after = hugepages::stats();
+    ASSERT_EQ(after.explicitBytes + after.transparentBytes, before.explicitBytes + before.transparentBytes);
+}
+
+TEST_F(HugePagesFixture, smallOrDisabledAllocationsUseRegularPages) {
+    const auto before = hugepages::stats();
+
+    auto large = hugepages::allocate(hugepages::PageSize);
+    hugepages::enable();
+    auto small = hugepages::allocate(1024);
+
+    const auto during = hugepages::stats();
+    ASSERT_EQ(during.explicitBytes + during.transparentBytes, before.explicitBytes + before.transparentBytes);
+
+    // the backing is decided at allocation, toggling in between is fine
+    hugepages::deallocate(large, hugepages::PageSize);
+    hugepages::deallocate(small, 1024);
+}
+
+TEST_F(HugePagesFixture, separateFieldLayoutColumnsLiveInHugePagesWhenEnabled) {
+    hugepages::enable();
+    auto particles = createSeparateFieldParticle2D(1 << 17);
+    const auto stats = hugepages::stats();
+    ASSERT_GE(stats.explicitBytes + stats.transparentBytes, SeparateFieldMemoryLayout2D::allocationSize(1 << 17));
+
+    ASSERT_TRUE(particles.add({1, 2}, {3, 4}, 1, 0.5, 1));
+    ASSERT_EQ(particles.position()[0], glm::vec2(1, 2));
+}
@@ -0,0 +1,146 @@
+#include "particle_type_fixture.h"
+#include "particle_emitter.h"
+#include "checkpoint.h"
+#include <filesystem>
+#include <vector>
+
+using Paged = PagedMemoryLayout2D;
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutGrowsWithoutMovingParticles) {
+    auto particles = createPagedParticle2D();
+    ASSERT_EQ(particles.capacity(), 0);
+
+    ASSERT_TRUE(particles.add({1, 2}, {3, 4}, 0.5, 0.25, 0.75));
+    ASSERT_EQ(particles.capacity(), Paged::ChunkSize);
+    auto position = particles.position();
+    auto* first = &position[0];
+
+    for(auto i = 1u; i < 3 * Paged::ChunkSize + 5; i++){
+        ASSERT_TRUE(particles.add({i, 0}, {0, 0}, 1, 1, 1));
+    }
+
+    ASSERT_EQ(particles.capacity(), 4 * Paged::ChunkSize);
+    ASSERT_EQ(&particles.position()[0], first);
+    ASSERT_EQ(position[0], glm::vec2(1, 2));
+    ASSERT_EQ(position[Paged::ChunkSize + 7].x, to<float>(Paged::ChunkSize + 7));
+    ASSERT_EQ(particles.velocity()[0], glm::vec2(3, 4));
+    ASSERT_EQ(particles.inverseMass()[0], 0.5f);
+    ASSERT_EQ(particles.radius()[0], 0.25f);
+    ASSERT_EQ(particles.restitution()[0], 0.75f);
+}
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutChunksAreAlignedAndCoverEveryParticle) {
+    auto particles = createPagedParticle2D();
+    std::vector<glm::vec2> positions(2 * Paged::ChunkSize + 100);
+    for(auto i = 0u; i < positions.size(); i++){
+        positions[i] = { i, -to<float>(i) };
+    }
+    ASSERT_EQ(particles.add(positions, {0, 1}, 1, 0.5, 1), positions.size());
+
+    size_t visited = 0;
+    particles.layout.forEachChunk(particles.size(), [&](size_t first, const Paged::Columns& columns){
+        ASSERT_EQ(first, visited);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(columns.position.data()) % Paged::Alignment, 0);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(columns.radius.data()) % Paged::Alignment, 0);
+        for(auto i = 0u; i < columns.position.size(); i++){
+            ASSERT_EQ(columns.position[i], positions[first + i]);
+            ASSERT_EQ(columns.velocity[i], glm::vec2(0, 1));
+        }
+        visited += columns.position.size();
+    });
+    ASSERT_EQ(visited, positions.size());
+}
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutReserveAndAppendStraddleChunks) {
+    auto particles = createPagedParticle2DPtr(10);
+    ParticlePointConsumer<PagedMemoryLayout> consumer;
+    consumer.set(particles);
+
+    consumer.reserve(Paged::ChunkSize + 10);
+    ASSERT_EQ(particles->capacity(), 2 * Paged::ChunkSize);
+    ASSERT_EQ(particles->size(), 0);
+
+    const auto [first, count] = consumer.claim(Paged::ChunkSize + 10);
+    ASSERT_EQ(first, 0);
+    ASSERT_EQ(count, Paged::ChunkSize + 10);
+    ASSERT_EQ(particles->capacity(), 2 * Paged::ChunkSize);
+
+    auto block = particles->append(Paged::ChunkSize);
+    ASSERT_EQ(block.size(), 2);
+    ASSERT_EQ(block[0].position.size(), Paged::ChunkSize - 10);
+    ASSERT_EQ(block[1].position.size(), 10);
+    ASSERT_EQ(block[1].position.data(), &particles->position()[2 * Paged::ChunkSize]);
+}
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutSortReordersEveryFieldAcrossChunks) {
+    auto particles = createPagedParticle2D();
+    const auto n = Paged::ChunkSize + 300;
+    for(auto i = 0u; i < n; i++){
+        const auto key = to<float>((i * 7919u) % n);
+        ASSERT_TRUE(particles.add({key, 0}, {0, key}, key, key + 1, key + 2));
+    }
+
+    auto position = particles.position();
+    particles.sort([&](int a, int b){ return position[a].x < position[b].x; });
+
+    for(auto i = 0; i < to<int>(n); i++){
+        const auto key = to<float>(i);
+        ASSERT_EQ(particles.position()[i], glm::vec2(key, 0)) << i;
+        ASSERT_EQ(particles.velocity()[i], glm::vec2(0, key)) << i;
+        ASSERT_EQ(particles.inverseMass()[i], key) << i;
+        ASSERT_EQ(particles.radius()[i], key + 1) << i;
+        ASSERT_EQ(particles.restitution()[i], key + 2) << i;
+    }
+}
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutSortRefusesDeadParticlesUntilCompacted) {
+    auto particles = createPagedParticle2D();
+    const auto n = 10u;
+    for(auto i = 0u; i < n; i++){
+        const auto key = to<float>(n - 1 - i);
+        ASSERT_TRUE(particles.add({key, 0}, {0, key}, 1, 0.5, 1));
+    }
+    particles.kill(0);
+    particles.kill(3);
+
+    auto position = particles.position();
+    auto byX = [&](int a, int b){ return position[a].x < position[b].x; };
+    ASSERT_THROW(particles.sort(byX), std::runtime_error);
+    ASSERT_EQ(position[0].x, 9);
+
+    particles.compact();
+    particles.sort(byX);
+
+    ASSERT_EQ(particles.size(), n - 2);
+    std::vector<float> expected{ 0, 1, 2, 3, 4, 5, 7, 8 };
+    for(auto i = 0; i < to<int>(particles.size()); i++){
+        ASSERT_TRUE(particles.alive(i));
+        ASSERT_EQ(particles.position()[i].x, expected[i]) << i;
+        ASSERT_EQ(particles.velocity()[i].y, expected[i]) << i;
+    }
+}
+
+TEST_F(ParticleTypeFixture, PagedMemoryLayoutCheckpointRoundTrip) {
+    auto particles = createPagedParticle2D();
+    for(auto i = 0u; i < Paged::ChunkSize + 3; i++){
+        particles.add({i, 1}, {2, i}, 1, 0.5, 0.25);
+    }
+    const auto path = (std::filesystem::temp_directory_path() / "paged_particles.ckpt").string();
+    {
+        checkpoint::Writer writer{ path };
+        checkpoint::write(writer, particles);
+        writer.close();
+    }
+
+    auto restored = createPagedParticle2D();
+    checkpoint::Reader reader{ path };
+    checkpoint::read(reader, restored);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(restored.size(), particles.size());
+    for(auto i = 0; i < to<int>(particles.size()); i++){
+        ASSERT_EQ(restored.position()[i], particles.position()[i]);
+        ASSERT_EQ(restored.velocity()[i], particles.velocity()[i]);
+        ASSERT_EQ(restored.restitution()[i], particles.restitution()[i]);
+    }
+}
@@ -1,4 +1,6 @@
 #include "particle_type_fixture.h"
+#include "particle_lifetime.h"
+#include <random>
 
 TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutPositionView) {
     std::vector<glm::vec2> positions{glm::vec2{0}, glm::vec2{1}, glm::vec3{3}};
@@ -112,4 +114,147 @@ TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutWithInternalMemoryAllocatio
     ASSERT_FLOAT_EQ(radius[0], 0);
     radius[0] = 1.0;
     ASSERT_FLOAT_EQ(radius[0], 1.0);
-}
\ No newline at end of file
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutAppendReturnsColumnsOfTheReservedRange) {
+    auto particles = createSeparateFieldParticle2D(8);
+    particles.add(glm::vec2{1}, glm::vec2{0}, 1, 1, 1);
+
+    auto block = particles.append(3);
+    ASSERT_EQ(particles.size(), 4);
+    ASSERT_EQ(particles.available(), 4);
+    ASSERT_EQ(block.position.size(), 3);
+    ASSERT_EQ(block.radius.size(), 3);
+
+    for(auto i = 0; i < 3; i++){
+        block.position[i] = glm::vec2(i + 2);
+        block.radius[i] = 0.5f * to<float>(i);
+    }
+
+    auto position = particles.position();
+    auto radius = particles.radius();
+    ASSERT_FLOAT_EQ(position[0].x, 1);
+    ASSERT_FLOAT_EQ(position[3].x, 4);
+    ASSERT_FLOAT_EQ(radius[2], 0.5);
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutAppendBeyondCapacityThrows) {
+    auto particles = createSeparateFieldParticle2D(4);
+    [[maybe_unused]] auto block = particles.append(3);
+
+    ASSERT_THROW([[maybe_unused]] auto overflow = particles.append(2), std::runtime_error);
+    ASSERT_EQ(particles.size(), 3);
+    ASSERT_TRUE(particles.add(glm::vec2{0}, glm::vec2{0}, 1, 1, 1));
+    ASSERT_FALSE(particles.add(glm::vec2{0}, glm::vec2{0}, 1, 1, 1));
+    ASSERT_EQ(particles.size(), 4);
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutBulkAddStopsAtCapacity) {
+    auto particles = createSeparateFieldParticle2D(4);
+    std::vector<glm::vec2> positions{ glm::vec2{0}, glm::vec2{1}, glm::vec2{2}, glm::vec2{3}, glm::vec2{4}, glm::vec2{5} };
+
+    ASSERT_EQ(particles.add(positions, glm::vec2{0, -1}, 2, 0.25, 0.5), 4);
+    ASSERT_EQ(particles.size(), 4);
+    ASSERT_EQ(particles.add(positions, glm::vec2{0}, 2, 0.25, 0.5), 0);
+
+    auto position = particles.position();
+    auto velocity = particles.velocity();
+    ASSERT_FLOAT_EQ(position[3].x, 3);
+    ASSERT_FLOAT_EQ(velocity[3].y, -1);
+    ASSERT_FLOAT_EQ(particles.inverseMass()[2], 2);
+    ASSERT_FLOAT_EQ(particles.radius()[2], 0.25);
+    ASSERT_FLOAT_EQ(particles.restitution()[2], 0.5);
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutCompactMovesTailParticlesIntoDeadSlots) {
+    auto particles = createSeparateFieldParticle2D(16);
+    for(auto i = 0; i < 10; i++){
+        particles.add({i, 0}, {0, i}, 1, 0.5, 1);
+    }
+    particles.kill(1);
+    particles.kill(4);
+    particles.kill(8);
+    ASSERT_FALSE(particles.alive(4));
+    ASSERT_TRUE(particles.alive(5));
+
+    auto remap = particles.compact();
+
+    ASSERT_EQ(particles.size(), 7);
+    ASSERT_EQ(remap.size(), 10);
+    ASSERT_EQ(remap[1], SeparateFieldParticle2D::Removed);
+    ASSERT_EQ(remap[4], SeparateFieldParticle2D::Removed);
+    ASSERT_EQ(remap[8], SeparateFieldParticle2D::Removed);
+    for(auto i = 0u; i < remap.size(); i++){
+        if(remap[i] == SeparateFieldParticle2D::Removed) continue;
+        ASSERT_LT(remap[i], particles.size());
+        ASSERT_EQ(particles.position()[remap[i]].x, to<float>(i));
+        ASSERT_EQ(particles.velocity()[remap[i]].y, to<float>(i));
+        ASSERT_TRUE(particles.alive(remap[i]));
+    }
+    ASSERT_EQ(remap[0], 0);
+    ASSERT_EQ(remap[7], 1);
+    ASSERT_EQ(remap[9], 4);
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutParallelCompactMatchesSerialReference) {
+    parallel::ScopedConcurrency concurrency{ 4 };
+    const auto n = 5 * parallel::MinWorkPerThread + 123;
+    ASSERT_EQ(parallel::workers(n), 4);
+
+    auto particles = createSeparateFieldParticle2D(n);
+    std::vector<uint8_t> dead(n);
+    std::mt19937 rng{ 7 };
+    std::bernoulli_distribution kill{ 0.3 };
+    for(auto i = 0u; i < n; i++){
+        particles.add({i, 0}, {0, i}, 1, 0.5, 1);
+        dead[i] = kill(rng);
+        if(dead[i]) particles.kill(i);
+    }
+
+    // the k-th dead slot below the new size takes the k-th live particle above it
+    const auto newSize = n - std::count(dead.begin(), dead.end(), 1);
+    std::vector<uint32_t> holes, movers;
+    SeparateFieldParticle2D::Remap expected(n);
+    for(auto i = 0u; i < n; i++){
+        expected[i] = dead[i] ? SeparateFieldParticle2D::Removed : i;
+        if(dead[i] && i < newSize) holes.push_back(i);
+        if(!dead[i] && i >= newSize) movers.push_back(i);
+    }
+    ASSERT_EQ(holes.size(), movers.size());
+    for(auto k = 0u; k < holes.size(); k++){
+        expected[movers[k]] = holes[k];
+    }
+
+    auto remap = particles.compact();
+
+    ASSERT_EQ(particles.size(), newSize);
+    ASSERT_EQ(remap, expected);
+    for(auto i = 0u; i < n; i++){
+        if(remap[i] == SeparateFieldParticle2D::Removed) continue;
+        ASSERT_EQ(particles.position()[remap[i]].x, to<float>(i)) << i;
+        ASSERT_EQ(particles.velocity()[remap[i]].y, to<float>(i)) << i;
+        ASSERT_TRUE(particles.alive(remap[i]));
+    }
+}
+
+TEST_F(ParticleTypeFixture, SeparateFieldMemoryLayoutParticlesExpireAfterTheirLifetime) {
+    auto particles = createSeparateFieldParticle2D(16);
+    ParticleLifetime lifetime{ 1.0f };
+    for(auto i = 0; i < 4; i++){
+        particles.add({i, 0}, {0, 0}, 1, 0.5, 1);
+    }
+    ASSERT_EQ(lifetime.update(particles, 0.5f), 0);
+
+    for(auto i = 4; i < 8; i++){
+        particles.add({i, 0}, {0, 0}, 1, 0.5, 1);
+    }
+    ASSERT_EQ(lifetime.update(particles, 0.5f), 4);
+    lifetime.remap(particles.compact());
+
+    ASSERT_EQ(particles.size(), 4);
+    ASSERT_EQ(lifetime.remaining().size(), 4);
+    for(auto i = 0u; i < particles.size(); i++){
+        ASSERT_GE(particles.position()[i].x, 4);
+        ASSERT_FLOAT_EQ(lifetime.remaining()[i], 0.5f);
+    }
+}
@@ -120,4 +120,53 @@ TEST_F(ParticleTypeFixture, InterleavedMemoryLayoutRadiusView) {
 //        ASSERT_FLOAT_EQ(source[i].position.y, position.y);
 //        i++;
 //    }
-//}
\ No newline at end of file
+//}
+
+TEST_F(ParticleTypeFixture, InterleavedMemoryLayoutAppendReturnsRowsOfTheReservedRange) {
+    std::vector<InterleavedMemoryLayout<glm::vec2>::Members> source(4);
+    auto particles = createInterleavedMemoryParticle2D(source);
+
+    auto block = particles.append(2);
+    ASSERT_EQ(block.size(), 2);
+    block[1].position = glm::vec2{3, 4};
+    ASSERT_FLOAT_EQ(particles.position()[1].y, 4);
+
+    ASSERT_THROW([[maybe_unused]] auto overflow = particles.append(3), std::runtime_error);
+    ASSERT_EQ(particles.size(), 2);
+}
+
+TEST_F(ParticleTypeFixture, InterleavedMemoryLayoutBulkAddStopsAtCapacity) {
+    std::vector<InterleavedMemoryLayout<glm::vec2>::Members> source(3);
+    auto particles = createInterleavedMemoryParticle2D(source);
+    std::vector<glm::vec2> positions{ glm::vec2{0}, glm::vec2{1}, glm::vec2{2}, glm::vec2{3} };
+
+    ASSERT_EQ(particles.add(positions, glm::vec2{1, 0}, 2, 0.25, 0.5), 3);
+    ASSERT_EQ(particles.available(), 0);
+    ASSERT_FLOAT_EQ(particles.position()[2].x, 2);
+    ASSERT_FLOAT_EQ(particles.velocity()[2].x, 1);
+    ASSERT_FLOAT_EQ(particles.radius()[2], 0.25);
+    ASSERT_FLOAT_EQ(particles.restitution()[2], 0.5);
+}
+
+TEST_F(ParticleTypeFixture, InterleavedMemoryLayoutCompactKeepsDependentArraysAligned) {
+    std::vector<InterleavedMemoryLayout2D::Members> memory(1000);
+    auto particles = createInterleavedMemoryParticle2D(memory);
+    std::vector<float> tag(memory.size());
+    for(auto i = 0; i < 1000; i++){
+        particles.add({i, 0}, {0, 0}, 1, 0.5, 1);
+        tag[i] = to<float>(i);
+    }
+
+    ASSERT_EQ(particles.killIf([&](size_t i){ return particles.position()[i].x < 300 || i % 7 == 0; }), 300 + 100);
+
+    auto remap = particles.compact();
+    applyRemap(std::span<float>{ tag }, remap);
+
+    ASSERT_EQ(particles.size(), 600);
+    for(auto i = 0u; i < particles.size(); i++){
+        ASSERT_GE(particles.position()[i].x, 300);
+        ASSERT_NE(to<int>(particles.position()[i].x) % 7, 0);
+        ASSERT_EQ(tag[i], particles.position()[i].x);
+    }
+    ASSERT_EQ(particles.compact().size(), 600);
+}
@@ -0,0 +1,83 @@
+#include "philox.h"
+#include "emitter/point_emitter.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+struct RecordingConsumer {
+    operator bool() const {
+        return true;
+    }
+
+    void use(const glm::vec2&, const glm::vec2& velocity) {
+        velocities->push_back(velocity);
+    }
+
+    float offset(float) const {
+        return 0.1f;
+    }
+
+    std::vector<glm::vec2>* velocities{};
+};
+
+class PointEmitterFixture : public ::testing::Test {
+protected:
+    PointEmitter<2, RecordingConsumer> emitter(uint32_t seed, std::vector<glm::vec2>& velocities) {
+        PointEmitter<2, RecordingConsumer> emitter{ {0, 0}, {0, 1}, 2.f, 90.f, 1000, 10000, seed };
+        emitter.set(RecordingConsumer{ &velocities });
+        return emitter;
+    }
+};
+
+TEST(PhiloxTest, matchesReferenceVectors) {
+    ASSERT_EQ(philox::philox2x32(0, 0), (philox::Result{ 0xff1dae59u, 0x6cd10df2u }));
+    ASSERT_EQ(philox::philox2x32(~0ull, ~0u), (philox::Result{ 0x2c3f628bu, 0xab4fd7adu }));
+    ASSERT_EQ(philox::philox2x32(0x85a308d3243f6a88ull, 0x13198a2eu), (philox::Result{ 0xdd7ce038u, 0xf62a4c12u }));
+}
+
+TEST(PhiloxTest, uniformIsInUnitInterval) {
+    philox::Stream stream{ 7 };
+    double sum = 0;
+    constexpr auto N = 100000;
+    for(auto i = 0; i < N; i++){
+        const auto u = stream.uniform(i);
+        ASSERT_GE(u, 0.f);
+        ASSERT_LT(u, 1.f);
+        sum += u;
+    }
+    ASSERT_NEAR(sum / N, 0.5, 0.01);
+    ASSERT_EQ(philox::uniform(~0u), 1.f - 1.f / 16777216.f);
+}
+
+TEST_F(PointEmitterFixture, emissionDoesNotDependOnHowItIsSplit) {
+    std::vector<glm::vec2> once, split;
+
+    auto a = emitter(42, once);
+    a.emit(300, 0.f);
+
+    auto b = emitter(42, split);
+    for(auto batch : { 1, 17, 82, 200 }){
+        b.emit(batch, 0.f);
+    }
+
+    ASSERT_EQ(once.size(), 300);
+    ASSERT_EQ(split.size(), 300);
+    for(auto i = 0u; i < once.size(); i++){
+        ASSERT_EQ(once[i], split[i]) << "particle " << i;
+    }
+}
+
+TEST_F(PointEmitterFixture, directionsStayWithinSpreadAndDependOnSeed) {
+    std::vector<glm::vec2> first, second;
+    auto a = emitter(1, first);
+    auto b = emitter(2, second);
+    a.emit(100, 0.f);
+    b.emit(100, 0.f);
+
+    auto differ = 0;
+    for(auto i = 0u; i < first.size(); i++){
+        ASSERT_NEAR(glm::length(first[i]), 2.f, 1e-5f);
+        ASSERT_GE(first[i].y / 2.f, glm::cos(glm::radians(45.f)) - 1e-5f);
+        differ += first[i] != second[i];
+    }
+    ASSERT_GT(differ, 90);
+}
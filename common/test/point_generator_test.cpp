@@ -0,0 +1,228 @@
+#include "point_generators.h"
+#include "volume_emitter_2d.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// brute force nearest neighbour over a coarse cell map, good enough to check generator output
+struct SpacialHashGridHelper {
+    SpacialHashGridHelper(const std::vector<glm::vec2>& points, float spacing)
+    : points(points)
+    , cellSize(spacing * 2)
+    {
+        for(auto i = 0u; i < points.size(); i++){
+            cells[key(cellOf(points[i]))].push_back(i);
+        }
+    }
+
+    [[nodiscard]]
+    glm::ivec2 cellOf(const glm::vec2& p) const {
+        return { to<int>(std::floor(p.x / cellSize)), to<int>(std::floor(p.y / cellSize)) };
+    }
+
+    static int64_t key(glm::ivec2 cell) {
+        return (int64_t(cell.x) << 32) ^ uint32_t(cell.y);
+    }
+
+    // distance to the nearest point within two cells, skipping the point itself when it is one
+    [[nodiscard]]
+    float nearest(const glm::vec2& p, bool skipSelf) const {
+        auto best = std::numeric_limits<float>::max();
+        const auto cell = cellOf(p);
+        for(auto dy = -2; dy <= 2; dy++){
+            for(auto dx = -2; dx <= 2; dx++){
+                auto itr = cells.find(key(cell + glm::ivec2{dx, dy}));
+                if(itr == cells.end()) continue;
+                for(auto i : itr->second){
+                    const auto d = glm::length(points[i] - p);
+                    if(skipSelf && d == 0) continue;
+                    best = std::min(best, d);
+                }
+            }
+        }
+        return best;
+    }
+
+    const std::vector<glm::vec2>& points;
+    float cellSize;
+    std::unordered_map<int64_t, std::vector<size_t>> cells;
+};
+
+class PointGeneratorFixture : public ::testing::Test {
+protected:
+    static std::vector<glm::vec2> visit(const PointGenerator2D& generator, const Bounds2D& bounds, float spacing) {
+        std::vector<glm::vec2> points;
+        generator.forEachPoint(bounds, spacing, [&points](const glm::vec2& point){
+            points.push_back(point);
+            return true;
+        });
+        return points;
+    }
+
+    static void assertSamePoints(const std::vector<glm::vec2>& expected, const std::vector<glm::vec2>& actual) {
+        ASSERT_EQ(expected.size(), actual.size());
+        for(auto i = 0u; i < expected.size(); i++){
+            ASSERT_EQ(expected[i].x, actual[i].x) << "point " << i;
+            ASSERT_EQ(expected[i].y, actual[i].y) << "point " << i;
+        }
+    }
+
+    Bounds2D bounds{ glm::vec2{-1.5f, 0.25f}, glm::vec2{30.f, 20.f} };
+};
+
+TEST_F(PointGeneratorFixture, gridRowsMatchForEachPoint) {
+    GridPointGenerator2D generator{};
+    auto expected = visit(generator, bounds, 0.1f);
+
+    ASSERT_EQ(generator.count(bounds, 0.1f), expected.size());
+    assertSamePoints(expected, generator.generate(bounds, 0.1f));
+}
+
+TEST_F(PointGeneratorFixture, triangleRowsMatchForEachPoint) {
+    TrianglePointGenerator generator{};
+    auto expected = visit(generator, bounds, 0.1f);
+
+    ASSERT_EQ(generator.count(bounds, 0.1f), expected.size());
+    assertSamePoints(expected, generator.generate(bounds, 0.1f));
+}
+
+TEST_F(PointGeneratorFixture, generateRejectsBufferOfWrongSize) {
+    GridPointGenerator2D generator{};
+    std::vector<glm::vec2> points(generator.count(bounds, 1.f) + 1);
+
+    ASSERT_THROW(generator.generate(bounds, 1.f, points), std::runtime_error);
+}
+
+TEST_F(PointGeneratorFixture, volumeEmitterInsertsPointsInsideSdfInGeneratorOrder) {
+    const auto spacing = 0.05f;
+    std::function<float(const glm::vec2&)> sdf = [](const glm::vec2& point){ return glm::length(point - glm::vec2{10}) - 6.f; };
+
+    std::vector<glm::vec2> expected;
+    for(const auto& point : TrianglePointGenerator{}.generate(bounds, spacing)){
+        if(sdf(point) < 0) expected.push_back(point);
+    }
+
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(expected.size() + 10));
+    VolumeEmitter2D<SeparateFieldMemoryLayout> emitter{ sdf, std::make_unique<TrianglePointGenerator>(), bounds, spacing };
+    emitter.set(particles);
+    emitter.update(0.01f);
+
+    ASSERT_EQ(particles->size(), expected.size());
+    auto position = particles->position();
+    auto radius = particles->radius();
+    for(auto i = 0u; i < expected.size(); i++){
+        ASSERT_EQ(position[i].x, expected[i].x);
+        ASSERT_EQ(position[i].y, expected[i].y);
+        ASSERT_FLOAT_EQ(radius[i], spacing * 0.5f);
+    }
+}
+
+TEST_F(PointGeneratorFixture, volumeEmitterStopsAtCapacity) {
+    std::function<float(const glm::vec2&)> sdf = [](const glm::vec2&){ return -1.f; };
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(1000));
+    VolumeEmitter2D<SeparateFieldMemoryLayout> emitter{ sdf, std::make_unique<GridPointGenerator2D>(), bounds, 0.05f };
+    emitter.set(particles);
+    emitter.update(0.01f);
+
+    const auto expected = GridPointGenerator2D{}.generate(bounds, 0.05f);
+    ASSERT_EQ(particles->size(), 1000);
+    ASSERT_EQ(particles->position()[999].x, expected[999].x);
+    ASSERT_EQ(particles->position()[999].y, expected[999].y);
+}
+
+TEST_F(PointGeneratorFixture, volumeEmitterRethrowsSdfErrorsWithoutEmitting) {
+    parallel::ScopedConcurrency concurrency{ 4 };
+    std::function<float(const glm::vec2&)> sdf = [](const glm::vec2& point){
+        if(point.x > 20.f) {
+            throw std::runtime_error{ "sdf failed" };
+        }
+        return -1.f;
+    };
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(1000));
+    VolumeEmitter2D<SeparateFieldMemoryLayout> emitter{ sdf, std::make_unique<GridPointGenerator2D>(), bounds, 0.05f };
+    emitter.set(particles);
+
+    ASSERT_GT(parallel::workers(GridPointGenerator2D{}.count(bounds, 0.05f)), 1);
+    ASSERT_THROW(emitter.update(0.01f), std::runtime_error);
+    ASSERT_EQ(particles->size(), 0);
+}
+
+TEST_F(PointGeneratorFixture, poissonDiskPointsKeepMinimumDistanceAndCoverTheDomain) {
+    const Bounds2D domain{ glm::vec2{0}, glm::vec2{12, 9} };
+    const auto spacing = 0.1f;
+    const auto points = PoissonDiskPointGenerator2D{ 7 }.generate(domain, spacing);
+    ASSERT_GT(points.size(), 0);
+
+    SpacialHashGridHelper grid{ points, spacing };
+    for(const auto& point : points){
+        ASSERT_GE(point.x, domain.lower.x);
+        ASSERT_GE(point.y, domain.lower.y);
+        ASSERT_LE(point.x, domain.upper.x);
+        ASSERT_LE(point.y, domain.upper.y);
+        ASSERT_GE(grid.nearest(point, true), spacing * 0.9999f);
+    }
+
+    // maximal: no gap where another point would fit
+    std::default_random_engine engine{ 3 };
+    std::uniform_real_distribution<float> x{ domain.lower.x, domain.upper.x };
+    std::uniform_real_distribution<float> y{ domain.lower.y, domain.upper.y };
+    for(auto i = 0; i < 2000; i++){
+        ASSERT_LT(grid.nearest({ x(engine), y(engine) }, false), 2 * spacing);
+    }
+}
+
+TEST_F(PointGeneratorFixture, poissonDiskIsDeterministicPerSeed) {
+    const auto a = PoissonDiskPointGenerator2D{ 42 }.generate(bounds, 0.25f);
+    const auto b = PoissonDiskPointGenerator2D{ 42 }.generate(bounds, 0.25f);
+    const auto c = PoissonDiskPointGenerator2D{ 43 }.generate(bounds, 0.25f);
+
+    assertSamePoints(a, b);
+    ASSERT_NE(a.front().x, c.front().x);
+}
+
+TEST_F(PointGeneratorFixture, poissonDiskGeneratesConcurrentlyWithDifferentBounds) {
+    const PoissonDiskPointGenerator2D generator{ 5 };
+    const Bounds2D other{ glm::vec2{0}, glm::vec2{7, 3} };
+    const auto expected = generator.generate(bounds, 0.1f);
+    const auto expectedOther = generator.generate(other, 0.1f);
+
+    std::vector<glm::vec2> points, otherPoints;
+    std::thread thread{ [&]{ otherPoints = generator.generate(other, 0.1f); } };
+    points = generator.generate(bounds, 0.1f);
+    thread.join();
+
+    assertSamePoints(expected, points);
+    assertSamePoints(expectedOther, otherPoints);
+}
+
+TEST_F(PointGeneratorFixture, poissonDiskUntiledMatchesSpacing) {
+    PoissonDiskPointGenerator2D generator{ 1, 30, false };
+    std::vector<glm::vec2> visited = visit(generator, bounds, 0.5f);
+    assertSamePoints(visited, generator.generate(bounds, 0.5f));
+
+    SpacialHashGridHelper grid{ visited, 0.5f };
+    for(const auto& point : visited){
+        ASSERT_GE(grid.nearest(point, true), 0.5f * 0.9999f);
+    }
+}
+
+TEST_F(PointGeneratorFixture, poissonDiskAllocatesOnceForTheSampledPoints) {
+    const PoissonDiskPointGenerator2D generator{ 9 };
+    const auto expected = visit(generator, bounds, 0.1f);
+
+    std::vector<glm::vec2> points;
+    auto allocations = 0;
+    generator.generate(bounds, 0.1f, [&](size_t count){
+        allocations++;
+        points.resize(count);
+        return std::span{ points };
+    });
+
+    ASSERT_EQ(allocations, 1);
+    assertSamePoints(expected, points);
+}
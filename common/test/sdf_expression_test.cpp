@@ -0,0 +1,119 @@
+#include "sdf_expression.h"
+#include "volume_emitter_2d.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+class SdfExpressionFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::default_random_engine engine{ 1 << 10 };
+        std::uniform_real_distribution<float> dist{ -20.f, 20.f };
+        points.resize(1003);
+        for(auto& point : points){
+            point = { dist(engine), dist(engine) };
+        }
+    }
+
+    template<typename Shape, typename Expected>
+    void assertDistances(const Shape& shape, Expected&& expected) {
+        std::vector<float> distance(points.size());
+        csg::evaluate(shape, points, distance);
+        for(auto i = 0u; i < points.size(); i++){
+            ASSERT_NEAR(shape(points[i]), expected(points[i]), 1e-5f) << "point " << i;
+            ASSERT_NEAR(distance[i], expected(points[i]), 1e-5f) << "batch point " << i;
+        }
+    }
+
+    std::vector<glm::vec2> points;
+};
+
+TEST_F(SdfExpressionFixture, primitivesMatchSdf2d) {
+    assertDistances(csg::Circle{ {3, -2}, 4.f }, [](glm::vec2 p){ return sdfCircle(p, 4.f, {3, -2}); });
+    assertDistances(csg::Plane{ 2.5f }, [](glm::vec2 p){ return sdfPlane(p, 2.5f); });
+    assertDistances(csg::Box{ {1, 2}, {3, 5} }, [](glm::vec2 p){
+        glm::vec2 local = p - glm::vec2{1, 2};
+        return sdBox({3, 5}, local);
+    });
+}
+
+TEST_F(SdfExpressionFixture, booleanOperations) {
+    const csg::Circle a{ {0, 0}, 5.f };
+    const csg::Box b{ {4, 0}, {3, 2} };
+    auto da = [&](glm::vec2 p){ return a(p); };
+    auto db = [&](glm::vec2 p){ return b(p); };
+
+    assertDistances(a | b, [&](glm::vec2 p){ return glm::min(da(p), db(p)); });
+    assertDistances(a & b, [&](glm::vec2 p){ return glm::max(da(p), db(p)); });
+    assertDistances(a - b, [&](glm::vec2 p){ return glm::max(da(p), -db(p)); });
+}
+
+TEST_F(SdfExpressionFixture, smoothUnionBlendsOnlyNearBothSurfaces) {
+    const auto k = 1.f;
+    auto shape = csg::smoothUnion(csg::Circle{ {-3, 0}, 2.f }, csg::Circle{ {3, 0}, 2.f }, k);
+    auto hard = csg::Circle{ {-3, 0}, 2.f } | csg::Circle{ {3, 0}, 2.f };
+
+    for(const auto& point : points){
+        ASSERT_LE(shape(point), hard(point) + 1e-6f);
+        ASSERT_GE(shape(point), hard(point) - 0.25f * k - 1e-6f);
+    }
+    ASSERT_FLOAT_EQ(shape({-10, 0}), hard({-10, 0}));
+}
+
+TEST_F(SdfExpressionFixture, transforms) {
+    const csg::Box box{ {0, 0}, {4, 1} };
+    const auto angle = glm::radians(90.f);
+
+    assertDistances(csg::translate(box, {2, 3}), [&](glm::vec2 p){ return box(p - glm::vec2{2, 3}); });
+    assertDistances(csg::rotate(box, angle), [](glm::vec2 p){ return csg::Box{ {0, 0}, {1, 4} }(p); });
+    assertDistances(csg::scale(box, 2.f), [](glm::vec2 p){ return csg::Box{ {0, 0}, {8, 2} }(p); });
+}
+
+TEST_F(SdfExpressionFixture, typeErasedSdfComposesWithStaticShapes) {
+    auto expression = csg::translate(csg::Circle{ {0, 0}, 3.f } - csg::Plane{ 0.f }, {1, 1});
+    csg::Sdf erased{ expression };
+    csg::Sdf copy = erased;
+
+    assertDistances(copy, [&](glm::vec2 p){ return expression(p); });
+    assertDistances(copy | csg::Plane{ -10.f }, [&](glm::vec2 p){ return glm::min(expression(p), p.y + 10.f); });
+}
+
+TEST_F(SdfExpressionFixture, defaultSdfIsEmpty) {
+    const csg::Sdf sdf{};
+    ASSERT_FALSE(sdf);
+    ASSERT_EQ(sdf(glm::vec2(3, 4)), std::numeric_limits<float>::infinity());
+
+    std::vector<float> distance(points.size());
+    csg::evaluate(sdf, points, distance);
+    ASSERT_TRUE(std::ranges::all_of(distance, [](float d){ return std::isinf(d) && d > 0; }));
+    ASSERT_TRUE(csg::Sdf{ csg::Plane{ 1 } });
+}
+
+TEST_F(SdfExpressionFixture, volumeEmitterAcceptsExpressions) {
+    Bounds2D bounds{ glm::vec2{0}, glm::vec2{20} };
+    const auto spacing = 0.2f;
+    auto shape = csg::Plane{ 3.f } | csg::Circle{ {10, 18}, 1.5f };
+    std::function<float(const glm::vec2&)> lambda = [](const glm::vec2& point){
+        return glm::min(point.y - 3.0f, glm::distance(point, glm::vec2(10, 18)) - 1.5f);
+    };
+
+    auto expected = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(10000));
+    VolumeEmitter2D<SeparateFieldMemoryLayout> reference{ lambda, std::make_unique<TrianglePointGenerator>(), bounds, spacing };
+    reference.set(expected);
+    reference.update(0.01f);
+
+    auto actual = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(10000));
+    VolumeEmitter2D<SeparateFieldMemoryLayout> emitter{ shape, std::make_unique<TrianglePointGenerator>(), bounds, spacing };
+    emitter.set(actual);
+    emitter.update(0.01f);
+
+    ASSERT_GT(actual->size(), 0);
+    ASSERT_EQ(actual->size(), expected->size());
+    for(auto i = 0u; i < actual->size(); i++){
+        ASSERT_EQ(actual->position()[i].x, expected->position()[i].x);
+        ASSERT_EQ(actual->position()[i].y, expected->position()[i].y);
+    }
+}
@@ -0,0 +1,120 @@
+#include "serializer.h"
+#include "json_serializer.h"
+#include "binary_serializer.h"
+#include "particle.h"
+#include "model2d.h"
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+#include <cstring>
+#include <random>
+
+struct Scene {
+    Bounds2D bounds;
+    SeparateFieldParticle2D* particles;
+    std::string name;
+
+    template<typename Visitor>
+    void snapshot(Visitor& visitor) const {
+        visitor.value("name", name);
+        visitor.object("bounds", bounds);
+        visitor.object("particles", *particles);
+    }
+};
+
+class SnapshotSerializerFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        particles = createSeparateFieldParticle2D(NumParticles);
+        interleaved.resize(NumParticles);
+        interleavedParticles = createInterleavedMemoryParticle2D(interleaved);
+
+        std::default_random_engine engine{ 1 << 20 };
+        std::uniform_real_distribution<float> dist{0, 20};
+        for(auto i = 0; i < NumParticles; i++){
+            glm::vec2 position{dist(engine), dist(engine)};
+            glm::vec2 velocity{dist(engine), dist(engine)};
+            particles.add(position, velocity, 1, 0.1f, 0.5f);
+            interleavedParticles.add(position, velocity, 1, 0.1f, 0.5f);
+        }
+    }
+
+    static constexpr int NumParticles = 100;
+    SeparateFieldParticle2D particles;
+    std::vector<InterleavedMemoryLayout2D::Members> interleaved;
+    InterleavedMemoryParticle2D interleavedParticles;
+    Bounds2D bounds{ glm::vec2(-1, 0), glm::vec2(20, 30) };
+};
+
+TEST_F(SnapshotSerializerFixture, yamlWritesEveryField) {
+    Scene scene{ bounds, &particles, "dam break" };
+    auto node = YAML::Load(yaml::serialize(scene));
+
+    ASSERT_EQ(node["name"].as<std::string>(), "dam break");
+    ASSERT_EQ(node["bounds"]["upper"][1].as<float>(), 30);
+    ASSERT_EQ(node["particles"]["size"].as<int>(), NumParticles);
+    ASSERT_EQ(node["particles"]["position"].size(), NumParticles);
+    for(auto i = 0; i < NumParticles; i++){
+        ASSERT_EQ(node["particles"]["position"][i][0].as<float>(), particles.position()[i].x);
+        ASSERT_EQ(node["particles"]["position"][i][1].as<float>(), particles.position()[i].y);
+        ASSERT_EQ(node["particles"]["velocity"][i][1].as<float>(), particles.velocity()[i].y);
+        ASSERT_EQ(node["particles"]["radius"][i].as<float>(), particles.radius()[i]);
+    }
+}
+
+TEST_F(SnapshotSerializerFixture, interleavedFieldsAreVisitedInPlace) {
+    auto expected = yaml::serialize(particles);
+    auto actual = yaml::serialize(interleavedParticles);
+    ASSERT_EQ(actual, expected);
+}
+
+TEST_F(SnapshotSerializerFixture, jsonWritesEveryField) {
+    Scene scene{ bounds, &particles, "dam break" };
+    auto json = json::serialize(scene);
+
+    ASSERT_TRUE(json.starts_with(R"({"name":"dam break","bounds":{"lower":[)"));
+    ASSERT_NE(json.find(R"("particles":{"size":100,"capacity":100,"position":[[)"), std::string::npos);
+    ASSERT_EQ(std::count(json.begin(), json.end(), '['), std::count(json.begin(), json.end(), ']'));
+    ASSERT_EQ(std::count(json.begin(), json.end(), '{'), std::count(json.begin(), json.end(), '}'));
+    // 2 bounds + 3 vector fields of NumParticles vec2 + 3 scalar fields
+    ASSERT_EQ(std::count(json.begin(), json.end(), '['), 2 + 3 * (NumParticles + 1) + 3);
+}
+
+TEST_F(SnapshotSerializerFixture, binaryStoresContiguousFieldsVerbatim) {
+    auto bytes = binary::serialize(particles);
+
+    const std::string name{"position"};
+    auto itr = std::search(bytes.begin(), bytes.end(), name.begin(), name.end());
+    ASSERT_NE(itr, bytes.end());
+
+    auto record = itr + name.size();
+    ASSERT_EQ(static_cast<binary::Type>(record[0]), binary::Type::Float);
+    ASSERT_EQ(record[1], 2);
+    uint64_t count{};
+    std::memcpy(&count, &record[2], sizeof(count));
+    ASSERT_EQ(count, NumParticles);
+    ASSERT_EQ(std::memcmp(&record[10], particles.layout.data.position.data(), NumParticles * sizeof(glm::vec2)), 0);
+    ASSERT_EQ(static_cast<binary::Kind>(bytes.back()), binary::Kind::EndObject);
+}
+
+TEST_F(SnapshotSerializerFixture, pagedFieldsAreVisitedInPlaceChunkByChunk) {
+    const auto n = PagedMemoryLayout2D::ChunkSize + 50;
+    auto paged = createPagedParticle2D();
+    auto separate = createSeparateFieldParticle2D(2 * PagedMemoryLayout2D::ChunkSize);
+    for(auto i = 0u; i < n; i++){
+        glm::vec2 position{ i, -to<float>(i) };
+        paged.add(position, glm::vec2{0, i}, 1, 0.1f, 0.5f);
+        separate.add(position, glm::vec2{0, i}, 1, 0.1f, 0.5f);
+    }
+
+    auto position = paged.layout.sequence<glm::vec2, Field::Position>(n);
+    ASSERT_TRUE(position.chunked());
+    ASSERT_EQ(&position[0], &paged.position()[0]);
+    ASSERT_EQ(&position[n - 1], &paged.position()[n - 1]);
+
+    std::vector<size_t> runs;
+    position.forEachSpan([&](std::span<const glm::vec2> run){ runs.push_back(run.size()); });
+    ASSERT_EQ(runs, (std::vector<size_t>{ PagedMemoryLayout2D::ChunkSize, 50 }));
+
+    ASSERT_EQ(binary::serialize(paged), binary::serialize(separate));
+    ASSERT_EQ(yaml::serialize(paged), yaml::serialize(separate));
+}
@@ -113,4 +113,68 @@ TEST_F(SphKernelFixture, laplacianWithDegenerateRadius){
     glm::vec2 R{0};
     auto res = ddW(R);
     ASSERT_EQ(0, res);
-}
\ No newline at end of file
+}
+
+TEST_F(SphKernelFixture, mullerKernelPolicyMatchesKernelLambdas) {
+    Kernel2D k{};
+    auto W = k(h);
+    auto dW = k.gradient(h);
+    auto ddW = k.laplacian(h);
+    MullerKernel2D kernel{ h };
+
+    for(auto x = -1.2f * h; x <= 1.2f * h; x += h * 0.07f){
+        for(auto y = -1.2f * h; y <= 1.2f * h; y += h * 0.11f){
+            glm::vec2 R{x, y};
+            KernelPair<2> pair{ R };
+            ASSERT_NEAR(kernel.W(pair), W(R), 1e-4f * W(glm::vec2{0}));
+            ASSERT_NEAR(kernel.dW(pair).x, dW(R).x, 1e-2f);
+            ASSERT_NEAR(kernel.dW(pair).y, dW(R).y, 1e-2f);
+            ASSERT_NEAR(kernel.ddW(pair), ddW(R), 1e-4f);
+        }
+    }
+}
+
+TEST_F(SphKernelFixture, cubicSplineIsNormalisedWithConsistentGradient) {
+    CubicSplineKernel2D kernel{ h };
+
+    double integral = 0;
+    const auto step = h / 200;
+    for(auto x = -h; x <= h; x += step){
+        for(auto y = -h; y <= h; y += step){
+            integral += kernel.W(KernelPair<2>{ {x, y} }) * step * step;
+        }
+    }
+    ASSERT_NEAR(integral, 1.0, 0.01);
+
+    const auto eps = h * 1e-3f;
+    for(auto r : { 0.1f * h, 0.3f * h, 0.5f * h, 0.7f * h, 0.9f * h }){
+        glm::vec2 R{ r * 0.6f, r * 0.8f };
+        auto gradient = kernel.dW(KernelPair<2>{ R });
+        auto dx = (kernel.W(KernelPair<2>{ R + glm::vec2{eps, 0} }) - kernel.W(KernelPair<2>{ R - glm::vec2{eps, 0} })) / (2 * eps);
+        ASSERT_NEAR(gradient.x, dx, 1e-2f * glm::length(gradient) + 1e-2f);
+    }
+    ASSERT_EQ(kernel.W(KernelPair<2>{ {h, 0} }), 0);
+    ASSERT_EQ(kernel.ddW(KernelPair<2>{ {2 * h, 0} }), 0);
+}
+
+TEST_F(SphKernelFixture, tabulatedKernelStaysWithinItsErrorBound) {
+    MullerKernel2D kernel{ h };
+    TabulatedKernel2D tabulated{ h };
+    const auto maxW = kernel.W(KernelPair<2>{ glm::vec2{0} });
+    const auto maxGradient = glm::length(kernel.dW(KernelPair<2>{ glm::vec2{h * 1e-4f, 0} }));
+
+    for(auto i = 0; i <= 10000; i++){
+        const auto r = h * to<float>(i) / 10000.f;
+        KernelPair<2> pair{ glm::vec2{ r * 0.6f, r * 0.8f } };
+        ASSERT_NEAR(tabulated.W(pair), kernel.W(pair), 2e-5f * maxW) << "r " << r;
+        ASSERT_LE(glm::length(tabulated.dW(pair) - kernel.dW(pair)), 5e-5f * maxGradient) << "r " << r;
+        if(r > h / 8) {
+            ASSERT_NEAR(tabulated.ddW(pair), kernel.ddW(pair), 1e-3f) << "r " << r;
+        }
+    }
+    KernelPair<2> outside{ glm::vec2{ h * 1.01f, 0 } };
+    ASSERT_EQ(tabulated.W(outside), 0);
+    ASSERT_EQ(glm::length(tabulated.dW(outside)), 0);
+    ASSERT_EQ(tabulated.ddW(outside), 0);
+    ASSERT_EQ(glm::length(tabulated.dW(KernelPair<2>{ glm::vec2{0} })), 0);
+}
@@ -0,0 +1,421 @@
+#include "sph/sph_solver.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class SphSolverFixture : public ::testing::Test {
+protected:
+    [[nodiscard]]
+    std::shared_ptr<SeparateFieldParticle2D> damBreak() const {
+        auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(NumParticles));
+        for(auto i = 0; i < NumParticles; i++) {
+            glm::vec2 position{ 1 + to<float>(i % 40) * 0.2f, 1 + to<float>(i / 40) * 0.2f };
+            particles->add(position, glm::vec2{0}, 1, 0.1f, 0.5f);
+        }
+        return particles;
+    }
+
+    // a 12 x 12 x 12 block packed at the particle diameter in a box of 5 x 5 x 5
+    [[nodiscard]]
+    std::shared_ptr<SeparateFieldParticle3D> damBreak3D() {
+        memory3D.emplace_back(SeparateFieldMemoryLayout3D::allocationSize(NumParticles3D));
+        auto particles = createSeparateFieldParticle3DPtr(memory3D.back());
+        for(auto i = 0; i < NumParticles3D; i++) {
+            glm::vec3 position{ 0.5f + to<float>(i % 12) * 0.2f, 0.5f + to<float>(i / 144) * 0.2f, 0.5f + to<float>(i / 12 % 12) * 0.2f };
+            particles->add(position, glm::vec3{0}, 1, 0.1f, 0.5f);
+        }
+        return particles;
+    }
+
+    template<typename Solver>
+    void run(Solver& solver) const {
+        for(auto i = 0; i < Frames; i++) {
+            solver.solve(TimeStep);
+        }
+    }
+
+    static constexpr int NumParticles = 1600;
+    static constexpr int Frames = 20;
+    static constexpr float TimeStep = 0.0166667f;
+    Bounds2D bounds{ glm::vec2(0), glm::vec2(20) };
+
+    static constexpr int NumParticles3D = 1728;
+    Bounds<3> bounds3D{ glm::vec3(0), glm::vec3(5) };
+    std::vector<std::vector<char>> memory3D;
+};
+
+TEST_F(SphSolverFixture, parallelGridMatchesSerialGrid) {
+    auto particles = damBreak();
+    UnBoundedSpacialHashGrid2D serial{ 0.2f, NumParticles };
+    UnBoundedSpacialHashGrid2D parallel{ 0.2f, NumParticles };
+    tp::ThreadPool pool{ 4 };
+
+    serial.initialize(*particles, particles->size());
+    parallel.initialize(*particles, particles->size(), [&](size_t count, auto&& fn){ pool.dispatch(to<uint32_t>(count), fn); });
+
+    ASSERT_TRUE(std::ranges::equal(serial.counts(), parallel.counts()));
+    ASSERT_TRUE(std::ranges::equal(serial.entries(), parallel.entries()));
+}
+
+TEST_F(SphSolverFixture, neighboursMatchQuery) {
+    auto particles = damBreak();
+    UnBoundedSpacialHashGrid2D grid{ 0.2f, NumParticles };
+    grid.initialize(*particles, particles->size());
+
+    for(auto i = 0; i < NumParticles; i += 37) {
+        const auto x = particles->position()[i];
+        std::vector<int32_t> neighbours{};
+        grid.forEachNeighbour(x, glm::vec2(0.4f), [&](int32_t j){ neighbours.push_back(j); });
+        const auto query = grid.query(x, glm::vec2(0.4f));
+        std::vector<int32_t> expected{ query.begin(), query.end() };
+        std::ranges::sort(expected);
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        std::ranges::sort(neighbours);
+        ASSERT_EQ(expected, neighbours) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, neighboursAreNotRepeatedAroundTheOrigin) {
+    // cells (x, y) and (-x, -y) hash to the same bucket
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(100));
+    for(auto i = 0; i < 100; i++) {
+        particles->add({ -1 + to<float>(i % 10) * 0.2f, -1 + to<float>(i / 10) * 0.2f }, glm::vec2{0}, 1, 0.1f, 0.5f);
+    }
+    UnBoundedSpacialHashGrid2D grid{ 0.2f, 100 };
+    grid.initialize(*particles, particles->size());
+
+    for(auto i = 0; i < 100; i++) {
+        const auto x = particles->position()[i];
+        std::vector<int32_t> neighbours{};
+        grid.forEachNeighbour(x, glm::vec2(0.4f), [&](int32_t j){ neighbours.push_back(j); });
+        std::ranges::sort(neighbours);
+        ASSERT_EQ(std::unique(neighbours.begin(), neighbours.end()), neighbours.end()) << "particle " << i;
+        ASSERT_EQ(grid.countNeighbours(x, glm::vec2(0.4f)), neighbours.size()) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, resultsDoNotDependOnNumberOfThreads) {
+    auto serialParticles = damBreak();
+    auto parallelParticles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> serial{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, serialParticles, bounds, 2 };
+    SphSolver2D<SeparateFieldMemoryLayout> parallel{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, parallelParticles, bounds, 2, 4 };
+    ASSERT_EQ(parallel.numThreads(), 4);
+    ASSERT_TRUE(parallel.symmetricForces());
+
+    run(serial);
+    run(parallel);
+
+    for(auto i = 0; i < NumParticles; i++) {
+        ASSERT_EQ(serialParticles->position()[i], parallelParticles->position()[i]) << "particle " << i;
+        ASSERT_EQ(serialParticles->velocity()[i], parallelParticles->velocity()[i]) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, pagedParticlesMatchSeparateFields) {
+    // enough particles to span three chunks
+    const auto n = to<int>(2 * PagedMemoryLayout2D::ChunkSize + 100);
+    auto separate = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(n));
+    auto paged = createPagedParticle2DPtr();
+    for(auto i = 0; i < n; i++) {
+        glm::vec2 position{ 1 + to<float>(i % 90) * 0.2f, 1 + to<float>(i / 90) * 0.2f };
+        separate->add(position, glm::vec2{0}, 1, 0.1f, 0.5f);
+        ASSERT_TRUE(paged->add(position, glm::vec2{0}, 1, 0.1f, 0.5f));
+    }
+    ASSERT_EQ(paged->layout.numChunks(), 3);
+    SphSolver2D<SeparateFieldMemoryLayout> separateSolver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, to<size_t>(n), separate, bounds, 2, 4 };
+    SphSolver2D<PagedMemoryLayout> pagedSolver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, to<size_t>(n), paged, bounds, 2, 4 };
+
+    for(auto frame = 0; frame < 5; frame++) {
+        separateSolver.solve(TimeStep);
+        pagedSolver.solve(TimeStep);
+    }
+
+    for(auto i = 0; i < n; i++) {
+        ASSERT_EQ(separate->position()[i], paged->position()[i]) << "particle " << i;
+        ASSERT_EQ(separate->velocity()[i], paged->velocity()[i]) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, gatherFindsEveryPairInsideTheSupport) {
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 1 };
+    run(solver);
+    solver.subStep(0);
+
+    const auto position = particles->position();
+    const auto cutoff = 0.4f + 0.001f;
+    const auto cutoff2 = cutoff * cutoff;
+    for(auto i = 0; i < NumParticles; i += 13) {
+        std::vector<int32_t> expected{};
+        for(auto j = 0; j < NumParticles; j++) {
+            const auto R = position[i] - position[j];
+            if(glm::dot(R, R) <= cutoff2) {
+                expected.push_back(j);
+            }
+        }
+        std::vector<int32_t> actual{ solver.neighbours(i).begin(), solver.neighbours(i).end() };
+        std::ranges::sort(actual);
+        ASSERT_EQ(expected, actual) << "particle " << i;
+
+        for(auto n = 0u; n < actual.size(); n++) {
+            const auto j = solver.neighbours(i)[n];
+            ASSERT_EQ(solver.pairs(i)[n].R, position[i] - position[j]);
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, pressureSolveIsNotRunWhenWeaklyCompressible) {
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 2 };
+    run(solver);
+
+    ASSERT_EQ(solver.pressureSolve().iterations, 0);
+    ASSERT_EQ(solver.pressureSolve().densityError, 0);
+}
+
+TEST_F(SphSolverFixture, predictiveCorrectiveSolveKeepsTheFluidIncompressible) {
+    // the block lands on the floor around frame 25
+    constexpr size_t SubSteps = 8;
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, SubSteps };
+    solver.mode(SphSolver2D<SeparateFieldMemoryLayout>::Mode::PredictiveCorrective);
+    solver.maxDensityError(0.01f);
+    solver.maxPressureIterations(50);
+
+    for(auto frame = 0; frame < 40; frame++) {
+        solver.solve(TimeStep);
+        ASSERT_GE(solver.pressureSolve().iterations, 4 * SubSteps) << "frame " << frame;
+        ASSERT_LT(solver.pressureSolve().iterations, 50 * SubSteps) << "frame " << frame;
+        ASSERT_LE(solver.pressureSolve().densityError, 0.01f) << "frame " << frame;
+
+        const auto density = solver.density();
+        for(auto i = 0; i < NumParticles; i++) {
+            ASSERT_LT(density[i], 1.05f * solver.restDensity()) << "frame " << frame << " particle " << i;
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, fixedSubStepsAreReported) {
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 3 };
+    run(solver);
+
+    const auto& counts = solver.subStepCounts();
+    ASSERT_EQ(counts.frames, Frames);
+    ASSERT_EQ(counts.min, 3);
+    ASSERT_EQ(counts.max, 3);
+    ASSERT_EQ(counts.total, 3 * Frames);
+}
+
+TEST_F(SphSolverFixture, adaptiveSubStepsStayWithinTheirBounds) {
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 1, 4 };
+    solver.subStepping({ .adaptive = true, .minSubSteps = 2, .maxSubSteps = 6 });
+
+    for(auto frame = 0; frame < 40; frame++) {
+        solver.solve(TimeStep);
+        ASSERT_GE(solver.subStepCounts().last, 2) << "frame " << frame;
+        ASSERT_LE(solver.subStepCounts().last, 6) << "frame " << frame;
+    }
+    ASSERT_EQ(solver.subStepCounts().frames, 40);
+}
+
+TEST_F(SphSolverFixture, fasterParticlesTakeMoreSubSteps) {
+    auto particles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, particles, bounds, 1 };
+    solver.subStepping({ .adaptive = true, .minSubSteps = 1, .maxSubSteps = 64 });
+
+    // at rest the speed of sound sets the count, 0.0167 * sqrt(20) / (0.4 * 0.2) -> 1
+    solver.solve(TimeStep);
+    ASSERT_EQ(solver.subStepCounts().last, 1);
+
+    // a particle crossing 0.0167 * 30 = 0.5 per frame, 0.0167 * (30 + sqrt(20)) / (0.4 * 0.2) -> 8
+    particles->velocity()[0] = glm::vec2{ 30, 0 };
+    solver.solve(TimeStep);
+    ASSERT_EQ(solver.subStepCounts().last, 8);
+    ASSERT_EQ(solver.subStepCounts().min, 1);
+    ASSERT_EQ(solver.subStepCounts().max, 8);
+}
+
+TEST_F(SphSolverFixture, symmetricForcesMatchPerParticleForces) {
+    auto symmetricParticles = damBreak();
+    auto perParticleParticles = damBreak();
+    SphSolver2D<SeparateFieldMemoryLayout> symmetric{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, symmetricParticles, bounds, 1, 4 };
+    SphSolver2D<SeparateFieldMemoryLayout> perParticle{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles, perParticleParticles, bounds, 1 };
+    perParticle.symmetricForces(false);
+    ASSERT_TRUE(symmetric.symmetricForces());
+
+    // two frames, the sums only differ in their order of addition. The second one reuses the block
+    // buffers the first one left behind
+    for(auto frame = 0; frame < 2; frame++) {
+        symmetric.solve(TimeStep);
+        perParticle.solve(TimeStep);
+
+        for(auto i = 0; i < NumParticles; i++) {
+            const auto expected = perParticleParticles->velocity()[i];
+            const auto actual = symmetricParticles->velocity()[i];
+            ASSERT_NEAR(expected.x, actual.x, 1e-4f * (1 + glm::abs(expected.x))) << "frame " << frame << " particle " << i;
+            ASSERT_NEAR(expected.y, actual.y, 1e-4f * (1 + glm::abs(expected.y))) << "frame " << frame << " particle " << i;
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, boundaryIsSampledOnTheSurface) {
+    const csg::Sdf circle = csg::Circle{ { 10, 10 }, 2 };
+    const auto samples = sampleBoundary(circle, bounds, 0.2f);
+
+    // about one sample per spacing along the circumference
+    ASSERT_GT(samples.size(), 50);
+    ASSERT_LT(samples.size(), 80);
+    for(auto a = 0u; a < samples.size(); a++) {
+        ASSERT_NEAR(circle(samples[a]), 0, 0.002f) << "sample " << a;
+        for(auto b = a + 1; b < samples.size(); b++) {
+            ASSERT_GE(glm::distance(samples[a], samples[b]), 0.15f) << "samples " << a << ", " << b;
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, boundaryParticlesGiveAFlatWallTheRestDensity) {
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(1));
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, 1, particles, bounds, 1 };
+    // the kernel of the solver, its support is twice the smoothing radius
+    const MullerKernel2D kernel{ 2 * solver.smoothingRadius() };
+    // solid below y = 5, sampled at the particle diameter and at half of it
+    for(const auto spacing : { 0.2f, 0.1f }) {
+        solver.boundary(csg::Plane{ 5 }, spacing);
+        const auto& boundary = solver.boundary();
+        ASSERT_GT(boundary.size(), 0);
+
+        // the density a sample receives from its own wall is the rest density, whatever the spacing
+        float density = 0;
+        const auto x = glm::vec2{ 10, 5 };
+        boundary.forEach(x, [&](const KernelPair<2>& pair, float psi){
+            density += psi * kernel.W(pair);
+        });
+        ASSERT_NEAR(density, solver.restDensity(), 0.05f * solver.restDensity()) << "spacing " << spacing;
+    }
+}
+
+TEST_F(SphSolverFixture, boundaryParticlesHoldTheFluidOutsideAnObstacle) {
+    // the block falls onto a circle in the middle of the box
+    const csg::Sdf obstacle = csg::Circle{ { 5, 2 }, 1.5f };
+    for(const auto mode : { SphSolver2D<SeparateFieldMemoryLayout>::Mode::WeaklyCompressible,
+                            SphSolver2D<SeparateFieldMemoryLayout>::Mode::PredictiveCorrective }) {
+        auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(400));
+        for(auto i = 0; i < 400; i++) {
+            particles->add({ 3 + to<float>(i % 20) * 0.2f, 5 + to<float>(i / 20) * 0.2f }, glm::vec2{0}, 1, 0.1f, 0.5f);
+        }
+        SphSolver2D<SeparateFieldMemoryLayout> solver{
+            0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, 400, particles, Bounds2D{ glm::vec2(0), glm::vec2(10) }, 4 };
+        solver.mode(mode);
+        solver.boundary(obstacle);
+
+        for(auto frame = 0; frame < 60; frame++) {
+            solver.solve(TimeStep);
+        }
+        for(auto i = 0; i < 400; i++) {
+            ASSERT_GT(obstacle(particles->position()[i]), 0) << "particle " << i;
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, gatherFindsEveryPairInsideTheSupportIn3D) {
+    auto particles = damBreak3D();
+    SphSolver3D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles3D, particles, bounds3D, 2 };
+    run(solver);
+    solver.subStep(0);
+
+    const auto position = particles->position();
+    const auto cutoff = 0.4f + 0.001f;
+    const auto cutoff2 = cutoff * cutoff;
+    for(auto i = 0; i < NumParticles3D; i += 13) {
+        std::vector<int32_t> expected{};
+        for(auto j = 0; j < NumParticles3D; j++) {
+            const auto R = position[i] - position[j];
+            if(glm::dot(R, R) <= cutoff2) {
+                expected.push_back(j);
+            }
+        }
+        std::vector<int32_t> actual{ solver.neighbours(i).begin(), solver.neighbours(i).end() };
+        std::ranges::sort(actual);
+        ASSERT_EQ(expected, actual) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, resultsDoNotDependOnNumberOfThreadsIn3D) {
+    auto serialParticles = damBreak3D();
+    auto parallelParticles = damBreak3D();
+    SphSolver3D<SeparateFieldMemoryLayout> serial{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles3D, serialParticles, bounds3D, 2 };
+    SphSolver3D<SeparateFieldMemoryLayout> parallel{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles3D, parallelParticles, bounds3D, 2, 4 };
+
+    run(serial);
+    run(parallel);
+
+    for(auto i = 0; i < NumParticles3D; i++) {
+        ASSERT_EQ(serialParticles->position()[i], parallelParticles->position()[i]) << "particle " << i;
+        ASSERT_EQ(serialParticles->velocity()[i], parallelParticles->velocity()[i]) << "particle " << i;
+    }
+}
+
+TEST_F(SphSolverFixture, queryCoversTheBoxIn3D) {
+    auto particles = damBreak3D();
+    UnBoundedSpacialHashGrid3D grid{ 0.2f, NumParticles3D };
+    grid.initialize(*particles, particles->size());
+
+    const auto position = particles->position();
+    const auto x = position[6 + 6 * 12 + 6 * 144];
+    const auto result = grid.query(x, glm::vec3(0.4f));
+    const std::vector<int32_t> found{ result.begin(), result.end() };
+    for(auto j = 0; j < NumParticles3D; j++) {
+        if(glm::distance(position[j], x) < 0.39f) {
+            ASSERT_NE(std::ranges::find(found, j), found.end()) << "particle " << j;
+        }
+    }
+}
+
+TEST_F(SphSolverFixture, particleInsideTheBlockHasTheRestDensityIn3D) {
+    auto particles = damBreak3D();
+    SphSolver3D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles3D, particles, bounds3D, 1 };
+    solver.subStep(0);
+
+    // the middle of the block is further than the kernel support from its faces
+    const auto density = solver.density()[6 + 6 * 12 + 6 * 144];
+    ASSERT_NEAR(density, solver.restDensity(), 0.01f * solver.restDensity());
+}
+
+TEST_F(SphSolverFixture, predictiveCorrectiveSolveKeepsTheFluidIncompressibleIn3D) {
+    // the block lands on the floor around frame 20
+    constexpr size_t SubSteps = 8;
+    auto particles = damBreak3D();
+    SphSolver3D<SeparateFieldMemoryLayout> solver{
+        0.2f, 0.1f, 20.f, 0.99f, 9.8f, 1.f, NumParticles3D, particles, bounds3D, SubSteps, 4 };
+    solver.mode(SphSolver3D<SeparateFieldMemoryLayout>::Mode::PredictiveCorrective);
+
+    for(auto frame = 0; frame < 30; frame++) {
+        solver.solve(TimeStep);
+        ASSERT_LE(solver.pressureSolve().densityError, 0.01f) << "frame " << frame;
+
+        const auto density = solver.density();
+        for(auto i = 0; i < NumParticles3D; i++) {
+            ASSERT_LT(density[i], 1.05f * solver.restDensity()) << "frame " << frame << " particle " << i;
+        }
+    }
+}
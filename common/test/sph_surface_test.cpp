@@ -0,0 +1,139 @@
+#include "sph/sph_surface.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+class SphSurfaceFixture : public ::testing::Test {
+protected:
+    // particles packed at the diameter inside a disc
+    [[nodiscard]]
+    std::shared_ptr<SeparateFieldParticle2D> disc(glm::vec2 center, float radius) const {
+        auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(MaxParticles));
+        add(*particles, center, radius);
+        return particles;
+    }
+
+    static void add(SeparateFieldParticle2D& particles, glm::vec2 center, float radius) {
+        const auto steps = to<int>(radius / (2 * Radius));
+        for(auto y = -steps; y <= steps; y++) {
+            for(auto x = -steps; x <= steps; x++) {
+                const auto offset = glm::vec2(x, y) * 2.f * Radius;
+                if(glm::length(offset) <= radius) {
+                    particles.add(center + offset, glm::vec2{0}, 1, Radius, 0.5f);
+                }
+            }
+        }
+    }
+
+    // positive when the polyline runs counter clockwise
+    static float signedArea(std::span<const glm::vec2> polyline) {
+        float area = 0;
+        for(auto i = 0u; i < polyline.size(); i++) {
+            const auto a = polyline[i];
+            const auto b = polyline[(i + 1) % polyline.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        return 0.5f * area;
+    }
+
+    static constexpr float Radius = 0.1f;
+    static constexpr float SmoothingRadius = 0.2f;
+    static constexpr size_t MaxParticles = 10000;
+    Bounds2D bounds{ glm::vec2(0), glm::vec2(10) };
+};
+
+TEST_F(SphSurfaceFixture, discIsOneCounterClockwiseLoopAroundTheParticles) {
+    const glm::vec2 center{ 5, 5 };
+    auto particles = disc(center, 2);
+    SurfaceExtractor2D<> extractor{ bounds, 0.05f, SmoothingRadius, Radius, MaxParticles };
+
+    const auto& polylines = extractor.extract(*particles);
+
+    ASSERT_EQ(polylines.size(), 1);
+    const auto loop = polylines[0];
+    ASSERT_GT(loop.size(), 100);
+    // the outer particles of the packing are between 1.8 and 2 from the center, the surface is
+    // within a particle radius of them
+    for(const auto& p : loop) {
+        ASSERT_NEAR(glm::distance(p, center), 2, 2 * Radius) << p.x << ", " << p.y;
+    }
+    const auto area = signedArea(loop);
+    ASSERT_GT(area, 0);
+    ASSERT_NEAR(area, glm::pi<float>() * 2.1f * 2.1f, 0.1f * glm::pi<float>() * 2.1f * 2.1f);
+}
+
+TEST_F(SphSurfaceFixture, separateBlobsGiveSeparateLoops) {
+    auto particles = disc({ 2.5f, 5 }, 1);
+    add(*particles, { 7.5f, 5 }, 1);
+    SurfaceExtractor2D<> extractor{ bounds, 0.05f, SmoothingRadius, Radius, MaxParticles };
+
+    const auto& polylines = extractor.extract(*particles);
+
+    ASSERT_EQ(polylines.size(), 2);
+    for(auto i = 0u; i < polylines.size(); i++) {
+        ASSERT_GT(signedArea(polylines[i]), 0) << "polyline " << i;
+    }
+}
+
+TEST_F(SphSurfaceFixture, polylinesVisitEveryCrossingOnce) {
+    auto particles = disc({ 2.5f, 5 }, 1);
+    add(*particles, { 7.5f, 5 }, 1);
+    SurfaceExtractor2D<> extractor{ bounds, 0.05f, SmoothingRadius, Radius, MaxParticles };
+
+    const auto& polylines = extractor.extract(*particles);
+
+    ASSERT_EQ(polylines.size(), 2);
+    for(auto i = 0u; i < polylines.size(); i++) {
+        const auto loop = polylines[i];
+        // the last point connects back to the first, it is not repeated
+        ASSERT_NE(loop.front(), loop.back()) << "polyline " << i;
+        std::vector<std::pair<float, float>> points;
+        for(const auto& p : loop) {
+            points.emplace_back(p.x, p.y);
+        }
+        std::ranges::sort(points);
+        ASSERT_EQ(std::ranges::adjacent_find(points), points.end()) << "polyline " << i;
+    }
+}
+
+TEST_F(SphSurfaceFixture, fluidAgainstTheBoundsIsClosedAlongThem) {
+    // a pool covering the floor of the box
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(MaxParticles));
+    for(auto i = 0; i < 50 * 10; i++) {
+        particles->add({ Radius + to<float>(i % 50) * 2 * Radius, Radius + to<float>(i / 50) * 2 * Radius }, glm::vec2{0}, 1, Radius, 0.5f);
+    }
+    SurfaceExtractor2D<> extractor{ bounds, 0.1f, SmoothingRadius, Radius, MaxParticles };
+
+    const auto& polylines = extractor.extract(*particles);
+
+    ASSERT_EQ(polylines.size(), 1);
+    ASSERT_NEAR(signedArea(polylines[0]), 10 * 2, 0.1f * 10 * 2);
+}
+
+TEST_F(SphSurfaceFixture, noParticlesNoSurface) {
+    auto particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(MaxParticles));
+    SurfaceExtractor2D<> extractor{ bounds, 0.1f, SmoothingRadius, Radius, MaxParticles };
+
+    ASSERT_EQ(extractor.extract(*particles).size(), 0);
+    ASSERT_TRUE(std::ranges::all_of(extractor.field(), [](float c){ return c == 0; }));
+}
+
+TEST_F(SphSurfaceFixture, surfaceDoesNotDependOnNumberOfThreads) {
+    auto particles = disc({ 3, 4 }, 2);
+    add(*particles, { 7, 6 }, 1.5f);
+    SurfaceExtractor2D<> serial{ bounds, 0.05f, SmoothingRadius, Radius, MaxParticles };
+    tp::ThreadPool pool{ 4 };
+    SurfaceExtractor2D<> parallel{ bounds, 0.05f, SmoothingRadius, Radius, MaxParticles, 0.5f, &pool };
+    ASSERT_EQ(parallel.numThreads(), 4);
+
+    // twice, the links of the first frame have to be cleared for the second
+    for(auto frame = 0; frame < 2; frame++) {
+        const auto& expected = serial.extract(*particles);
+        const auto& actual = parallel.extract(*particles);
+        ASSERT_EQ(expected.offsets, actual.offsets) << "frame " << frame;
+        ASSERT_EQ(expected.points, actual.points) << "frame " << frame;
+    }
+}
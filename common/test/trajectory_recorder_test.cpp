@@ -0,0 +1,228 @@
+#include "trajectory_recorder.h"
+#include "model2d.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <random>
+
+class TrajectoryRecorderFixture : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "trajectory_recorder_test.ptraj").string();
+        particles = createSeparateFieldParticle2D(NumParticles + 1);
+        std::default_random_engine engine{ 1 << 20 };
+        std::uniform_real_distribution<float> dist{0, 20};
+        for(auto i = 0; i < NumParticles; i++){
+            particles.add({dist(engine), dist(engine)}, {dist(engine) - 10, dist(engine) - 10}, 1, 0.1f, 0.5f);
+        }
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    // moves the particles so consecutive frames differ
+    void advance(float dt) {
+        auto position = particles.position();
+        auto velocity = particles.velocity();
+        for(auto i = 0; i < particles.size(); i++){
+            position[i] += velocity[i] * dt;
+            velocity[i] += glm::vec2(0, -9.8f) * dt;
+        }
+    }
+
+    static constexpr int NumParticles = 2000;
+    std::string path;
+    SeparateFieldParticle2D particles;
+};
+
+TEST_F(TrajectoryRecorderFixture, recordedFramesDecodeWithinQuantisationStep) {
+    trajectory::Settings settings{};
+    settings.keyFrameInterval = 8;
+    std::vector<std::vector<glm::vec2>> expectedPositions;
+    std::vector<std::vector<glm::vec2>> expectedVelocities;
+    std::vector<uint64_t> recordedSteps;
+    {
+        trajectory::Recorder recorder{path, settings};
+        for(auto frame = 0; frame < 30; frame++){
+            if(frame == 10) particles.add(glm::vec2(1), glm::vec2(2), 1, 0.1f, 0.5f);
+            ASSERT_TRUE(recorder.capture(particles, frame * 0.01));
+            recorder.flush();
+            recordedSteps.push_back(frame);
+            auto position = particles.position();
+            auto velocity = particles.velocity();
+            expectedPositions.emplace_back();
+            expectedVelocities.emplace_back();
+            for(auto i = 0; i < particles.size(); i++){
+                expectedPositions.back().push_back(position[i]);
+                expectedVelocities.back().push_back(velocity[i]);
+            }
+            advance(0.01f);
+        }
+        recorder.close();
+        auto counters = recorder.counters();
+        ASSERT_EQ(counters.captured, 30);
+        ASSERT_EQ(counters.written, 30);
+        ASSERT_EQ(counters.dropped, 0);
+        ASSERT_LT(counters.compressedBytes, counters.rawBytes);
+    }
+
+    trajectory::Reader reader{path};
+    ASSERT_EQ(reader.frameCount(), recordedSteps.size());
+
+    std::vector<glm::vec2> position, velocity;
+    for(auto frame = 0; frame < reader.frameCount(); frame++){
+        ASSERT_EQ(reader.frame(frame).step, recordedSteps[frame]);
+        reader.read(frame, position, velocity);
+        ASSERT_EQ(position.size(), expectedPositions[frame].size());
+        for(auto i = 0; i < position.size(); i++){
+            ASSERT_NEAR(position[i].x, expectedPositions[frame][i].x, settings.positionStep);
+            ASSERT_NEAR(position[i].y, expectedPositions[frame][i].y, settings.positionStep);
+            ASSERT_NEAR(velocity[i].x, expectedVelocities[frame][i].x, settings.velocityStep);
+            ASSERT_NEAR(velocity[i].y, expectedVelocities[frame][i].y, settings.velocityStep);
+        }
+    }
+}
+
+TEST_F(TrajectoryRecorderFixture, randomAccessMatchesSequentialDecoding) {
+    {
+        trajectory::Recorder recorder{path, { 1e-4f, 1e-3f, 16, 1 }};
+        for(auto frame = 0; frame < 50; frame++){
+            ASSERT_TRUE(recorder.capture(particles, frame));
+            recorder.flush();
+            advance(0.01f);
+        }
+    }
+
+    trajectory::Reader sequential{path};
+    ASSERT_EQ(sequential.frameCount(), 50);
+    std::vector<std::vector<glm::vec2>> frames;
+    std::vector<glm::vec2> position, velocity;
+    for(auto frame = 0; frame < sequential.frameCount(); frame++){
+        sequential.read(frame, position, velocity);
+        frames.push_back(position);
+    }
+
+    trajectory::Reader reader{path};
+    for(auto frame : { 37, 3, 16, 15, 17, 0 }){
+        reader.read(frame, position, velocity);
+        ASSERT_EQ(position, frames[frame]) << "frame " << frame;
+    }
+}
+
+TEST_F(TrajectoryRecorderFixture, framesAreDroppedInsteadOfBlockingWhenWriterFallsBehind) {
+    // the writer is stuck on the first frame until the captures are done
+    std::promise<void> release;
+    trajectory::Settings settings{};
+    settings.compressor = [written = release.get_future().share()](auto raw, auto& compressed, auto level){
+        written.wait();
+        return trajectory::compress(raw, compressed, level);
+    };
+    trajectory::Recorder recorder{path, settings};
+    for(auto frame = 0; frame < 200; frame++){
+        recorder.capture(particles, frame);
+    }
+    release.set_value();
+    recorder.close();
+
+    // the first frame is being written, the second waits in the other staging buffer
+    auto counters = recorder.counters();
+    ASSERT_EQ(counters.captured, 200);
+    ASSERT_EQ(counters.written, 2);
+    ASSERT_EQ(counters.dropped, 198);
+    ASSERT_EQ(counters.backPressure, 1);
+
+    trajectory::Reader reader{path};
+    ASSERT_EQ(reader.frameCount(), 2);
+    ASSERT_EQ(reader.frame(0).step, 0);
+    ASSERT_EQ(reader.frame(1).step, 1);
+}
+
+TEST_F(TrajectoryRecorderFixture, framesAfterAFailedFrameDecodeAgainstTheLastWrittenFrame) {
+    constexpr auto FailedStep = 3;
+    trajectory::Settings settings{};
+    settings.keyFrameInterval = 8;
+    settings.compressor = [call = 0](auto raw, auto& compressed, auto level) mutable {
+        return call++ != FailedStep && trajectory::compress(raw, compressed, level);
+    };
+    std::vector<std::vector<glm::vec2>> expectedPositions;
+    {
+        trajectory::Recorder recorder{path, settings};
+        for(auto frame = 0; frame < 12; frame++){
+            ASSERT_TRUE(recorder.capture(particles, frame));
+            recorder.flush();
+            auto position = particles.position();
+            expectedPositions.emplace_back();
+            for(auto i = 0; i < particles.size(); i++){
+                expectedPositions.back().push_back(position[i]);
+            }
+            advance(0.01f);
+        }
+        recorder.close();
+        auto counters = recorder.counters();
+        ASSERT_EQ(counters.written, 11);
+        ASSERT_EQ(counters.failed, 1);
+    }
+
+    trajectory::Reader reader{path};
+    ASSERT_EQ(reader.frameCount(), 11);
+    std::vector<glm::vec2> position, velocity;
+    for(auto frame = 0; frame < reader.frameCount(); frame++){
+        const auto step = reader.frame(frame).step;
+        ASSERT_NE(step, FailedStep);
+        reader.read(frame, position, velocity);
+        for(auto i = 0; i < position.size(); i++){
+            ASSERT_NEAR(position[i].x, expectedPositions[step][i].x, settings.positionStep) << "step " << step;
+            ASSERT_NEAR(position[i].y, expectedPositions[step][i].y, settings.positionStep) << "step " << step;
+        }
+    }
+}
+
+TEST_F(TrajectoryRecorderFixture, rejectsFilesThatAreNotTrajectories) {
+    {
+        std::ofstream fout{path, std::ios::binary};
+        std::string garbage(256, 'x');
+        fout << garbage;
+    }
+    ASSERT_THROW(trajectory::Reader{path}, std::runtime_error);
+}
+
+TEST_F(TrajectoryRecorderFixture, rejectsCorruptSizesBeforeAllocating) {
+    {
+        trajectory::Recorder recorder{path, trajectory::Settings{}};
+        for(auto frame = 0; frame < 3; frame++){
+            ASSERT_TRUE(recorder.capture(particles, frame * 0.01));
+            recorder.flush();
+        }
+        recorder.close();
+    }
+    auto patch = [&](std::streamoff offset, auto value){
+        std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    const auto frameCount = offsetof(trajectory::FileHeader, frameCount);
+    patch(frameCount, std::numeric_limits<uint64_t>::max() / 64);
+    ASSERT_THROW(trajectory::Reader{path}, std::runtime_error);
+    patch(frameCount, uint64_t{3});
+
+    const auto compressedBytes = sizeof(trajectory::FileHeader) + offsetof(trajectory::FrameHeader, compressedBytes);
+    patch(compressedBytes, std::numeric_limits<uint64_t>::max() / 2);
+    trajectory::Reader reader{path};
+    std::vector<glm::vec2> position, velocity;
+    ASSERT_THROW(reader.read(0, position, velocity), std::runtime_error);
+}
+
+TEST_F(TrajectoryRecorderFixture, rejectsVersionZero) {
+    {
+        std::ofstream fout{path, std::ios::binary};
+        trajectory::FileHeader header{};
+        header.version = 0;
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    ASSERT_THROW(trajectory::Reader{path}, std::runtime_error);
+}
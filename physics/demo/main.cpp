@@ -1,4 +1,4 @@
-#include "sdf2d.h"
+#include "sdf_expression.h"
 #include "world2d.h"
 #include <fmt/format.h>
 #include <iostream>
@@ -29,11 +29,7 @@ int main(int, char**){
         .withMass(1)
         .withRestitution(0.5);
 
-    std::function<float(const glm::vec2& point)> sdf = [](const glm::vec2& point) {
-        auto d0 = point.y - 3.0f;
-        auto d1 = glm::distance(point, glm::vec2(10, 18)) - 1.5f;
-        return glm::min(d0, d1);
-    };
+    auto sdf = csg::Plane{ 3.0f } | csg::Circle{ {10, 18}, 1.5f };
 
     std::unique_ptr<PointGenerator2D> pointGenerator = std::make_unique<TrianglePointGenerator>();
     std::unique_ptr<ParticleEmitter<SeparateFieldMemoryLayout>> vemitter =
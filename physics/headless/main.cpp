@@ -0,0 +1,140 @@
+#include "sph/sph_solver.h"
+#include "sph/sph_surface.h"
+#include "volume_emitter_2d.h"
+#include "point_generators.h"
+#include "frame_stats.h"
+#include "trajectory_recorder.h"
+#include "checkpoint.h"
+#include <spdlog/spdlog.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// runs the sph dam break scene without a window and dumps frame statistics as json,
+// the trajectory of every frame is recorded when a trajectory path is given ("-" for none).
+// With a checkpoint path the run resumes from the checkpoint if it exists and saves it when done ("-" for none).
+// "pcisph" solves pressure with the predictive corrective solve instead of the gas constant.
+// "adaptive" picks the sub steps of every frame from the particle speeds and accelerations.
+// With a surface path the free surface of every frame is extracted and written as text, a line
+// "frame <frame> <polylines>" followed by one line "<points> x0 y0 x1 y1 ..." per closed polyline.
+// usage: headless [frames] [stats.json] [trajectory.ptraj|-] [checkpoint.pckpt|-] [threads] [wcsph|pcisph] [fixed|adaptive] [surface.txt|-]
+int main(int argc, char** argv){
+    const int numFrames = argc > 1 ? std::stoi(argv[1]) : 1200;
+    const std::string statsPath = argc > 2 ? argv[2] : "headless_stats.json";
+    const std::string trajectoryPath = argc > 3 ? argv[3] : "-";
+    const std::string checkpointPath = argc > 4 && std::string{ argv[4] } != "-" ? argv[4] : "";
+    const uint32_t numThreads = argc > 5 ? std::stoul(argv[5]) : 1;
+    const bool predictiveCorrective = argc > 6 && std::string{ argv[6] } == "pcisph";
+    const bool adaptive = argc > 7 && std::string{ argv[7] } == "adaptive";
+    const std::string surfacePath = argc > 8 && std::string{ argv[8] } != "-" ? argv[8] : "";
+    std::unique_ptr<trajectory::Recorder> recorder = trajectoryPath != "-" ? std::make_unique<trajectory::Recorder>(trajectoryPath) : nullptr;
+
+    Bounds2D bounds{ glm::vec2(0), glm::vec2(20) };
+    const float radius = 0.1f;
+    const float smoothingRadius = 0.2f;
+    const size_t maxParticles = 100000;
+    const float deltaTime = 1.0f / 120.f;
+
+    std::vector<char> memory(SeparateFieldMemoryLayout2D::allocationSize(maxParticles));
+    auto particles = createSeparateFieldParticle2DPtr(memory);
+
+    csg::Sdf sdf = csg::Plane{ 5.0f };
+    std::unique_ptr<PointGenerator2D> pointGenerator = std::make_unique<TrianglePointGenerator>();
+    Emitters<SeparateFieldMemoryLayout> emitters{};
+    emitters.push_back(std::make_unique<VolumeEmitter2D<SeparateFieldMemoryLayout>>(std::move(sdf), std::move(pointGenerator), shrink(bounds, radius), radius * 2));
+
+    SphSolver2D<SeparateFieldMemoryLayout> solver{
+        smoothingRadius, radius, 20, 0.99f, 10.f, 1, maxParticles, particles, bounds, 1, numThreads };
+    if(predictiveCorrective) {
+        solver.mode(SphSolver2D<SeparateFieldMemoryLayout>::Mode::PredictiveCorrective);
+    }
+    if(adaptive) {
+        solver.subStepping({ .adaptive = true, .minSubSteps = 1, .maxSubSteps = 16 });
+    }
+
+    stats::FrameStats frameStats;
+    solver.attach(frameStats);
+
+    // cells of a particle radius, small enough to follow single particles leaving the fluid. The
+    // surface is extracted after the solve and shares the solver threads
+    std::unique_ptr<SurfaceExtractor2D<>> surface = !surfacePath.empty()
+            ? std::make_unique<SurfaceExtractor2D<>>(bounds, radius, smoothingRadius, radius, maxParticles, 0.5f, solver.threadPool())
+            : nullptr;
+    std::ofstream surfaceFile{};
+    if(surface) {
+        surfaceFile.open(surfacePath);
+    }
+
+    for(auto& emitter : emitters) {
+        emitter->set(particles);
+    }
+
+    if(!checkpointPath.empty() && std::filesystem::exists(checkpointPath)) {
+        checkpoint::restore(checkpointPath, solver, emitters);
+        spdlog::info("resumed {} particles from {}", particles->size(), checkpointPath);
+    }
+
+    size_t pressureIterations = 0;
+    float densityError = 0;
+    for(auto frame = 0; frame < numFrames; frame++){
+        stats::ScopedTimer stepTimer{frameStats.step()};
+        {
+            stats::ScopedTimer timer{frameStats.phase("emit")};
+            for(auto& emitter : emitters) {
+                emitter->update(deltaTime);
+            }
+        }
+        {
+            stats::ScopedTimer timer{frameStats.phase("solve")};
+            solver.solve(deltaTime);
+            pressureIterations += solver.pressureSolve().iterations;
+            densityError = std::max(densityError, solver.pressureSolve().densityError);
+        }
+        if(recorder) {
+            stats::ScopedTimer timer{frameStats.phase("record")};
+            recorder->capture(*particles, frame * deltaTime);
+        }
+        if(surface) {
+            stats::ScopedTimer timer{frameStats.phase("surface")};
+            const auto& polylines = surface->extract(*particles);
+            surfaceFile << "frame " << frame << " " << polylines.size() << "\n";
+            for(auto i = 0u; i < polylines.size(); i++){
+                const auto polyline = polylines[i];
+                surfaceFile << polyline.size();
+                for(const auto& p : polyline){
+                    surfaceFile << " " << p.x << " " << p.y;
+                }
+                surfaceFile << "\n";
+            }
+        }
+    }
+
+    const auto step = frameStats.step().summary();
+    spdlog::info("{} particles, {} frames, step p50: {:.3f} ms, p99: {:.3f} ms, max: {:.3f} ms",
+                 particles->size(), numFrames, step.p50, step.p99, step.max);
+    const auto& subSteps = solver.subStepCounts();
+    spdlog::info("sub steps per frame: {:.2f} average, {} min, {} max", subSteps.average(), subSteps.min, subSteps.max);
+    if(predictiveCorrective) {
+        spdlog::info("pressure solve: {:.1f} iterations per frame, largest density error {:.4f}",
+                     static_cast<double>(pressureIterations) / std::max(1, numFrames), densityError);
+    }
+
+    if(recorder) {
+        recorder->close();
+        const auto counters = recorder->counters();
+        spdlog::info("trajectory: {} frames written, {} dropped, {} failed, {} under back pressure, {:.1f}x compression",
+                     counters.written, counters.dropped, counters.failed, counters.backPressure,
+                     static_cast<double>(counters.rawBytes) / static_cast<double>(std::max<uint64_t>(1, counters.compressedBytes)));
+    }
+
+    if(!checkpointPath.empty()) {
+        checkpoint::save(checkpointPath, solver, emitters);
+    }
+
+    if(!frameStats.dump(statsPath)){
+        spdlog::error("unable to write stats to {}", statsPath);
+        return 1;
+    }
+    return 0;
+}
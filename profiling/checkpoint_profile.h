@@ -0,0 +1,79 @@
+#pragma once
+
+#include "checkpoint.h"
+#include "solver2d.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <filesystem>
+#include <random>
+#include <memory>
+
+// checkpoint save and restore of a Verlet solver and its particles. serialise is what the
+// simulation thread pays when the file is written by closeAsync(), the target is under one
+// frame (16.6 ms) for 1M particles
+class CheckpointFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        const auto N = static_cast<size_t>(state.range(0));
+        memory.resize(SeparateFieldMemoryLayout2D::allocationSize(N));
+        particles = createSeparateFieldParticle2DPtr(memory);
+
+        std::default_random_engine engine{ (1 << 20) };
+        std::uniform_real_distribution<float> dist{0.2f, 99.8f};
+        for(auto i = 0; i < N; i++){
+            particles->add({dist(engine), dist(engine)}, glm::vec2{0}, 1, 0.1f, 0.5f);
+        }
+        solver = std::make_unique<VarletIntegrationSolver<SeparateFieldMemoryLayout>>(
+                particles, Bounds2D{glm::vec2(0), glm::vec2(100)}, 0.1f, 8);
+        path = (std::filesystem::temp_directory_path() / "checkpoint_profile.pckpt").string();
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        solver.reset();
+        particles.reset();
+        std::filesystem::remove(path);
+    }
+
+    std::vector<char> memory;
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+    std::unique_ptr<VarletIntegrationSolver<SeparateFieldMemoryLayout>> solver;
+    std::string path;
+};
+
+BENCHMARK_DEFINE_F(CheckpointFixture, serialise)(benchmark::State& state) {
+    std::vector<char> buffer;
+    for(auto _ : state){
+        checkpoint::Writer writer{path, std::move(buffer)};
+        solver->save(writer);
+        state.PauseTiming();
+        buffer = writer.closeAsync().get();
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * particles->size() * SeparateFieldMemoryLayout2D::Width));
+}
+
+BENCHMARK_DEFINE_F(CheckpointFixture, save)(benchmark::State& state) {
+    for(auto _ : state){
+        checkpoint::Writer writer{path};
+        solver->save(writer);
+        writer.close();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * particles->size() * SeparateFieldMemoryLayout2D::Width));
+}
+
+BENCHMARK_DEFINE_F(CheckpointFixture, restore)(benchmark::State& state) {
+    {
+        checkpoint::Writer writer{path};
+        solver->save(writer);
+        writer.close();
+    }
+    for(auto _ : state){
+        checkpoint::Reader reader{path};
+        solver->restore(reader);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * particles->size() * SeparateFieldMemoryLayout2D::Width));
+}
+
+BENCHMARK_REGISTER_F(CheckpointFixture, serialise)->RangeMultiplier(8)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(CheckpointFixture, save)->RangeMultiplier(8)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(CheckpointFixture, restore)->RangeMultiplier(8)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "solver2d.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <random>
+#include <memory>
+
+// cost of collision statistics in the narrow phase loop: the legacy per particle update of
+// the shared CollisionStats window vs a stack local CollisionCounter merged once per step vs nothing
+class CollisionStatsFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        const auto N = static_cast<size_t>(state.range(0));
+        memory.resize(SeparateFieldMemoryLayout2D::allocationSize(N));
+        particles = createSeparateFieldParticle2DPtr(memory);
+
+        std::default_random_engine engine{ (1 << 20) };
+        std::uniform_real_distribution<float> dist{0.2f, 19.8f};
+        for(auto i = 0; i < N; i++){
+            particles->add({dist(engine), dist(engine)}, glm::vec2{0}, 1, radius, 0.5f);
+        }
+        grid = std::make_unique<UnBoundedSpacialHashGrid2D>(radius * 2, 20000);
+        grid->initialize(*particles, particles->size());
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        grid.reset();
+        particles.reset();
+    }
+
+    static int collide(glm::vec2 pa, glm::vec2 pb) {
+        constexpr auto rr2 = 0.2f * 0.2f;
+        auto dir = pb - pa;
+        auto dd = glm::dot(dir, dir);
+        return (dd == 0 || dd > rr2) ? 0 : 1;
+    }
+
+    template<typename Record>
+    void narrowPhase(Record&& record) {
+        const auto N = particles->size();
+        auto position = particles->position();
+        for(int i = 0; i < N; i++){
+            auto ids = grid->query(position[i], glm::vec2(radius * 2));
+            int collisions = 0;
+            for(int j : ids){
+                if(i == j) continue;
+                collisions += collide(position[i], position[j]);
+            }
+            record(collisions);
+        }
+    }
+
+    static constexpr float radius = 0.1f;
+    std::vector<char> memory;
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+    std::unique_ptr<UnBoundedSpacialHashGrid2D> grid;
+
+    struct LegacyCollisionStats {
+        std::array<int, 100> average{};
+        int max{0};
+        int min{0};
+        int next{0};
+        int total{0};
+    } legacyStats;
+
+    CollisionStats collisionStats;
+};
+
+BENCHMARK_DEFINE_F(CollisionStatsFixture, noStats)(benchmark::State& state) {
+    for(auto _ : state){
+        int sink = 0;
+        narrowPhase([&](int collisions){ sink |= collisions; });
+        benchmark::DoNotOptimize(sink);
+    }
+}
+
+BENCHMARK_DEFINE_F(CollisionStatsFixture, legacyPerParticleStats)(benchmark::State& state) {
+    for(auto _ : state){
+        narrowPhase([this](int collisions){
+            legacyStats.average[legacyStats.next++] = collisions;
+            legacyStats.max = glm::max(legacyStats.max, collisions);
+            legacyStats.min = glm::min(legacyStats.min, collisions);
+            legacyStats.next %= legacyStats.average.size();
+            legacyStats.total += collisions;
+        });
+        benchmark::DoNotOptimize(legacyStats);
+    }
+}
+
+BENCHMARK_DEFINE_F(CollisionStatsFixture, localCounterMergedPerStep)(benchmark::State& state) {
+    for(auto _ : state){
+        CollisionCounter counter{};
+        narrowPhase([&counter](int collisions){ counter.add(collisions); });
+        collisionStats.merge(counter);
+        benchmark::DoNotOptimize(collisionStats);
+    }
+}
+
+BENCHMARK_DEFINE_F(CollisionStatsFixture, verletSolverStep)(benchmark::State& state) {
+    VarletIntegrationSolver<SeparateFieldMemoryLayout> solver{particles, {glm::vec2(0), glm::vec2(20)}, radius, 8};
+    for(auto _ : state){
+        solver.solve(0.0166667f);
+    }
+    state.counters["collision_stats"] = CollisionStatsEnabled ? 1 : 0;
+}
+
+BENCHMARK_REGISTER_F(CollisionStatsFixture, noStats)->RangeMultiplier(4)->Range(1 << 10, 1 << 14);
+BENCHMARK_REGISTER_F(CollisionStatsFixture, legacyPerParticleStats)->RangeMultiplier(4)->Range(1 << 10, 1 << 14);
+BENCHMARK_REGISTER_F(CollisionStatsFixture, localCounterMergedPerStep)->RangeMultiplier(4)->Range(1 << 10, 1 << 14);
+BENCHMARK_REGISTER_F(CollisionStatsFixture, verletSolverStep)->RangeMultiplier(4)->Range(1 << 10, 1 << 14);
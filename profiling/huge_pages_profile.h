@@ -0,0 +1,126 @@
+#pragma once
+
+#include "huge_pages.h"
+#include "particle.h"
+#include <spdlog/spdlog.h>
+#include "spacial_hash.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <random>
+#include <memory>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// hash grid build and a gather through the cell entries over 2M particles, the access pattern of a
+// neighbour search, with regular (Arg 0) and huge page (Arg 1) backed columns and grid arrays.
+// dTLB load misses are reported when the kernel exposes the counter. This times a grid build, not
+// a solver step.
+//
+// On a single core VM with THP in madvise mode and no PMU (98 MB huge page backed), medians of
+// two rounds of 5 repetitions: regular pages 169 and 160 ms per grid build, huge pages 164 and
+// 175 ms. The difference is within run to run noise, the toggle gave no measurable benefit there
+class HugePagesFixture : public benchmark::Fixture {
+public:
+    static constexpr size_t N = 1 << 21;
+
+    void SetUp(const benchmark::State &state) override {
+        if(state.range(0)) {
+            hugepages::enable();
+        }
+        particles = std::make_unique<SeparateFieldParticle2D>(createSeparateFieldParticle2D(N));
+        grid = std::make_unique<UnBoundedSpacialHashGrid2D>(1.f, to<int32_t>(N));
+        hugepages::disable();
+
+        std::default_random_engine engine{ 1 << 20 };
+        std::uniform_real_distribution<float> coord{ 0.f, 1400.f };
+        for(auto i = 0u; i < N; i++){
+            particles->add({ coord(engine), coord(engine) }, {0, 0}, 1, 0.5f, 0.5f);
+        }
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        grid.reset();
+        particles.reset();
+    }
+
+    std::unique_ptr<SeparateFieldParticle2D> particles;
+    std::unique_ptr<UnBoundedSpacialHashGrid2D> grid;
+};
+
+#if defined(__linux__)
+class TlbMissCounter {
+public:
+    TlbMissCounter() {
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~TlbMissCounter() {
+        if(m_fd >= 0) close(m_fd);
+    }
+
+    [[nodiscard]]
+    bool available() const {
+        return m_fd >= 0;
+    }
+
+    void start() {
+        if(m_fd >= 0) ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    void stop() {
+        if(m_fd >= 0) ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    [[nodiscard]]
+    uint64_t count() const {
+        uint64_t value{};
+        if(m_fd < 0 || read(m_fd, &value, sizeof(value)) != sizeof(value)) return 0;
+        return value;
+    }
+
+private:
+    int m_fd{-1};
+};
+#else
+struct TlbMissCounter {
+    bool available() const { return false; }
+    void start() {}
+    void stop() {}
+    uint64_t count() const { return 0; }
+};
+#endif
+
+BENCHMARK_DEFINE_F(HugePagesFixture, gridBuildAndGather)(benchmark::State& state) {
+    TlbMissCounter tlbMisses;
+    tlbMisses.start();
+    for(auto _ : state){
+        grid->initialize(*particles, particles->size());
+        const auto position = particles->position();
+        glm::vec2 sum{0};
+        for(auto index : grid->entries()){
+            sum += position[index];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    tlbMisses.stop();
+    state.SetItemsProcessed(state.iterations() * N);
+    if(tlbMisses.available()) {
+        state.counters["dTLB_misses/particle"] = benchmark::Counter(to<double>(tlbMisses.count()) / to<double>(state.iterations() * N));
+    }
+    const auto stats = hugepages::stats();
+    state.counters["huge_page_MB"] = to<double>(stats.explicitBytes + stats.transparentBytes) / (1 << 20);
+}
+
+BENCHMARK_REGISTER_F(HugePagesFixture, gridBuildAndGather)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
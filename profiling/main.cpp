@@ -2,6 +2,17 @@
 //#include "sparse_vector_profile.h"
 //#include "multithreading_profile.h"
 #include "memory_access_profile.h"
+#include "collision_stats_profile.h"
+#include "checkpoint_profile.h"
+#include "serializer_profile.h"
+#include "volume_emitter_profile.h"
+#include "sdf_profile.h"
+#include "point_generator_profile.h"
+#include "particle_compaction_profile.h"
+#include "huge_pages_profile.h"
+#include "sph_kernel_profile.h"
+#include "sph_solver_profile.h"
+#include "sph_surface_profile.h"
 
 BENCHMARK_MAIN();
 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "particle.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <vector>
+
+// compacting 1M particles after killing a percentage of them, compared to copying every field of
+// every particle once (the cost of a single memory pass over the store)
+class ParticleCompactionFixture : public benchmark::Fixture {
+public:
+    static constexpr size_t N = 1 << 20;
+
+    void SetUp(const benchmark::State &state) override {
+        memory.resize(SeparateFieldMemoryLayout2D::allocationSize(N));
+        copy.resize(memory.size());
+        particles = createSeparateFieldParticle2D(memory);
+    }
+
+    void fill() {
+        particles.clear();
+        for(auto i = 0u; i < N; i++){
+            particles.add({ to<float>(i), 0 }, { 0, 1 }, 1, 0.5f, 0.5f);
+        }
+    }
+
+    std::vector<char> memory;
+    std::vector<char> copy;
+    SeparateFieldParticle2D particles;
+};
+
+BENCHMARK_DEFINE_F(ParticleCompactionFixture, compact)(benchmark::State& state) {
+    const auto percent = static_cast<size_t>(state.range(0));
+    for(auto _ : state){
+        state.PauseTiming();
+        fill();
+        particles.killIf([percent](size_t i){ return (i * 2654435761u) % 100 < percent; });
+        state.ResumeTiming();
+        auto remap = particles.compact();
+        benchmark::DoNotOptimize(remap.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_DEFINE_F(ParticleCompactionFixture, copyAllFields)(benchmark::State& state) {
+    for(auto _ : state){
+        std::memcpy(copy.data(), memory.data(), memory.size());
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_REGISTER_F(ParticleCompactionFixture, compact)->Arg(1)->Arg(10)->Arg(50)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(ParticleCompactionFixture, copyAllFields)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "point_generators.h"
+#include "types.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+
+// time to generate about N points over a square domain, lattices vs Poisson disk sampling
+template<typename Generator>
+void generatePoints(benchmark::State& state, Generator&& makeGenerator, float density) {
+    const Bounds2D bounds{ glm::vec2{0}, glm::vec2{100} };
+    const auto spacing = 100.f * density / std::sqrt(to<float>(state.range(0)));
+    size_t count = 0;
+    for(auto _ : state){
+        auto points = makeGenerator()->generate(bounds, spacing);
+        count = points.size();
+        benchmark::DoNotOptimize(points.data());
+    }
+    state.counters["points"] = to<double>(count);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Poisson disk points pack at roughly 0.7 points per spacing², spacing is scaled to match N
+static void gridPoints(benchmark::State& state) {
+    generatePoints(state, []{ return std::make_unique<GridPointGenerator2D>(); }, 1.f);
+}
+
+static void trianglePoints(benchmark::State& state) {
+    generatePoints(state, []{ return std::make_unique<TrianglePointGenerator>(); }, 1.f);
+}
+
+static void poissonDiskPoints(benchmark::State& state) {
+    generatePoints(state, []{ return std::make_unique<PoissonDiskPointGenerator2D>(1); }, 0.84f);
+}
+
+static void poissonDiskPointsUntiled(benchmark::State& state) {
+    generatePoints(state, []{ return std::make_unique<PoissonDiskPointGenerator2D>(1, 16, false); }, 0.84f);
+}
+
+BENCHMARK(gridPoints)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(trianglePoints)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(poissonDiskPoints)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(poissonDiskPointsUntiled)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "sdf_expression.h"
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <random>
+#include <vector>
+
+// signed distance of N points to a composite scene: a lambda stored in std::function called per
+// point vs the same scene as a csg expression evaluated in batches, statically and type erased
+class SdfFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        const auto N = static_cast<size_t>(state.range(0));
+        std::default_random_engine engine{ 1 << 20 };
+        std::uniform_real_distribution<float> dist{ 0.f, 20.f };
+        points.resize(N);
+        distance.resize(N);
+        for(auto& point : points){
+            point = { dist(engine), dist(engine) };
+        }
+    }
+
+    static auto scene() {
+        return csg::smoothUnion(csg::Plane{ 3.f }, csg::Circle{ {10, 18}, 1.5f }, 0.5f) - csg::Box{ {10, 2}, {1, 1} };
+    }
+
+    std::vector<glm::vec2> points;
+    std::vector<float> distance;
+};
+
+BENCHMARK_DEFINE_F(SdfFixture, stdFunctionPerPoint)(benchmark::State& state) {
+    std::function<float(const glm::vec2&)> sdf = [](const glm::vec2& point){
+        const auto d0 = point.y - 3.f;
+        const auto d1 = glm::length(point - glm::vec2{10, 18}) - 1.5f;
+        const auto h = glm::clamp(0.5f + 0.5f * (d1 - d0) / 0.5f, 0.f, 1.f);
+        const auto blend = d1 + (d0 - d1) * h - 0.5f * h * (1.f - h);
+        glm::vec2 local = point - glm::vec2{10, 2};
+        return glm::max(blend, -sdBox({1, 1}, local));
+    };
+    for(auto _ : state){
+        for(auto i = 0u; i < points.size(); i++){
+            distance[i] = sdf(points[i]);
+        }
+        benchmark::DoNotOptimize(distance.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(SdfFixture, expressionBatch)(benchmark::State& state) {
+    const auto shape = scene();
+    for(auto _ : state){
+        csg::evaluate(shape, points, distance);
+        benchmark::DoNotOptimize(distance.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(SdfFixture, typeErasedBatch)(benchmark::State& state) {
+    const csg::Sdf shape{ scene() };
+    for(auto _ : state){
+        shape.evaluate(points, distance);
+        benchmark::DoNotOptimize(distance.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(SdfFixture, stdFunctionPerPoint)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+BENCHMARK_REGISTER_F(SdfFixture, expressionBatch)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
+BENCHMARK_REGISTER_F(SdfFixture, typeErasedBatch)->RangeMultiplier(8)->Range(1 << 12, 1 << 18);
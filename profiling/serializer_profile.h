@@ -0,0 +1,92 @@
+#pragma once
+
+#include "serializer.h"
+#include "json_serializer.h"
+#include "binary_serializer.h"
+#include "particle.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <random>
+#include <memory>
+
+// legacy std::any snapshot (built per call, as Snap implementations have to) against the typed
+// snapshot visitors reading the particle fields in place
+class SerializerFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        const auto N = static_cast<size_t>(state.range(0));
+        memory.resize(SeparateFieldMemoryLayout2D::allocationSize(N));
+        particles = createSeparateFieldParticle2DPtr(memory);
+
+        std::default_random_engine engine{ (1 << 20) };
+        std::uniform_real_distribution<float> dist{0.2f, 19.8f};
+        for(auto i = 0; i < N; i++){
+            particles->add({dist(engine), dist(engine)}, {dist(engine), dist(engine)}, 1, 0.1f, 0.5f);
+        }
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        particles.reset();
+    }
+
+    Snap::Snapshot legacySnapshot() const {
+        const auto N = particles->size();
+        Snap::Sequence<float> position, previousPosition, velocity, inverseMass, restitution, radius;
+        for(auto i = 0; i < N; i++){
+            position.push_back(particles->position()[i].x);
+            position.push_back(particles->position()[i].y);
+            previousPosition.push_back(particles->previousPosition()[i].x);
+            previousPosition.push_back(particles->previousPosition()[i].y);
+            velocity.push_back(particles->velocity()[i].x);
+            velocity.push_back(particles->velocity()[i].y);
+            inverseMass.push_back(particles->inverseMass()[i]);
+            restitution.push_back(particles->restitution()[i]);
+            radius.push_back(particles->radius()[i]);
+        }
+        Snap::Snapshot snapshot{};
+        snapshot["size"] = N;
+        snapshot["position"] = position;
+        snapshot["previousPosition"] = previousPosition;
+        snapshot["velocity"] = velocity;
+        snapshot["inverseMass"] = inverseMass;
+        snapshot["restitution"] = restitution;
+        snapshot["radius"] = radius;
+        return snapshot;
+    }
+
+    std::vector<char> memory;
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+};
+
+BENCHMARK_DEFINE_F(SerializerFixture, legacyAnyYaml)(benchmark::State& state) {
+    for(auto _ : state){
+        auto yaml = yaml::serialize(legacySnapshot());
+        benchmark::DoNotOptimize(yaml.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(SerializerFixture, typedYaml)(benchmark::State& state) {
+    for(auto _ : state){
+        auto yaml = yaml::serialize(*particles);
+        benchmark::DoNotOptimize(yaml.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(SerializerFixture, typedJson)(benchmark::State& state) {
+    for(auto _ : state){
+        auto json = json::serialize(*particles);
+        benchmark::DoNotOptimize(json.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(SerializerFixture, typedBinary)(benchmark::State& state) {
+    for(auto _ : state){
+        auto bytes = binary::serialize(*particles);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+}
+
+BENCHMARK_REGISTER_F(SerializerFixture, legacyAnyYaml)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SerializerFixture, typedYaml)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SerializerFixture, typedJson)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SerializerFixture, typedBinary)->RangeMultiplier(8)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "sph/sph.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+// density, pressure and viscosity sums over precomputed neighbour lists: the previous path
+// (std::function kernels, one distance per kernel and a pass per term) against a kernel policy
+// evaluated in a single pass sharing one distance per pair, and the policy tabulated at a few sizes
+class SphKernelFixture : public benchmark::Fixture {
+public:
+    static constexpr int N = 1 << 14;
+    static constexpr int NumNeighbours = 24;
+    static constexpr float h = 0.4f;
+
+    void SetUp(const benchmark::State &state) override {
+        std::default_random_engine engine{ 1 << 12 };
+        std::uniform_real_distribution<float> offset{ -h, h };
+        std::uniform_int_distribution<int> index{ 0, N - 1 };
+        position.resize(N);
+        velocity.resize(N);
+        density.resize(N);
+        forces.resize(N);
+        neighbours.resize(N * NumNeighbours);
+        for(auto i = 0; i < N; i++){
+            position[i] = { offset(engine) * 20, offset(engine) * 20 };
+            velocity[i] = { offset(engine), offset(engine) };
+            density[i] = 1 + offset(engine);
+        }
+        // neighbours are placed around each particle so most pairs fall inside the support
+        for(auto i = 0; i < N; i++){
+            for(auto n = 0; n < NumNeighbours; n++){
+                auto j = index(engine);
+                position[j] = position[i] + glm::vec2{ offset(engine), offset(engine) } * 0.9f;
+                neighbours[i * NumNeighbours + n] = j;
+            }
+        }
+    }
+
+    std::vector<glm::vec2> position;
+    std::vector<glm::vec2> velocity;
+    std::vector<float> density;
+    std::vector<glm::vec2> forces;
+    std::vector<int> neighbours;
+};
+
+BENCHMARK_DEFINE_F(SphKernelFixture, stdFunctionKernels)(benchmark::State& state) {
+    Kernel2D kernel{};
+    std::function<float(glm::vec2)> W = kernel(h);
+    std::function<glm::vec2(glm::vec2)> dW = kernel.gradient(h);
+    std::function<float(glm::vec2)> ddW = kernel.laplacian(h);
+    for(auto _ : state){
+        for(auto i = 0; i < N; i++){
+            const auto xi = position[i];
+            const auto di = density[i];
+            float weight = 0;
+            glm::vec2 pressure{}, viscous{};
+            for(auto n = 0; n < NumNeighbours; n++){
+                weight += W(xi - position[neighbours[i * NumNeighbours + n]]);
+            }
+            for(auto n = 0; n < NumNeighbours; n++){
+                const auto j = neighbours[i * NumNeighbours + n];
+                pressure += (1/density[j]) * (di + density[j]) * dW(xi - position[j]) * 0.5f;
+            }
+            for(auto n = 0; n < NumNeighbours; n++){
+                const auto j = neighbours[i * NumNeighbours + n];
+                viscous += (1/density[j]) * (velocity[j] - velocity[i]) * ddW(xi - position[j]);
+            }
+            forces[i] = pressure + viscous + weight;
+        }
+        benchmark::DoNotOptimize(forces.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N * NumNeighbours);
+}
+
+template<typename Kernel>
+void evaluateForces(SphKernelFixture& fixture, const Kernel& kernel) {
+    constexpr auto N = SphKernelFixture::N;
+    constexpr auto NumNeighbours = SphKernelFixture::NumNeighbours;
+    for(auto i = 0; i < N; i++){
+        const auto xi = fixture.position[i];
+        const auto di = fixture.density[i];
+        float weight = 0;
+        glm::vec2 pressure{}, viscous{};
+        for(auto n = 0; n < NumNeighbours; n++){
+            const auto j = fixture.neighbours[i * NumNeighbours + n];
+            const KernelPair<2> pair{ xi - fixture.position[j] };
+            const auto dj = fixture.density[j];
+            weight += kernel.W(pair);
+            pressure += (1/dj) * (di + dj) * kernel.dW(pair) * 0.5f;
+            viscous += (1/dj) * (fixture.velocity[j] - fixture.velocity[i]) * kernel.ddW(pair);
+        }
+        fixture.forces[i] = pressure + viscous + weight;
+    }
+}
+
+template<typename Kernel>
+void policyKernels(benchmark::State& state, SphKernelFixture& fixture) {
+    const Kernel kernel{ SphKernelFixture::h };
+    for(auto _ : state){
+        evaluateForces(fixture, kernel);
+        benchmark::DoNotOptimize(fixture.forces.data());
+    }
+    state.SetItemsProcessed(state.iterations() * SphKernelFixture::N * SphKernelFixture::NumNeighbours);
+}
+
+// the accuracy side of the tabulated kernels: largest force difference to the evaluated Muller
+// kernels relative to the largest force, reported as the error counter next to the timing
+template<size_t Samples>
+void tabulatedKernels(benchmark::State& state, SphKernelFixture& fixture) {
+    evaluateForces(fixture, MullerKernel2D{ SphKernelFixture::h });
+    const auto reference = fixture.forces;
+
+    policyKernels<TabulatedKernel<2, MullerKernel2D, Samples>>(state, fixture);
+
+    float maxForce = 0;
+    float maxError = 0;
+    for(auto i = 0u; i < reference.size(); i++){
+        maxForce = std::max(maxForce, glm::length(reference[i]));
+        maxError = std::max(maxError, glm::length(reference[i] - fixture.forces[i]));
+    }
+    state.counters["error"] = maxError / maxForce;
+}
+
+BENCHMARK_DEFINE_F(SphKernelFixture, mullerKernelPolicy)(benchmark::State& state) {
+    policyKernels<MullerKernel2D>(state, *this);
+}
+
+BENCHMARK_DEFINE_F(SphKernelFixture, cubicSplineKernelPolicy)(benchmark::State& state) {
+    policyKernels<CubicSplineKernel2D>(state, *this);
+}
+
+BENCHMARK_DEFINE_F(SphKernelFixture, tabulatedKernel64)(benchmark::State& state) {
+    tabulatedKernels<64>(state, *this);
+}
+
+BENCHMARK_DEFINE_F(SphKernelFixture, tabulatedKernel256)(benchmark::State& state) {
+    tabulatedKernels<256>(state, *this);
+}
+
+BENCHMARK_DEFINE_F(SphKernelFixture, tabulatedKernel1024)(benchmark::State& state) {
+    tabulatedKernels<1024>(state, *this);
+}
+
+BENCHMARK_REGISTER_F(SphKernelFixture, stdFunctionKernels)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SphKernelFixture, mullerKernelPolicy)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SphKernelFixture, cubicSplineKernelPolicy)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SphKernelFixture, tabulatedKernel64)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SphKernelFixture, tabulatedKernel256)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(SphKernelFixture, tabulatedKernel1024)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+#include "sph/sph_solver.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// one sph sub step (bounds, grid, forces, integrate) of a 500k particle block against the number of
+// threads the solver splits each pass over, the speed up is the ratio of the wall times.
+// The force pass alone is timed per particle and over unordered pairs (second argument 1)
+class SphSolverFixture : public benchmark::Fixture {
+public:
+    static constexpr int Side = 708;
+    static constexpr size_t N = Side * Side;
+    static constexpr float Radius = 0.1f;
+
+    void SetUp(const benchmark::State &state) override {
+        particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(N));
+        for(auto i = 0u; i < N; i++){
+            glm::vec2 position{ 1 + to<float>(i % Side) * 2 * Radius, 1 + to<float>(i / Side) * 2 * Radius };
+            particles->add(position, glm::vec2{0}, 1, Radius, 0.5f);
+        }
+        const Bounds2D bounds{ glm::vec2(0), glm::vec2(2 + Side * 2 * Radius) };
+        solver = std::make_unique<SphSolver2D<SeparateFieldMemoryLayout>>(
+                2 * Radius, Radius, 20.f, 0.99f, 10.f, 1.f, N, particles, bounds, 1, to<uint32_t>(state.range(0)));
+        solver->subStep(TimeStep);
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        solver.reset();
+        particles.reset();
+    }
+
+    static constexpr float TimeStep = 1.0f / 120.f;
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+    std::unique_ptr<SphSolver2D<SeparateFieldMemoryLayout>> solver;
+};
+
+BENCHMARK_DEFINE_F(SphSolverFixture, subStep)(benchmark::State& state) {
+    for(auto _ : state){
+        solver->subStep(TimeStep);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_REGISTER_F(SphSolverFixture, subStep)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(SphSolverFixture, forces)(benchmark::State& state) {
+    const auto symmetric = state.range(1) != 0;
+    for(auto _ : state){
+        if(symmetric) {
+            solver->computeSymmetricForces(N);
+        } else {
+            solver->computeForces(N);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_REGISTER_F(SphSolverFixture, forces)->ArgsProduct({{1, 4, 16}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// the 3D dam break, one sub step of a 48 x 48 x 48 block (110k particles) against the number of threads
+class SphSolver3DFixture : public benchmark::Fixture {
+public:
+    static constexpr int Side = 48;
+    static constexpr size_t N = Side * Side * Side;
+    static constexpr float Radius = 0.1f;
+
+    void SetUp(const benchmark::State &state) override {
+        memory.resize(SeparateFieldMemoryLayout3D::allocationSize(N));
+        particles = createSeparateFieldParticle3DPtr(memory);
+        for(auto i = 0u; i < N; i++){
+            glm::vec3 position{ 1 + to<float>(i % Side) * 2 * Radius, 1 + to<float>(i / (Side * Side)) * 2 * Radius, 1 + to<float>(i / Side % Side) * 2 * Radius };
+            particles->add(position, glm::vec3{0}, 1, Radius, 0.5f);
+        }
+        // twice as wide as the block so it collapses along x
+        const Bounds<3> bounds{ glm::vec3(0), glm::vec3(2 + Side * 4 * Radius, 2 + Side * 2 * Radius, 2 + Side * 2 * Radius) };
+        solver = std::make_unique<SphSolver3D<SeparateFieldMemoryLayout>>(
+                2 * Radius, Radius, 20.f, 0.99f, 10.f, 1.f, N, particles, bounds, 1, to<uint32_t>(state.range(0)));
+        solver->subStep(TimeStep);
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        solver.reset();
+        particles.reset();
+    }
+
+    static constexpr float TimeStep = 1.0f / 120.f;
+    std::vector<char> memory;
+    std::shared_ptr<SeparateFieldParticle3D> particles;
+    std::unique_ptr<SphSolver3D<SeparateFieldMemoryLayout>> solver;
+};
+
+BENCHMARK_DEFINE_F(SphSolver3DFixture, subStep)(benchmark::State& state) {
+    for(auto _ : state){
+        solver->subStep(TimeStep);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_REGISTER_F(SphSolver3DFixture, subStep)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
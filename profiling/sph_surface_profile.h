@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sph/sph_surface.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+
+// surface of a 200k particle block, the grid cell is the particle radius times the second argument
+// over 2 (half, one or two radii) against the number of threads. 60 Hz leaves 16.7 ms per frame
+class SphSurfaceFixture : public benchmark::Fixture {
+public:
+    static constexpr int Side = 448;
+    static constexpr size_t N = Side * Side;
+    static constexpr float Radius = 0.1f;
+
+    void SetUp(const benchmark::State &state) override {
+        particles = std::make_shared<SeparateFieldParticle2D>(createSeparateFieldParticle2D(N));
+        for(auto i = 0u; i < N; i++){
+            glm::vec2 position{ 1 + to<float>(i % Side) * 2 * Radius, 1 + to<float>(i / Side) * 2 * Radius };
+            particles->add(position, glm::vec2{0}, 1, Radius, 0.5f);
+        }
+        // the block fills the lower left quarter of the box
+        const Bounds2D bounds{ glm::vec2(0), glm::vec2(2 + Side * 4 * Radius) };
+        const auto cellSize = Radius * to<float>(state.range(1)) / 2;
+        threadPool = state.range(0) > 1 ? std::make_unique<tp::ThreadPool>(to<uint32_t>(state.range(0))) : nullptr;
+        extractor = std::make_unique<SurfaceExtractor2D<>>(bounds, cellSize, 2 * Radius, Radius, N, 0.5f, threadPool.get());
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        extractor.reset();
+        threadPool.reset();
+        particles.reset();
+    }
+
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+    std::unique_ptr<tp::ThreadPool> threadPool;
+    std::unique_ptr<SurfaceExtractor2D<>> extractor;
+};
+
+BENCHMARK_DEFINE_F(SphSurfaceFixture, extract)(benchmark::State& state) {
+    for(auto _ : state){
+        benchmark::DoNotOptimize(extractor->extract(*particles).points.data());
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK_REGISTER_F(SphSurfaceFixture, extract)->ArgsProduct({{1, 4, 16}, {1, 2, 4}})->UseRealTime()->Unit(benchmark::kMillisecond);
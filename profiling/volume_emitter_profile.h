@@ -0,0 +1,69 @@
+#pragma once
+
+#include "volume_emitter_2d.h"
+#include "point_generators.h"
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <cmath>
+#include <memory>
+
+// initial fill of a circle with N grid points: the legacy path (std::function callback per
+// generated point, push_back, std::function SDF and add per point) vs the row parallel generator
+// with the SDF filter and insertion fused into one pass
+class VolumeEmitterFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &state) override {
+        const auto N = static_cast<size_t>(state.range(0));
+        spacing = (bounds.upper.x - bounds.lower.x) / std::sqrt(to<float>(N));
+        memory.resize(SeparateFieldMemoryLayout2D::allocationSize(N + N / 4));
+        particles = createSeparateFieldParticle2DPtr(memory);
+    }
+
+    void TearDown(const benchmark::State &state) override {
+        particles.reset();
+    }
+
+    static float circle(const glm::vec2& point) {
+        return glm::length(point - glm::vec2{50}) - 40.f;
+    }
+
+    Bounds2D bounds{ glm::vec2{0}, glm::vec2{100} };
+    float spacing{};
+    std::vector<char> memory;
+    std::shared_ptr<SeparateFieldParticle2D> particles;
+};
+
+BENCHMARK_DEFINE_F(VolumeEmitterFixture, legacyPerPointFill)(benchmark::State& state) {
+    GridPointGenerator2D generator{};
+    std::function<float(const glm::vec2&)> sdf = circle;
+    for(auto _ : state){
+        particles->clear();
+        std::vector<glm::vec2> points;
+        generator.forEachPoint(bounds, spacing, [&points](const glm::vec2& point){
+            points.push_back(point);
+            return true;
+        });
+        for(const auto& point : points){
+            if(sdf(point) < 0){
+                particles->add(point, glm::vec2{0}, 1, spacing * 0.5f, 0.5f);
+            }
+        }
+        benchmark::DoNotOptimize(particles->size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_DEFINE_F(VolumeEmitterFixture, fusedBatchFill)(benchmark::State& state) {
+    std::function<float(const glm::vec2&)> sdf = circle;
+    for(auto _ : state){
+        particles->clear();
+        VolumeEmitter2D<SeparateFieldMemoryLayout> emitter{ sdf, std::make_unique<GridPointGenerator2D>(), bounds, spacing };
+        emitter.set(particles);
+        emitter.update(0.01f);
+        benchmark::DoNotOptimize(particles->size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_REGISTER_F(VolumeEmitterFixture, legacyPerPointFill)->RangeMultiplier(4)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(VolumeEmitterFixture, fusedBatchFill)->RangeMultiplier(4)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);